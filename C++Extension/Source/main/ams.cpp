@@ -129,6 +129,33 @@ void AMS::c_inspect_element_dest(VALUE v_item, VALUE v_dest_str) {
 	}
 }
 
+void AMS::c_report_thread_hive(ThreadHive* hive, void* user_data) {
+	// Called while the hive registry is locked, so Ruby objects, which may raise, are created afterwards
+	ThreadHiveReportQuery* query = reinterpret_cast<ThreadHiveReportQuery*>(user_data);
+	query->m_reports.push_back(ThreadHiveReport());
+	ThreadHiveReport& report = query->m_reports.back();
+	report.m_mode = hive->get_mode();
+	report.m_num_queued = hive->get_num_tasks();
+	report.m_num_bees = hive->get_num_bees();
+	report.m_num_live_bees = hive->get_num_live_bees();
+	report.m_stats.resize(hive->get_max_bees() + 1);
+	for (unsigned int i = 0; i <= hive->get_max_bees(); ++i)
+		hive->get_stats(i, report.m_stats[i]);
+	if (query->m_reset)
+		hive->reset_stats();
+}
+
+VALUE AMS::c_thread_hive_stats_to_value(const ThreadHive::Stats& stats) {
+	VALUE v_stats = rb_hash_new();
+	rb_hash_aset(v_stats, RU::to_value("num_tasks"), RU::to_value(stats.m_num_tasks));
+	rb_hash_aset(v_stats, RU::to_value("num_steals"), RU::to_value(stats.m_num_steals));
+	rb_hash_aset(v_stats, RU::to_value("busy_time"), RU::to_value(stats.m_busy_time));
+	rb_hash_aset(v_stats, RU::to_value("idle_time"), RU::to_value(stats.m_idle_time));
+	rb_hash_aset(v_stats, RU::to_value("queue_time"), RU::to_value(stats.m_queue_time));
+	rb_hash_aset(v_stats, RU::to_value("max_task_time"), RU::to_value(stats.m_max_task_time));
+	return v_stats;
+}
+
 
 /*
  ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -390,6 +417,36 @@ VALUE AMS::rbf_get_top_entity_by_id(VALUE self, VALUE v_id) {
 	return Qnil;
 }
 
+VALUE AMS::rbf_get_thread_hive_stats(int argc, VALUE* argv, VALUE self) {
+	ThreadHiveReportQuery query;
+	if (argc == 1)
+		query.m_reset = RU::value_to_bool(argv[0]);
+	else if (argc == 0)
+		query.m_reset = false;
+	else
+		rb_raise(rb_eArgError, "Wrong number of arguments! Expected 0..1 arguments.");
+
+	ThreadHive::for_each_hive(&c_report_thread_hive, &query);
+
+	VALUE v_reports = rb_ary_new2((long)query.m_reports.size());
+	for (unsigned int i = 0; i < query.m_reports.size(); ++i) {
+		const ThreadHiveReport& report = query.m_reports[i];
+		unsigned int num_bees = (unsigned int)report.m_stats.size() - 1;
+		VALUE v_bees = rb_ary_new2(num_bees);
+		for (unsigned int j = 0; j < num_bees; ++j)
+			rb_ary_push(v_bees, c_thread_hive_stats_to_value(report.m_stats[j]));
+		VALUE v_report = rb_hash_new();
+		rb_hash_aset(v_report, RU::to_value("mode"), RU::to_value(report.m_mode == ThreadHive::MODE_WORK_STEALING ? "work_stealing" : "shared_queue"));
+		rb_hash_aset(v_report, RU::to_value("num_bees"), RU::to_value(report.m_num_bees));
+		rb_hash_aset(v_report, RU::to_value("num_live_bees"), RU::to_value(report.m_num_live_bees));
+		rb_hash_aset(v_report, RU::to_value("num_queued"), RU::to_value(report.m_num_queued));
+		rb_hash_aset(v_report, RU::to_value("bees"), v_bees);
+		rb_hash_aset(v_report, RU::to_value("outside"), c_thread_hive_stats_to_value(report.m_stats[num_bees]));
+		rb_ary_push(v_reports, v_report);
+	}
+	return v_reports;
+}
+
 
 /*
  ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -415,6 +472,7 @@ void AMS::init_ruby(VALUE mAMS) {
 	rb_define_module_function(mAMS, "is_boolean?", VALUEFUNC(AMS::rbf_is_boolean), 1);
 	rb_define_module_function(mAMS, "get_entity_by_id", VALUEFUNC(AMS::rbf_get_entity_by_id), 1);
 	rb_define_module_function(mAMS, "get_top_entity_by_id", VALUEFUNC(AMS::rbf_get_top_entity_by_id), 1);
+	rb_define_module_function(mAMS, "get_thread_hive_stats", VALUEFUNC(AMS::rbf_get_thread_hive_stats), -1);
 
 	AMS::Geometry::init_ruby(mAMS);
 	AMS::Group::init_ruby(mAMS);
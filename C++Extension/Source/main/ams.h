@@ -11,6 +11,7 @@
 
 #include "../utils/ruby_util.h"
 
+#include <algorithm>
 #include <vector>
 #include <set>
 #include <map>
@@ -23,12 +24,28 @@ namespace AMS {
     class MultiLineText;
     class Translate;
 
+    // Structures
+    struct ThreadHiveReport {
+        ThreadHive::Mode m_mode;
+        unsigned int m_num_bees;
+        unsigned int m_num_live_bees;
+        unsigned int m_num_queued;
+        std::vector<ThreadHive::Stats> m_stats; // one per bee slot, followed by the threads outside the hive
+    };
+
+    struct ThreadHiveReportQuery {
+        std::vector<ThreadHiveReport> m_reports;
+        bool m_reset;
+    };
+
     // Variables
     extern double E_VALUES[];
 
     // Helper Functions
     VALUE c_inspect_element(VALUE v_item);
     void c_inspect_element_dest(VALUE v_item, VALUE v_dest_str);
+    void c_report_thread_hive(ThreadHive* hive, void* user_data);
+    VALUE c_thread_hive_stats_to_value(const ThreadHive::Stats& stats);
 
     // Ruby Functions
     VALUE rbf_inspect_element(VALUE self, VALUE v_item);
@@ -45,6 +62,7 @@ namespace AMS {
     VALUE rbf_is_boolean(VALUE self, VALUE v_object);
     VALUE rbf_get_entity_by_id(VALUE self, VALUE v_id);
     VALUE rbf_get_top_entity_by_id(VALUE self, VALUE v_id);
+    VALUE rbf_get_thread_hive_stats(int argc, VALUE* argv, VALUE self);
 
     // Main
     void init_ruby(VALUE mAMS);
@@ -275,9 +275,9 @@ VALUE AMS::Geometry::rbf_sort_polygon_points(VALUE self, VALUE v_points) {
     VALUE v_mesh, v_pt1, v_pt2, v_pt3;
     Geom::Vector3d pt1, pt2, pt3, v1, v1r, v2, normal, xaxis, yaxis;
     Geom::Vector3d center(0.0);
-    Geom::Vector3d* points;
+    SmallVector<Geom::Vector3d, 16> points;
+    SmallVector<std::pair<double, unsigned int>, 16> sorted_points; // angle and index of every point
     double scale, x, y, theta;
-    std::map<double, unsigned int> sorted_points;
     VALUE v_sorted_points;
     // Validate
     if (TYPE(v_points) != T_ARRAY)
@@ -317,7 +317,7 @@ VALUE AMS::Geometry::rbf_sort_polygon_points(VALUE self, VALUE v_points) {
     normal = v1.cross(v2);
     normal.normalize_self();
     // Step 3: Convert all points to C++ and compute center
-    points = new Geom::Vector3d[size];
+    points.resize(size);
     scale = 1.0 / static_cast<double>(size);
     for (i = 0; i < size; ++i) {
         v_pt3 = rb_funcall(v_mesh, RU::INTERN_POINT_AT, 1, INT2FIX(i + 1));
@@ -342,18 +342,17 @@ VALUE AMS::Geometry::rbf_sort_polygon_points(VALUE self, VALUE v_points) {
             theta = acos(Geom::clamp_double(x / sqrt(scale), -1.0, 1.0));
             if (y < 0.0)
                 theta = -theta;
-            sorted_points[theta] = i;
+            sorted_points.append(std::pair<double, unsigned int>(theta, i));
         }
     }
-    // Discard of points
-    delete[] points;
-    // Step 6: Return sorted points
+    // Step 6: Return sorted points; of the points at the same angle, only the last one is kept
+    std::sort(sorted_points.begin(), sorted_points.end());
     v_sorted_points = rb_ary_new2(static_cast<unsigned int>(sorted_points.size()));
-    i = 0;
-    for (std::map<double, unsigned int>::iterator it = sorted_points.begin(); it != sorted_points.end(); ++it) {
-        v_pt3 = rb_funcall(v_mesh, RU::INTERN_POINT_AT, 1, INT2FIX(it->second + 1));
-        rb_ary_store(v_sorted_points, i, v_pt3);
-        ++i;
+    for (i = 0; i < sorted_points.size(); ++i) {
+        if (i + 1 < sorted_points.size() && sorted_points[i + 1].first == sorted_points[i].first)
+            continue;
+        v_pt3 = rb_funcall(v_mesh, RU::INTERN_POINT_AT, 1, INT2FIX(sorted_points[i].second + 1));
+        rb_ary_push(v_sorted_points, v_pt3);
     }
     return v_sorted_points;
 }
@@ -760,10 +759,10 @@ VALUE AMS::Geometry::rbf_raytest1(int argc, VALUE* argv, VALUE self) {
     if (TYPE(v_ents) != T_ARRAY)
         rb_raise(rb_eTypeError, "Expected an array for the 'entities' parameter!");
 
-    std::map<VALUE, unsigned int> ents;
     unsigned int ents_size = (unsigned int)RARRAY_LEN(v_ents);
+    FlatHashSet<VALUE> ents(ents_size);
     for (unsigned int i = 0; i < ents_size; ++i)
-        ents[rb_ary_entry(v_ents, i)] = i;
+        ents.insert(rb_ary_entry(v_ents, i));
 
     VALUE v_active_model = rb_funcall(RU::SU_SKETCHUP, RU::INTERN_ACTIVE_MODEL, 0);
     while (true) {
@@ -772,7 +771,7 @@ VALUE AMS::Geometry::rbf_raytest1(int argc, VALUE* argv, VALUE self) {
         VALUE v_hit_ents = rb_ary_entry(v_hit, 1);
         unsigned int hit_ents_size = (unsigned int)RARRAY_LEN(v_hit_ents);
         for (unsigned int i = 0; i < hit_ents_size; ++i)
-            if (ents.find(rb_ary_entry(v_hit_ents, i)) != ents.end()) return v_hit;
+            if (ents.contains(rb_ary_entry(v_hit_ents, i))) return v_hit;
         v_point = rb_ary_entry(v_hit, 0);
     }
     return Qnil;
@@ -790,10 +789,10 @@ VALUE AMS::Geometry::rbf_raytest2(int argc, VALUE* argv, VALUE self) {
     if (TYPE(v_ents) != T_ARRAY)
         rb_raise(rb_eTypeError, "Expected an array for the 'entities' parameter!");
 
-    std::map<VALUE, unsigned int> ents;
     unsigned int ents_size = (unsigned int)RARRAY_LEN(v_ents);
+    FlatHashSet<VALUE> ents(ents_size);
     for (unsigned int i = 0; i < ents_size; ++i)
-        ents[rb_ary_entry(v_ents, i)] = i;
+        ents.insert(rb_ary_entry(v_ents, i));
 
     VALUE v_active_model = rb_funcall(RU::SU_SKETCHUP, RU::INTERN_ACTIVE_MODEL, 0);
     while (true) {
@@ -803,7 +802,7 @@ VALUE AMS::Geometry::rbf_raytest2(int argc, VALUE* argv, VALUE self) {
         unsigned int hit_ents_size = (unsigned int)RARRAY_LEN(v_hit_ents);
         bool found = false;
         for (unsigned int i = 0; i < hit_ents_size; ++i) {
-            if (ents.find(rb_ary_entry(v_hit_ents, i)) != ents.end()) {
+            if (ents.contains(rb_ary_entry(v_hit_ents, i))) {
                 found = true;
                 break;
             }
@@ -838,7 +837,7 @@ VALUE AMS::Geometry::rbf_raytest3(int argc, VALUE* argv, VALUE self) {
         for (int i = hit_ents_size - 2; i >= 0; --i) {
             VALUE v_inst = rb_ary_entry(v_hit_ents, i);
             RU::value_to_transformation(rb_funcall(v_inst, RU::INTERN_TRANSFORMATION, 0), inst_tra);
-            face_normal = inst_tra.rotate_vector(face_normal);
+            face_normal = inst_tra.transform_normal(face_normal);
             if (v_inst_mat == Qnil) v_inst_mat = rb_funcall(v_inst, RU::INTERN_MATERIAL, 0);
         }
         VALUE v_face_mat = rb_funcall(v_face, (vector.dot(face_normal) < 0.0) ? RU::INTERN_MATERIAL : RU::INTERN_BACK_MATERIAL, 0);
@@ -882,10 +881,10 @@ VALUE AMS::Geometry::rbf_deepray2(int argc, VALUE* argv, VALUE self) {
     if (TYPE(v_ents) != T_ARRAY)
         rb_raise(rb_eTypeError, "Expected an array for the 'entities' parameter!");
 
-    std::map<VALUE, unsigned int> ents;
     unsigned int ents_size = (unsigned int)RARRAY_LEN(v_ents);
+    FlatHashSet<VALUE> ents(ents_size);
     for (unsigned int i = 0; i < ents_size; ++i)
-        ents[rb_ary_entry(v_ents, i)] = i;
+        ents.insert(rb_ary_entry(v_ents, i));
 
     VALUE v_active_model = rb_funcall(RU::SU_SKETCHUP, RU::INTERN_ACTIVE_MODEL, 0);
     VALUE v_hits = rb_ary_new();
@@ -895,7 +894,7 @@ VALUE AMS::Geometry::rbf_deepray2(int argc, VALUE* argv, VALUE self) {
         VALUE v_hit_ents = rb_ary_entry(v_hit, 1);
         unsigned int hit_ents_size = (unsigned int)RARRAY_LEN(v_hit_ents);
         for (unsigned int i = 0; i < hit_ents_size; ++i) {
-            if (ents.find(rb_ary_entry(v_hit_ents, i)) != ents.end()) {
+            if (ents.contains(rb_ary_entry(v_hit_ents, i))) {
                 rb_ary_push(v_hits, v_hit);
                 break;
             }
@@ -917,10 +916,10 @@ VALUE AMS::Geometry::rbf_deepray3(int argc, VALUE* argv, VALUE self) {
     if (TYPE(v_ents) != T_ARRAY)
         rb_raise(rb_eTypeError, "Expected an array for the 'entities' parameter!");
 
-    std::map<VALUE, unsigned int> ents;
     unsigned int ents_size = (unsigned int)RARRAY_LEN(v_ents);
+    FlatHashSet<VALUE> ents(ents_size);
     for (unsigned int i = 0; i < ents_size; ++i)
-        ents[rb_ary_entry(v_ents, i)] = i;
+        ents.insert(rb_ary_entry(v_ents, i));
 
     VALUE v_active_model = rb_funcall(RU::SU_SKETCHUP, RU::INTERN_ACTIVE_MODEL, 0);
     VALUE v_hits = rb_ary_new();
@@ -931,7 +930,7 @@ VALUE AMS::Geometry::rbf_deepray3(int argc, VALUE* argv, VALUE self) {
         unsigned int hit_ents_size = (unsigned int)RARRAY_LEN(v_hit_ents);
         bool found = false;
         for (unsigned int i = 0; i < hit_ents_size; ++i) {
-            if (ents.find(rb_ary_entry(v_hit_ents, i)) != ents.end()) {
+            if (ents.contains(rb_ary_entry(v_hit_ents, i))) {
                 found = true;
                 break;
             }
@@ -298,14 +298,20 @@ void AMS::Group::c_get_triangular_mesh(VALUE self, VALUE v_entity, bool recurse,
     }
 }
 
-void AMS::Group::c_get_triangular_meshes(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, bool transformation_flipped, VALUE& v_meshes) {
-    std::map<VALUE, bool> faces;
+void AMS::Group::c_get_triangular_meshes(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, bool transformation_flipped, VALUE& v_meshes, Arena& arena, FlatHashSet<VALUE>& remaining_faces) {
+    // The faces of nested groups are released on return, so the faces of this level can grow in place afterwards
+    Arena::Scope arena_scope(arena);
+    DynamicArray<VALUE> faces(arena);
+    // All levels share the set of remaining faces: a nested level never holds faces of an enclosing one, as a
+    // definition cannot contain itself, and every level removes all of its faces before returning
+    size_t next_face = 0;
     VALUE v_entities = rbf_get_entities(self, v_entity);
     unsigned int entities_size = RU::value_to_uint(rb_funcall(v_entities, RU::INTERN_LENGTH, 0));
     for (unsigned int i = 0; i < entities_size; ++i) {
         VALUE v_sub_entity = rb_funcall(v_entities, RU::INTERN_AT, 1, INT2FIX(i));
         if (rb_obj_is_kind_of(v_sub_entity, RU::SU_FACE) == Qtrue) {
-            faces[v_sub_entity] = true;
+            if (remaining_faces.insert(v_sub_entity))
+                faces.append(v_sub_entity);
         }
         else if (recurse == true && (rb_obj_is_kind_of(v_sub_entity, RU::SU_GROUP) == Qtrue || rb_obj_is_kind_of(v_sub_entity, RU::SU_COMPONENT_INSTANCE) == Qtrue)) {
             if (rb_block_given_p() == 0 || RTEST(rb_yield(v_sub_entity)) == true) {
@@ -314,15 +320,16 @@ void AMS::Group::c_get_triangular_meshes(VALUE self, VALUE v_entity, bool recurs
                     v_new_transformation = rb_funcall(v_transformation, RU::INTERN_OP_ASTERISKS, 1, v_new_transformation);
                 Geom::Transformation new_parent_tra;
                 RU::value_to_transformation(v_new_transformation, new_parent_tra);
-                c_get_triangular_meshes(self, v_sub_entity, true, v_new_transformation, new_parent_tra.is_flipped(), v_meshes);
+                c_get_triangular_meshes(self, v_sub_entity, true, v_new_transformation, new_parent_tra.is_flipped(), v_meshes, arena, remaining_faces);
             }
         }
     }
     while(true) {
+        // Faces are only ever removed from the remaining ones, so the search can resume where it left off
         VALUE v_face = Qnil;
-        for (std::map<VALUE, bool>::iterator it = faces.begin(); it != faces.end(); ++it) {
-            if (it->second) {
-                v_face = it->first;
+        for (; next_face < faces.size(); ++next_face) {
+            if (remaining_faces.contains(faces[next_face])) {
+                v_face = faces[next_face];
                 break;
             }
         }
@@ -334,8 +341,7 @@ void AMS::Group::c_get_triangular_meshes(VALUE self, VALUE v_entity, bool recurs
         for (unsigned int i = 0; i < all_connected_size; ++i) {
             VALUE v_connected_item = rb_funcall(v_all_connected, RU::INTERN_AT, 1, INT2FIX(i));
             if (rb_obj_is_kind_of(v_connected_item, RU::SU_FACE) == Qtrue) {
-                std::map<VALUE, bool>::iterator it = faces.find(v_connected_item);
-                if (it != faces.end()) {
+                if (remaining_faces.erase(v_connected_item)) {
                     VALUE v_face_mesh = rb_funcall(v_connected_item, RU::INTERN_MESH, 0);
                     unsigned int number_of_polygons = RU::value_to_uint(rb_funcall(v_face_mesh, RU::INTERN_COUNT_POLYGONS, 0));
                     for (unsigned int j = 0; j < number_of_polygons; ++j) {
@@ -344,7 +350,6 @@ void AMS::Group::c_get_triangular_meshes(VALUE self, VALUE v_entity, bool recurs
                             rb_ary_reverse(v_triplet);
                         rb_funcall(v_mesh, RU::INTERN_ADD_POLYGON, 1, v_triplet);
                     }
-                    it->second = false;
                 }
             }
         }
@@ -354,6 +359,17 @@ void AMS::Group::c_get_triangular_meshes(VALUE self, VALUE v_entity, bool recurs
     }
 }
 
+VALUE AMS::Group::c_run_triangular_meshes_call(VALUE v_call) {
+    TriangularMeshesCall* call = reinterpret_cast<TriangularMeshesCall*>(v_call);
+    c_get_triangular_meshes(call->m_self, call->m_entity, call->m_recurse, call->m_transformation, call->m_transformation_flipped, call->m_meshes, call->m_arena, call->m_remaining_faces);
+    return call->m_meshes;
+}
+
+VALUE AMS::Group::c_free_triangular_meshes_call(VALUE v_call) {
+    delete reinterpret_cast<TriangularMeshesCall*>(v_call);
+    return Qnil;
+}
+
 void AMS::Group::c_calc_centre_of_mass(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, Geom::Vector3d& magnified_centre, double& total_darea) {
     // Declare variables
     Geom::Vector3d pt1, pt2, pt3, e0, e1;
@@ -798,9 +814,15 @@ VALUE AMS::Group::rbf_get_triangular_meshes(int argc, VALUE* argv, VALUE self) {
         RU::value_to_transformation(v_transformation, transformation);
         transformation_flipped = transformation.is_flipped();
     }
-    VALUE v_meshes = rb_ary_new();
-    c_get_triangular_meshes(self, argv[0], RTEST(v_recurse), v_transformation, transformation_flipped, v_meshes);
-    return v_meshes;
+    // A Ruby exception jumps past the destructors of locals, so the call state is on the heap and freed by rb_ensure
+    TriangularMeshesCall* call = new TriangularMeshesCall;
+    call->m_self = self;
+    call->m_entity = argv[0];
+    call->m_transformation = v_transformation;
+    call->m_meshes = rb_ary_new();
+    call->m_recurse = RTEST(v_recurse);
+    call->m_transformation_flipped = transformation_flipped;
+    return rb_ensure(RUBY_METHOD_FUNC(c_run_triangular_meshes_call), reinterpret_cast<VALUE>(call), RUBY_METHOD_FUNC(c_free_triangular_meshes_call), reinterpret_cast<VALUE>(call));
 }
 
 VALUE AMS::Group::rbf_calc_centre_of_mass(int argc, VALUE* argv, VALUE self) {
@@ -13,6 +13,21 @@
 
 class AMS::Group {
 private:
+    // Structures
+
+    // The state of one rbf_get_triangular_meshes call. It is freed through rb_ensure, so nothing leaks if a block or
+    // SketchUp raises, and each call, including one made from a block, has its own.
+    struct TriangularMeshesCall {
+        VALUE m_self;
+        VALUE m_entity;
+        VALUE m_transformation;
+        VALUE m_meshes;
+        bool m_recurse;
+        bool m_transformation_flipped;
+        Arena m_arena;
+        FlatHashSet<VALUE> m_remaining_faces;
+    };
+
     // Helper Functions
     static void c_get_bounding_box_from_edges(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, VALUE& v_bb);
     static void c_get_bounding_box_from_faces(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, VALUE& v_bb);
@@ -24,7 +39,9 @@ private:
     static void c_get_construction(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, VALUE& v_points);
     static void c_get_polygons_from_faces(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, bool transformation_flipped, VALUE& v_triplets);
     static void c_get_triangular_mesh(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, bool transformation_flipped, VALUE& v_mesh);
-    static void c_get_triangular_meshes(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, bool transformation_flipped, VALUE& v_meshes);
+    static void c_get_triangular_meshes(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, bool transformation_flipped, VALUE& v_meshes, Arena& arena, FlatHashSet<VALUE>& remaining_faces);
+    static VALUE c_run_triangular_meshes_call(VALUE v_call);
+    static VALUE c_free_triangular_meshes_call(VALUE v_call);
     static void c_calc_centre_of_mass(VALUE self, VALUE v_entity, bool recurse, VALUE v_transformation, Geom::Vector3d& magnified_centre, double& total_darea);
     static bool c_exclude_sub(VALUE self, VALUE v_entity, bool recurse);
     static VALUE c_split(VALUE self, VALUE v_entity, const Geom::Vector3d& point, const Geom::Vector3d& normal, VALUE v_context, bool recurse);
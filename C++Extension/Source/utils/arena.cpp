@@ -0,0 +1,144 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#include "arena.h"
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Constants
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+const size_t Arena::DEFAULT_BLOCK_SIZE = 64 * 1024;
+const size_t Arena::DEFAULT_ALIGNMENT = 16;
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Scope
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Arena::Scope::Scope(Arena& arena) :
+    m_arena(arena),
+    m_marker(arena.get_marker())
+{
+}
+
+Arena::Scope::~Scope() {
+    m_arena.rewind(m_marker);
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Arena
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Arena::Arena(size_t block_size) :
+    m_block(nullptr),
+    m_spare_blocks(nullptr),
+    m_position(nullptr),
+    m_block_size(block_size),
+    m_num_allocations(0)
+{
+}
+
+Arena::~Arena() {
+    release();
+}
+
+void Arena::add_block(size_t size, size_t alignment) {
+    Block* block;
+    size_t data_size = m_block_size;
+
+    // Give an oversized request a block of its own
+    if (size + alignment > data_size)
+        data_size = size + alignment;
+
+    // Reuse a spare block if the request fits
+    if (m_spare_blocks != nullptr && size + alignment <= static_cast<size_t>(m_spare_blocks->m_end - get_data(m_spare_blocks))) {
+        block = m_spare_blocks;
+        m_spare_blocks = block->m_prev;
+    }
+    else {
+        block = reinterpret_cast<Block*>(malloc(sizeof(Block) + data_size));
+        block->m_end = get_data(block) + data_size;
+    }
+
+    block->m_prev = m_block;
+    m_block = block;
+    m_position = get_data(block);
+}
+
+void* Arena::reallocate(void* ptr, size_t old_size, size_t new_size, size_t alignment) {
+    char* cptr = reinterpret_cast<char*>(ptr);
+    void* new_ptr;
+
+    // Resize the most recent allocation in place if it fits
+    if (cptr != nullptr && cptr + old_size == m_position && cptr + new_size <= m_block->m_end) {
+        m_position = cptr + new_size;
+        return ptr;
+    }
+
+    new_ptr = allocate(new_size, alignment);
+    if (cptr != nullptr)
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    return new_ptr;
+}
+
+void Arena::deallocate(void* ptr, size_t size) {
+    char* cptr = reinterpret_cast<char*>(ptr);
+    if (cptr != nullptr && cptr + size == m_position)
+        m_position = cptr;
+}
+
+void Arena::rewind(const Marker& marker) {
+    Block* block;
+
+    // Move the blocks allocated after the marker to the spares
+    while (m_block != marker.m_block) {
+        block = m_block;
+        m_block = block->m_prev;
+        block->m_prev = m_spare_blocks;
+        m_spare_blocks = block;
+    }
+
+    m_position = marker.m_position;
+}
+
+void Arena::reset() {
+    Marker marker = { nullptr, nullptr };
+    rewind(marker);
+}
+
+void Arena::release() {
+    Block* block;
+
+    reset();
+
+    while (m_spare_blocks != nullptr) {
+        block = m_spare_blocks;
+        m_spare_blocks = block->m_prev;
+        free(block);
+    }
+}
+
+size_t Arena::get_num_blocks() const {
+    size_t count = 0;
+    Block* block;
+
+    for (block = m_block; block != nullptr; block = block->m_prev)
+        ++count;
+    for (block = m_spare_blocks; block != nullptr; block = block->m_prev)
+        ++count;
+
+    return count;
+}
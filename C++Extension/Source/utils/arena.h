@@ -0,0 +1,127 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "common.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Hands out memory by bumping a position within large blocks, for temporary data that dies all at once, such as the
+// buffers of a single Ruby call. Memory is given back by rewinding to a marker, usually through a Scope, after which
+// the blocks are kept for reuse. Individual allocations are not freed, except for the most recent one.
+// Warning: not thread-safe.
+class Arena {
+private:
+    // Structures
+    struct Block {
+        Block* m_prev;
+        char* m_end;
+    };
+
+public:
+    // Constants
+    static const size_t DEFAULT_BLOCK_SIZE;
+    static const size_t DEFAULT_ALIGNMENT;
+
+    // Structures
+    struct Marker {
+        Block* m_block;
+        char* m_position;
+    };
+
+    // Rewinds the arena to where it was on construction, when going out of scope
+    class Scope {
+    private:
+        // Disable copy constructor and assignment operator
+        Scope(const Scope& other);
+        Scope& operator=(const Scope& other);
+
+        // Variables
+        Arena& m_arena;
+        Marker m_marker;
+
+    public:
+        Scope(Arena& arena);
+        ~Scope();
+    };
+
+private:
+    // Disable copy constructor and assignment operator
+    Arena(const Arena& other);
+    Arena& operator=(const Arena& other);
+
+    // Variables
+    Block* m_block; // current block; earlier ones are linked through m_prev
+    Block* m_spare_blocks; // blocks released by rewinding, kept for reuse
+    char* m_position;
+    size_t m_block_size;
+    size_t m_num_allocations;
+
+    // Helper Functions
+    void add_block(size_t size, size_t alignment);
+
+    static char* align(char* position, size_t alignment);
+    static char* get_data(Block* block);
+
+public:
+    Arena(size_t block_size = DEFAULT_BLOCK_SIZE);
+    virtual ~Arena();
+
+    // The alignment must be a power of two
+    void* allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT);
+
+    // Extends or shrinks the most recent allocation in place when possible; otherwise, allocates anew and copies
+    void* reallocate(void* ptr, size_t old_size, size_t new_size, size_t alignment = DEFAULT_ALIGNMENT);
+
+    // Only gives back the space of the most recent allocation
+    void deallocate(void* ptr, size_t size);
+
+    Marker get_marker() const;
+    void rewind(const Marker& marker);
+    void reset(); // rewinds everything, keeping the blocks
+    void release(); // rewinds everything and frees the blocks
+
+    size_t get_num_allocations() const; // since construction
+    size_t get_num_blocks() const; // in use and spare
+};
+
+
+// Define inline functions
+
+inline char* Arena::align(char* position, size_t alignment) {
+    return reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(position) + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+}
+
+inline char* Arena::get_data(Block* block) {
+    return reinterpret_cast<char*>(block + 1);
+}
+
+inline void* Arena::allocate(size_t size, size_t alignment) {
+    char* ptr = align(m_position, alignment);
+    ++m_num_allocations;
+    if (m_block == nullptr || ptr + size > m_block->m_end) {
+        add_block(size, alignment);
+        ptr = align(m_position, alignment);
+    }
+    m_position = ptr + size;
+    return ptr;
+}
+
+inline Arena::Marker Arena::get_marker() const {
+    Marker marker = { m_block, m_position };
+    return marker;
+}
+
+inline size_t Arena::get_num_allocations() const {
+    return m_num_allocations;
+}
+
+#endif  /* ARENA_H */
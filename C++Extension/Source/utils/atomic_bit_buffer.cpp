@@ -0,0 +1,73 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#include "atomic_bit_buffer.h"
+
+AtomicBitBuffer::AtomicBitBuffer(size_t init_cap) :
+    m_words(nullptr),
+    m_num_words(0)
+{
+    allocate(BitBuffer::words_for(init_cap));
+}
+
+AtomicBitBuffer::~AtomicBitBuffer() {
+    free(m_words);
+}
+
+void AtomicBitBuffer::allocate(size_t num_words) {
+    if (num_words == 0) num_words = 1;
+
+    free(m_words);
+    m_words = reinterpret_cast<std::atomic<uint64_t>*>(malloc(sizeof(std::atomic<uint64_t>) * num_words));
+    m_num_words = num_words;
+
+    // std::atomic<uint64_t> is trivially destructible, so there is nothing to destruct before freeing
+    for (size_t j = 0; j < m_num_words; ++j)
+        new (m_words + j) std::atomic<uint64_t>(0);
+}
+
+void AtomicBitBuffer::clear() {
+    for (size_t j = 0; j < m_num_words; ++j)
+        m_words[j].store(0, std::memory_order_relaxed);
+}
+
+void AtomicBitBuffer::resize(size_t bc) {
+    allocate(BitBuffer::words_for(bc));
+}
+
+size_t AtomicBitBuffer::popcount() const {
+    size_t count = 0;
+    for (size_t j = 0; j < m_num_words; ++j)
+        count += BitBuffer::word_count_bits(m_words[j].load(std::memory_order_relaxed));
+    return count;
+}
+
+size_t AtomicBitBuffer::find_next_set(size_t i) const {
+    size_t j = i / BitBuffer::WORD_BITS;
+    uint64_t word;
+
+    if (j >= m_num_words) return capacity();
+
+    // Ignore the bits before i in its word
+    word = m_words[j].load(std::memory_order_acquire) & ~(bit_mask(i) - 1);
+    while (word == 0) {
+        if (++j == m_num_words) return capacity();
+        word = m_words[j].load(std::memory_order_acquire);
+    }
+
+    return j * BitBuffer::WORD_BITS + BitBuffer::word_lowest_bit(word);
+}
+
+void AtomicBitBuffer::copy_to(BitBuffer& other) const {
+    if (other.m_num_words < m_num_words)
+        other.reallocate(m_num_words);
+    for (size_t j = 0; j < m_num_words; ++j)
+        other.m_words[j] = m_words[j].load(std::memory_order_relaxed);
+    if (other.m_num_words > m_num_words)
+        memset(other.m_words + m_num_words, 0, sizeof(uint64_t) * (other.m_num_words - m_num_words));
+}
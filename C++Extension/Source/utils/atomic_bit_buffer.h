@@ -0,0 +1,104 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef ATOMIC_BIT_BUFFER_H
+#define ATOMIC_BIT_BUFFER_H
+
+#include "common.h"
+#include "bit_buffer.h"
+
+#include <atomic>
+#include <cstdint>
+
+// A fixed set of bits that can be marked from several threads at once, such as the visited flags of a parallel graph
+// traversal. Each bit operation is a single atomic operation on its word, so threads claiming elements never take a
+// lock. The capacity is set on construction and is in bits. The per-bit functions do not perform boundary checks.
+// Warning: clear, resize, and copy_to must not run concurrently with other operations.
+class AtomicBitBuffer {
+private:
+    // Disable copy constructor and assignment operator
+    AtomicBitBuffer(const AtomicBitBuffer& other);
+    AtomicBitBuffer& operator=(const AtomicBitBuffer& other);
+
+    // Variables
+    std::atomic<uint64_t>* m_words;
+    size_t m_num_words;
+
+    // Helper Functions
+    void allocate(size_t num_words);
+
+    static uint64_t bit_mask(size_t i);
+
+public:
+    AtomicBitBuffer(size_t init_cap); // in bits
+    virtual ~AtomicBitBuffer();
+
+    size_t capacity() const; // in bits
+
+    bool get_at(size_t i) const;
+    void set_at(size_t i);
+    void unset_at(size_t i);
+
+    // Set or clear the bit, returning its previous state; exactly one of the threads racing to set a bit gets false.
+    bool test_and_set(size_t i);
+    bool test_and_unset(size_t i);
+
+    void clear();
+    void resize(size_t bc); // in bits; clears all bits
+
+    // Returns the number of set bits; only exact while no thread is modifying the buffer
+    size_t popcount() const;
+
+    // Return the index of the first set bit at or after i; capacity() if there is none
+    size_t find_next_set(size_t i) const;
+
+    // Copies the bits into a regular buffer, growing it as needed; its bits beyond this capacity are cleared
+    void copy_to(BitBuffer& other) const;
+};
+
+
+// Define inline functions
+
+inline uint64_t AtomicBitBuffer::bit_mask(size_t i) {
+    return 1ULL << (i % BitBuffer::WORD_BITS);
+}
+
+inline size_t AtomicBitBuffer::capacity() const {
+    return m_num_words * BitBuffer::WORD_BITS;
+}
+
+inline bool AtomicBitBuffer::get_at(size_t i) const {
+    return (m_words[i / BitBuffer::WORD_BITS].load(std::memory_order_acquire) & bit_mask(i)) != 0;
+}
+
+inline void AtomicBitBuffer::set_at(size_t i) {
+    m_words[i / BitBuffer::WORD_BITS].fetch_or(bit_mask(i), std::memory_order_release);
+}
+
+inline void AtomicBitBuffer::unset_at(size_t i) {
+    m_words[i / BitBuffer::WORD_BITS].fetch_and(~bit_mask(i), std::memory_order_release);
+}
+
+inline bool AtomicBitBuffer::test_and_set(size_t i) {
+    uint64_t mask = bit_mask(i);
+    std::atomic<uint64_t>& word = m_words[i / BitBuffer::WORD_BITS];
+    // A plain load first avoids taking the cache line exclusively when the bit is already set
+    if ((word.load(std::memory_order_relaxed) & mask) != 0)
+        return true;
+    return (word.fetch_or(mask, std::memory_order_acq_rel) & mask) != 0;
+}
+
+inline bool AtomicBitBuffer::test_and_unset(size_t i) {
+    uint64_t mask = bit_mask(i);
+    std::atomic<uint64_t>& word = m_words[i / BitBuffer::WORD_BITS];
+    if ((word.load(std::memory_order_relaxed) & mask) == 0)
+        return false;
+    return (word.fetch_and(~mask, std::memory_order_acq_rel) & mask) != 0;
+}
+
+#endif  /* ATOMIC_BIT_BUFFER_H */
@@ -9,92 +9,174 @@
 #include "bit_buffer.h"
 
 BitBuffer::BitBuffer() :
-    m_cap(1)
+    m_num_words(1)
 {
-    m_dat = (char*)malloc(sizeof(char) * m_cap);
-    memset(m_dat, 0, sizeof(char) * m_cap);
+    m_words = reinterpret_cast<uint64_t*>(calloc(m_num_words, sizeof(uint64_t)));
 }
 
 BitBuffer::BitBuffer(size_t init_cap) :
-    m_cap(init_cap)
+    m_num_words(words_for(init_cap))
 {
-    if (m_cap == 0) m_cap = 1;
-    m_dat = (char*)malloc(sizeof(char) * m_cap);
-    memset(m_dat, 0, sizeof(char) * m_cap);
+    if (m_num_words == 0) m_num_words = 1;
+    m_words = reinterpret_cast<uint64_t*>(calloc(m_num_words, sizeof(uint64_t)));
 }
 
 BitBuffer::BitBuffer(const BitBuffer& other) :
-    m_cap(other.m_cap)
+    m_num_words(other.m_num_words)
 {
-    m_dat = (char*)malloc(sizeof(char) * m_cap);
-    memcpy(m_dat, other.m_dat, sizeof(char) * m_cap);
+    m_words = reinterpret_cast<uint64_t*>(malloc(sizeof(uint64_t) * m_num_words));
+    memcpy(m_words, other.m_words, sizeof(uint64_t) * m_num_words);
 }
 
 BitBuffer& BitBuffer::operator=(const BitBuffer& other) {
     if (&other != this) {
-        free(m_dat);
-        m_cap = other.m_cap;
-        m_dat = (char*)malloc(sizeof(char) * m_cap);
-        memcpy(m_dat, other.m_dat, sizeof(char) * m_cap);
+        free(m_words);
+        m_num_words = other.m_num_words;
+        m_words = reinterpret_cast<uint64_t*>(malloc(sizeof(uint64_t) * m_num_words));
+        memcpy(m_words, other.m_words, sizeof(uint64_t) * m_num_words);
     }
     return *this;
 }
 
 BitBuffer::~BitBuffer() {
-    free(m_dat);
+    free(m_words);
 }
 
-void BitBuffer::ensure_capacity(size_t bc) {
-    size_t c = (bc >> 3) + 1;
-    if (m_cap < c) {
-        char* orig_data = m_dat;
+void BitBuffer::reallocate(size_t num_words) {
+    if (num_words == 0) num_words = 1;
 
-        m_dat = reinterpret_cast<char*>(malloc(sizeof(char) * c));
-        memcpy(m_dat, orig_data, sizeof(char) * m_cap);
-        memset(m_dat + m_cap, 0, sizeof(char) * (c - m_cap));
+    m_words = reinterpret_cast<uint64_t*>(realloc(m_words, sizeof(uint64_t) * num_words));
+    if (num_words > m_num_words)
+        memset(m_words + m_num_words, 0, sizeof(uint64_t) * (num_words - m_num_words));
 
-        free(orig_data);
-        m_cap = c;
-    }
+    m_num_words = num_words;
+}
+
+void BitBuffer::ensure_capacity(size_t bc) {
+    size_t c = words_for(bc + 1);
+    if (m_num_words < c)
+        reallocate(c);
 }
 
 void BitBuffer::ensure_capacity_pow2(size_t bc) {
-    size_t c = (bc >> 3) + 1;
-    if (m_cap < c) {
-        char* orig_data = m_dat;
-        size_t orig_cap = m_cap;
+    size_t c = words_for(bc + 1);
+    if (m_num_words < c) {
+        size_t num_words = 1;
+        while (num_words < c) num_words <<= 1;
+        reallocate(num_words);
+    }
+}
 
-        m_cap = 1;
-        while (m_cap < c) m_cap <<= 1;
+void BitBuffer::resize(size_t bc) {
+    size_t c = words_for(bc);
+    size_t r = bc % WORD_BITS;
 
-        m_dat = reinterpret_cast<char*>(malloc(sizeof(char) * m_cap));
-        memcpy(m_dat, orig_data, sizeof(char) * orig_cap);
-        memset(m_dat + orig_cap, 0, sizeof(char) * (m_cap - orig_cap));
+    reallocate(c);
 
-        free(orig_data);
-        m_cap = c;
-    }
+    // Clear the bits past the new end within the last word
+    if (r != 0)
+        m_words[c - 1] &= range_mask(0, r);
 }
 
 void BitBuffer::clear() {
-    memset(m_dat, 0, sizeof(char) * m_cap);
+    memset(m_words, 0, sizeof(uint64_t) * m_num_words);
 }
 
 void BitBuffer::partial_clear(size_t n) {
-    // clear bytes
-    size_t j = n >> 3;
-    memset(m_dat, 0, sizeof(char) * j);
-    // clear leftover, individual bits
-    size_t r = n - (j << 3);
-    size_t k;
-    for (k = 0; k < r; ++k) {
-        m_dat[j] &= ~(1 << k);
-    }
+    unset_range(0, n);
 }
 
 void BitBuffer::reset() {
-    m_cap = 1;
-    free(m_dat);
-    m_dat = (char*)malloc(sizeof(char) * m_cap);
-    memset(m_dat, 0, sizeof(char) * m_cap);
+    free(m_words);
+    m_num_words = 1;
+    m_words = reinterpret_cast<uint64_t*>(calloc(m_num_words, sizeof(uint64_t)));
+}
+
+void BitBuffer::set_range(size_t begin, size_t end) {
+    if (begin >= end) return;
+
+    size_t j = begin / WORD_BITS;
+    size_t k = (end - 1) / WORD_BITS;
+
+    if (j == k) {
+        m_words[j] |= range_mask(begin % WORD_BITS, end - k * WORD_BITS);
+        return;
+    }
+
+    // Partial first and last words, and whole words in between
+    m_words[j] |= range_mask(begin % WORD_BITS, WORD_BITS);
+    if (k > j + 1)
+        memset(m_words + j + 1, 0xFF, sizeof(uint64_t) * (k - j - 1));
+    m_words[k] |= range_mask(0, end - k * WORD_BITS);
+}
+
+void BitBuffer::unset_range(size_t begin, size_t end) {
+    if (begin >= end) return;
+
+    size_t j = begin / WORD_BITS;
+    size_t k = (end - 1) / WORD_BITS;
+
+    if (j == k) {
+        m_words[j] &= ~range_mask(begin % WORD_BITS, end - k * WORD_BITS);
+        return;
+    }
+
+    // Partial first and last words, and whole words in between
+    m_words[j] &= ~range_mask(begin % WORD_BITS, WORD_BITS);
+    if (k > j + 1)
+        memset(m_words + j + 1, 0, sizeof(uint64_t) * (k - j - 1));
+    m_words[k] &= ~range_mask(0, end - k * WORD_BITS);
+}
+
+size_t BitBuffer::popcount() const {
+    size_t count = 0;
+    for (size_t j = 0; j < m_num_words; ++j)
+        count += word_count_bits(m_words[j]);
+    return count;
+}
+
+size_t BitBuffer::find_next_set(size_t i) const {
+    size_t j = i / WORD_BITS;
+    uint64_t word;
+
+    if (j >= m_num_words) return capacity();
+
+    // Ignore the bits before i in its word
+    word = m_words[j] & ~((1ULL << (i % WORD_BITS)) - 1);
+    while (word == 0) {
+        if (++j == m_num_words) return capacity();
+        word = m_words[j];
+    }
+
+    return j * WORD_BITS + word_lowest_bit(word);
+}
+
+void BitBuffer::and_with(const BitBuffer& other) {
+    size_t j;
+    size_t n = m_num_words < other.m_num_words ? m_num_words : other.m_num_words;
+
+    for (j = 0; j < n; ++j)
+        m_words[j] &= other.m_words[j];
+    if (n < m_num_words)
+        memset(m_words + n, 0, sizeof(uint64_t) * (m_num_words - n));
+}
+
+void BitBuffer::or_with(const BitBuffer& other) {
+    if (m_num_words < other.m_num_words)
+        reallocate(other.m_num_words);
+    for (size_t j = 0; j < other.m_num_words; ++j)
+        m_words[j] |= other.m_words[j];
+}
+
+void BitBuffer::xor_with(const BitBuffer& other) {
+    if (m_num_words < other.m_num_words)
+        reallocate(other.m_num_words);
+    for (size_t j = 0; j < other.m_num_words; ++j)
+        m_words[j] ^= other.m_words[j];
+}
+
+void BitBuffer::and_not_with(const BitBuffer& other) {
+    size_t n = m_num_words < other.m_num_words ? m_num_words : other.m_num_words;
+    for (size_t j = 0; j < n; ++j)
+        m_words[j] &= ~other.m_words[j];
 }
@@ -11,22 +11,48 @@
 
 #include "common.h"
 
+#include <cstdint>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+// A set of bits stored in 64-bit words. Capacities are in bits and always a multiple of 64; bits gained by growing are
+// cleared. The per-bit functions do not perform boundary checks.
 class BitBuffer {
+public:
+    // Constants
+    static const size_t WORD_BITS = 64;
+
 protected:
-    char* m_dat;
-    size_t m_cap; // in bytes
+    // Variables
+    uint64_t* m_words;
+    size_t m_num_words;
+
+    // Helper Functions
+    void reallocate(size_t num_words);
+
+    friend class AtomicBitBuffer;
 
 public:
+    // Word helpers, shared with AtomicBitBuffer
+    static size_t words_for(size_t bc);
+    static size_t word_count_bits(uint64_t word);
+    static size_t word_lowest_bit(uint64_t word); // word must not be zero
+    static uint64_t range_mask(size_t begin, size_t end); // bits begin to end - 1 within a word; end is at most 64
+
     BitBuffer();
-    BitBuffer(size_t init_cap);
+    BitBuffer(size_t init_cap); // in bits
     BitBuffer(const BitBuffer& other);
     BitBuffer& operator=(const BitBuffer& other);
     virtual ~BitBuffer();
 
     size_t capacity() const; // in bits
 
-    void ensure_capacity(size_t bc); // in bits
-    void ensure_capacity_pow2(size_t bc); // in bits
+    // Make bit index bc valid, so the capacity becomes greater than bc
+    void ensure_capacity(size_t bc);
+    void ensure_capacity_pow2(size_t bc);
+    void resize(size_t bc); // in bits; keeps the bits that fit
 
     bool get_at(size_t i) const;
     void set_at(size_t i);
@@ -35,34 +61,90 @@ public:
     void clear();
     void partial_clear(size_t n); // clear first n bits
     void reset();
+
+    // Set or clear bits begin to end - 1
+    void set_range(size_t begin, size_t end);
+    void unset_range(size_t begin, size_t end);
+
+    // Returns the number of set bits
+    size_t popcount() const;
+
+    // Return the index of the first set bit, or the first at or after i, respectively; capacity() if there is none
+    size_t find_first_set() const;
+    size_t find_next_set(size_t i) const;
+
+    // Combine with the other buffer bit by bit. Bits beyond the other's capacity count as cleared; or_with and xor_with
+    // grow this buffer to the other's capacity.
+    void and_with(const BitBuffer& other);
+    void or_with(const BitBuffer& other);
+    void xor_with(const BitBuffer& other);
+    void and_not_with(const BitBuffer& other); // clears the bits set in the other
 };
 
+
+// Define inline functions
+
+inline size_t BitBuffer::words_for(size_t bc) {
+    return (bc + WORD_BITS - 1) / WORD_BITS;
+}
+
+inline size_t BitBuffer::word_count_bits(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64) && defined(__AVX__)
+    // AVX implies the POPCNT instruction
+    return static_cast<size_t>(__popcnt64(word));
+#elif defined(__GNUC__)
+    return static_cast<size_t>(__builtin_popcountll(word));
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<size_t>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline size_t BitBuffer::word_lowest_bit(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<size_t>(index);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(word)))
+        return static_cast<size_t>(index);
+    _BitScanForward(&index, static_cast<unsigned long>(word >> 32));
+    return static_cast<size_t>(index) + 32;
+#else
+    return static_cast<size_t>(__builtin_ctzll(word));
+#endif
+}
+
+inline uint64_t BitBuffer::range_mask(size_t begin, size_t end) {
+    uint64_t upper = end >= WORD_BITS ? ~0ULL : (1ULL << end) - 1;
+    return upper & ~((1ULL << begin) - 1);
+}
+
 inline size_t BitBuffer::capacity() const {
-    return m_cap << 3;
+    return m_num_words * WORD_BITS;
 }
 
 inline bool BitBuffer::get_at(size_t i) const {
-    size_t j = i >> 3;
-    size_t r = i - (j << 3);
-    return (m_dat[j] >> r) & 1;
+    return (m_words[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
 }
 
 inline void BitBuffer::set_at(size_t i) {
-    size_t j = i >> 3;
-    size_t r = i - (j << 3);
-    m_dat[j] |= 1 << r;
+    m_words[i / WORD_BITS] |= 1ULL << (i % WORD_BITS);
 }
 
 inline void BitBuffer::unset_at(size_t i) {
-    size_t j = i >> 3;
-    size_t r = i - (j << 3);
-    m_dat[j] &= ~(1 << r);
+    m_words[i / WORD_BITS] &= ~(1ULL << (i % WORD_BITS));
 }
 
 inline void BitBuffer::toggle_at(size_t i) {
-    size_t j = i >> 3;
-    size_t r = i - (j << 3);
-    m_dat[j] ^= 1 << r;
+    m_words[i / WORD_BITS] ^= 1ULL << (i % WORD_BITS);
+}
+
+inline size_t BitBuffer::find_first_set() const {
+    return find_next_set(0);
 }
 
 #endif  /* BIT_BUFFER_H */
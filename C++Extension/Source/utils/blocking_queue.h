@@ -0,0 +1,343 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef BLOCKING_QUEUE_H
+#define BLOCKING_QUEUE_H
+
+#include "common.h"
+#include "thread_hive.h"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// A bounded queue for the stages of a producer/consumer pipeline. Producers block while the queue is full, which keeps
+// a fast stage, such as extracting geometry from Ruby, from running arbitrarily far ahead of the workers. Closing the
+// queue rejects further items and wakes every waiting thread; consumers keep receiving the queued items until the
+// queue is drained.
+// Warning: a consumer running as a ThreadHive task occupies its bee while it waits.
+template <class T>
+class BlockingQueue {
+private:
+    // Disable copy constructor and assignment operator
+    BlockingQueue(const BlockingQueue<T>& other);
+    BlockingQueue<T>& operator=(const BlockingQueue<T>& other);
+
+    // Type-defines
+    typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type Storage;
+
+    // Variables
+    Storage* m_data;
+    size_t m_capacity;
+    size_t m_head; // index of the oldest item
+    size_t m_size;
+    bool m_closed;
+    unsigned long long m_num_full_waits;
+    mutable ThreadHive::Mutex m_mutex;
+    ThreadHive::Condition m_not_full_cond;
+    ThreadHive::Condition m_not_empty_cond;
+
+    // Helper Functions
+    T* item_at(size_t index); // index relative to the head
+
+    // Wait while the queue is full, or empty, and open; a negative timeout waits indefinitely. Return false on timeout.
+    bool wait_not_full(long long timeout_ns);
+    bool wait_not_empty(long long timeout_ns);
+
+    template <class U>
+    bool push_locked(U&& item, long long timeout_ns);
+    T take_front();
+
+public:
+    BlockingQueue(size_t capacity);
+    virtual ~BlockingQueue();
+
+    size_t capacity() const;
+    size_t size() const;
+    bool empty() const;
+    bool is_closed() const;
+
+    // The number of times a producer found the queue full and had to wait, a measure of backpressure
+    unsigned long long get_num_full_waits() const;
+
+    // Block while the queue is full. Return false, without queuing the item, if the queue is closed.
+    bool push(const T& item);
+    bool push(T&& item);
+
+    // Same as push, but gives up after the timeout, also returning false
+    bool push_timed(const T& item, unsigned int milliseconds);
+    bool push_timed(T&& item, unsigned int milliseconds);
+
+    // Return false if the queue is full or closed
+    bool try_push(const T& item);
+    bool try_push(T&& item);
+
+    // Block while the queue is empty and open. Return false once the queue is closed and drained.
+    bool pop(T& item_out);
+    bool pop_timed(T& item_out, unsigned int milliseconds); // also returns false on timeout
+    bool try_pop(T& item_out);
+
+    // Blocks while the queue is empty and open, then takes up to max_count items at once. Returns the number of items
+    // taken, which is zero once the queue is closed and drained.
+    size_t pop_batch(T* items_out, size_t max_count);
+
+    // Rejects further items and wakes all waiting threads; the queued items can still be popped
+    void close();
+};
+
+
+// Define template functions
+
+template <class T>
+BlockingQueue<T>::BlockingQueue(size_t capacity) :
+    m_capacity(capacity > 0 ? capacity : 1),
+    m_head(0),
+    m_size(0),
+    m_closed(false),
+    m_num_full_waits(0)
+{
+    m_data = reinterpret_cast<Storage*>(malloc(sizeof(Storage) * m_capacity));
+    ThreadHive::init_mutex(m_mutex);
+    ThreadHive::init_condition(m_not_full_cond);
+    ThreadHive::init_condition(m_not_empty_cond);
+}
+
+template <class T>
+BlockingQueue<T>::~BlockingQueue() {
+    for (size_t i = 0; i < m_size; ++i)
+        item_at(i)->~T();
+    free(m_data);
+    ThreadHive::destroy_condition(m_not_empty_cond);
+    ThreadHive::destroy_condition(m_not_full_cond);
+    ThreadHive::destroy_mutex(m_mutex);
+}
+
+template <class T>
+inline T* BlockingQueue<T>::item_at(size_t index) {
+    index += m_head;
+    if (index >= m_capacity)
+        index -= m_capacity;
+    return reinterpret_cast<T*>(m_data + index);
+}
+
+template <class T>
+bool BlockingQueue<T>::wait_not_full(long long timeout_ns) {
+    long long deadline;
+    long long remaining;
+
+    if (m_size < m_capacity || m_closed) return true;
+
+    ++m_num_full_waits;
+    if (timeout_ns < 0) {
+        while (m_size == m_capacity && !m_closed)
+            ThreadHive::wait_condition(m_not_full_cond, m_mutex);
+        return true;
+    }
+
+    // Wake-ups may be spurious, so wait against a fixed deadline
+    deadline = ThreadHive::get_time() + timeout_ns;
+    while (m_size == m_capacity && !m_closed) {
+        remaining = deadline - ThreadHive::get_time();
+        if (remaining <= 0) return false;
+        ThreadHive::wait_condition_timed(m_not_full_cond, m_mutex, static_cast<unsigned int>((remaining + 999999) / 1000000));
+    }
+    return true;
+}
+
+template <class T>
+bool BlockingQueue<T>::wait_not_empty(long long timeout_ns) {
+    long long deadline;
+    long long remaining;
+
+    if (m_size != 0 || m_closed) return true;
+
+    if (timeout_ns < 0) {
+        while (m_size == 0 && !m_closed)
+            ThreadHive::wait_condition(m_not_empty_cond, m_mutex);
+        return true;
+    }
+
+    deadline = ThreadHive::get_time() + timeout_ns;
+    while (m_size == 0 && !m_closed) {
+        remaining = deadline - ThreadHive::get_time();
+        if (remaining <= 0) return false;
+        ThreadHive::wait_condition_timed(m_not_empty_cond, m_mutex, static_cast<unsigned int>((remaining + 999999) / 1000000));
+    }
+    return true;
+}
+
+template <class T>
+template <class U>
+bool BlockingQueue<T>::push_locked(U&& item, long long timeout_ns) {
+    ThreadHive::lock_mutex(m_mutex);
+
+    if (!wait_not_full(timeout_ns) || m_closed) {
+        ThreadHive::unlock_mutex(m_mutex);
+        return false;
+    }
+
+    new (item_at(m_size)) T(std::forward<U>(item));
+    ++m_size;
+
+    ThreadHive::unlock_mutex(m_mutex);
+    ThreadHive::signal_condition(m_not_empty_cond);
+    return true;
+}
+
+template <class T>
+T BlockingQueue<T>::take_front() {
+    T* front = item_at(0);
+    T item(std::move(*front));
+
+    front->~T();
+    if (++m_head == m_capacity)
+        m_head = 0;
+    --m_size;
+
+    return item;
+}
+
+template <class T>
+inline size_t BlockingQueue<T>::capacity() const {
+    return m_capacity;
+}
+
+template <class T>
+size_t BlockingQueue<T>::size() const {
+    size_t size;
+    ThreadHive::lock_mutex(m_mutex);
+    size = m_size;
+    ThreadHive::unlock_mutex(m_mutex);
+    return size;
+}
+
+template <class T>
+inline bool BlockingQueue<T>::empty() const {
+    return size() == 0;
+}
+
+template <class T>
+bool BlockingQueue<T>::is_closed() const {
+    bool closed;
+    ThreadHive::lock_mutex(m_mutex);
+    closed = m_closed;
+    ThreadHive::unlock_mutex(m_mutex);
+    return closed;
+}
+
+template <class T>
+unsigned long long BlockingQueue<T>::get_num_full_waits() const {
+    unsigned long long count;
+    ThreadHive::lock_mutex(m_mutex);
+    count = m_num_full_waits;
+    ThreadHive::unlock_mutex(m_mutex);
+    return count;
+}
+
+template <class T>
+bool BlockingQueue<T>::push(const T& item) {
+    return push_locked(item, -1);
+}
+
+template <class T>
+bool BlockingQueue<T>::push(T&& item) {
+    return push_locked(std::move(item), -1);
+}
+
+template <class T>
+bool BlockingQueue<T>::push_timed(const T& item, unsigned int milliseconds) {
+    return push_locked(item, static_cast<long long>(milliseconds) * 1000000LL);
+}
+
+template <class T>
+bool BlockingQueue<T>::push_timed(T&& item, unsigned int milliseconds) {
+    return push_locked(std::move(item), static_cast<long long>(milliseconds) * 1000000LL);
+}
+
+template <class T>
+bool BlockingQueue<T>::try_push(const T& item) {
+    return push_locked(item, 0);
+}
+
+template <class T>
+bool BlockingQueue<T>::try_push(T&& item) {
+    return push_locked(std::move(item), 0);
+}
+
+template <class T>
+bool BlockingQueue<T>::pop(T& item_out) {
+    return pop_batch(&item_out, 1) != 0;
+}
+
+template <class T>
+bool BlockingQueue<T>::pop_timed(T& item_out, unsigned int milliseconds) {
+    ThreadHive::lock_mutex(m_mutex);
+
+    if (!wait_not_empty(static_cast<long long>(milliseconds) * 1000000LL) || m_size == 0) {
+        ThreadHive::unlock_mutex(m_mutex);
+        return false;
+    }
+
+    item_out = take_front();
+
+    ThreadHive::unlock_mutex(m_mutex);
+    ThreadHive::signal_condition(m_not_full_cond);
+    return true;
+}
+
+template <class T>
+bool BlockingQueue<T>::try_pop(T& item_out) {
+    ThreadHive::lock_mutex(m_mutex);
+
+    if (m_size == 0) {
+        ThreadHive::unlock_mutex(m_mutex);
+        return false;
+    }
+
+    item_out = take_front();
+
+    ThreadHive::unlock_mutex(m_mutex);
+    ThreadHive::signal_condition(m_not_full_cond);
+    return true;
+}
+
+template <class T>
+size_t BlockingQueue<T>::pop_batch(T* items_out, size_t max_count) {
+    size_t i, count;
+
+    if (max_count == 0) return 0;
+
+    ThreadHive::lock_mutex(m_mutex);
+
+    wait_not_empty(-1);
+
+    count = m_size < max_count ? m_size : max_count;
+    for (i = 0; i < count; ++i)
+        items_out[i] = take_front();
+
+    ThreadHive::unlock_mutex(m_mutex);
+
+    // Several spots may have opened up
+    if (count == 1)
+        ThreadHive::signal_condition(m_not_full_cond);
+    else if (count > 1)
+        ThreadHive::broadcast_condition(m_not_full_cond);
+    return count;
+}
+
+template <class T>
+void BlockingQueue<T>::close() {
+    ThreadHive::lock_mutex(m_mutex);
+    m_closed = true;
+    ThreadHive::unlock_mutex(m_mutex);
+
+    ThreadHive::broadcast_condition(m_not_full_cond);
+    ThreadHive::broadcast_condition(m_not_empty_cond);
+}
+
+#endif  /* BLOCKING_QUEUE_H */
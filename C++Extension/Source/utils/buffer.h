@@ -10,16 +10,28 @@
 #define BUFFER_H
 
 #include "common.h"
+#include "arena.h"
+#include "large_block.h"
+
+#include <type_traits>
 
 template <class T>
 class Buffer {
 protected:
     T* m_data;
     unsigned int m_capacity;
+    Arena* m_arena; // allocate from the heap if null
+
+    T* allocate_data(unsigned int capacity) const;
+    void free_data();
 
 public:
     Buffer();
     Buffer(unsigned int init_capacity);
+
+    // Allocates from the arena, which must outlive the buffer. Copies of the buffer allocate from the heap.
+    Buffer(Arena& arena, unsigned int init_capacity = 1);
+
     Buffer(const Buffer<T>& other);
     Buffer<T>& operator=(const Buffer<T>& other);
     virtual ~Buffer();
@@ -27,6 +39,9 @@ public:
     void ensure_capacity(unsigned int s);
     void ensure_capacity_pow2(unsigned int s);
 
+    // Requests transparent huge pages for the storage; see LargeBlock::advise_huge_pages
+    bool advise_huge_pages();
+
     T* pat(unsigned int index) const;
     T& operator[](unsigned int index); // does not perform boundary checks
     const T& operator[](unsigned int index) const; // does not perform boundary checks
@@ -35,26 +50,35 @@ public:
 
 template <class T>
 Buffer<T>::Buffer()
-    : m_capacity(1)
+    : m_capacity(1), m_arena(nullptr)
 {
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    m_data = allocate_data(m_capacity);
 }
 
 template <class T>
 Buffer<T>::Buffer(unsigned int init_capacity)
-    : m_capacity(init_capacity)
+    : m_capacity(init_capacity), m_arena(nullptr)
 {
     if (m_capacity < 1)
         m_capacity = 1;
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    m_data = allocate_data(m_capacity);
+}
+
+template <class T>
+Buffer<T>::Buffer(Arena& arena, unsigned int init_capacity)
+    : m_capacity(init_capacity), m_arena(&arena)
+{
+    if (m_capacity < 1)
+        m_capacity = 1;
+    m_data = allocate_data(m_capacity);
 }
 
 template <class T>
 Buffer<T>::Buffer(const Buffer<T>& other)
-    : m_capacity(other.m_capacity)
+    : m_capacity(other.m_capacity), m_arena(nullptr)
 {
     // Allocate and copy
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    m_data = allocate_data(m_capacity);
     memcpy(m_data, other.m_data, sizeof(T) * m_capacity);
 }
 
@@ -62,13 +86,13 @@ template <class T>
 Buffer<T>& Buffer<T>::operator=(const Buffer<T>& other) {
     if (&other != this) {
         // Deallocate
-        free(m_data);
+        free_data();
 
         // Assign new info
         m_capacity = other.m_capacity;
 
         // Allocate and copy
-        m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+        m_data = allocate_data(m_capacity);
         memcpy(m_data, other.m_data, sizeof(T) * m_capacity);
 
     }
@@ -78,18 +102,36 @@ Buffer<T>& Buffer<T>::operator=(const Buffer<T>& other) {
 template <class T>
 Buffer<T>::~Buffer() {
     // Deallocate
-    free(m_data);
+    free_data();
 }
 
 template <class T>
-void Buffer<T>::ensure_capacity(unsigned int s) {
-    if (m_capacity < s) {
-        T* orig_data = m_data;
+inline T* Buffer<T>::allocate_data(unsigned int capacity) const {
+    if (m_arena != nullptr)
+        return reinterpret_cast<T*>(m_arena->allocate(sizeof(T) * capacity, std::alignment_of<T>::value));
+    else
+        return reinterpret_cast<T*>(LargeBlock::allocate(sizeof(T) * capacity));
+}
 
-        m_data = reinterpret_cast<T*>(malloc(sizeof(T) * s));
-        memcpy(m_data, orig_data, sizeof(T) * m_capacity);
+template <class T>
+inline void Buffer<T>::free_data() {
+    if (m_arena != nullptr)
+        m_arena->deallocate(m_data, sizeof(T) * m_capacity);
+    else
+        LargeBlock::deallocate(m_data, sizeof(T) * m_capacity);
+}
 
-        free(orig_data);
+template <class T>
+void Buffer<T>::ensure_capacity(unsigned int s) {
+    if (m_capacity < s) {
+        if (m_arena != nullptr) {
+            // Extends in place if the buffer was the most recent allocation
+            m_data = reinterpret_cast<T*>(m_arena->reallocate(m_data, sizeof(T) * m_capacity, sizeof(T) * s, std::alignment_of<T>::value));
+        }
+        else {
+            // Grows in place where possible; large blocks are remapped rather than copied
+            m_data = reinterpret_cast<T*>(LargeBlock::reallocate(m_data, sizeof(T) * m_capacity, sizeof(T) * s));
+        }
         m_capacity = s;
     }
 }
@@ -97,20 +139,20 @@ void Buffer<T>::ensure_capacity(unsigned int s) {
 template <class T>
 void Buffer<T>::ensure_capacity_pow2(unsigned int s) {
     if (m_capacity < s) {
-        unsigned int orig_cap = m_capacity;
-        T* orig_data = m_data;
+        unsigned int new_capacity = 1;
+        while (new_capacity < s)
+            new_capacity <<= 1;
 
-        m_capacity = 1;
-        while (m_capacity < s)
-            m_capacity <<= 1;
-
-        m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
-        memcpy(m_data, orig_data, sizeof(T) * orig_cap);
-
-        free(orig_data);
+        ensure_capacity(new_capacity);
     }
 }
 
+template <class T>
+bool Buffer<T>::advise_huge_pages() {
+    if (m_arena != nullptr) return false;
+    return LargeBlock::advise_huge_pages(m_data, sizeof(T) * m_capacity);
+}
+
 template <class T>
 inline T* Buffer<T>::pat(unsigned int index) const {
     return m_data + index;
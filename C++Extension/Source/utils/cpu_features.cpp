@@ -0,0 +1,126 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#include "cpu_features.h"
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+    #include <immintrin.h>
+#else
+    #include <cpuid.h>
+#endif
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Variables
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+std::atomic<int> CpuFeatures::s_simd_limit(CpuFeatures::SIMD_AVX512);
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Helper Functions
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+static void query_cpuid(unsigned int leaf, unsigned int* regs) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), 0);
+    for (int i = 0; i < 4; ++i)
+        regs[i] = static_cast<unsigned int>(info[i]);
+#else
+    __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// The register state that the operating system saves on context switches
+static unsigned long long query_xcr0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+
+unsigned int CpuFeatures::detect() {
+    unsigned int regs[4]; // eax, ebx, ecx, edx
+    unsigned int max_leaf;
+    unsigned int flags = 0;
+    unsigned long long xcr0 = 0;
+    bool os_ymm, os_zmm;
+
+    query_cpuid(0, regs);
+    max_leaf = regs[0];
+    if (max_leaf < 1) return flags;
+
+    query_cpuid(1, regs);
+    if ((regs[3] & (1u << 26)) != 0)
+        flags |= FLAG_SSE2;
+
+    // AVX registers are only usable if the system saves them (OSXSAVE, then the XMM and YMM bits of XCR0)
+    if ((regs[2] & (1u << 27)) != 0)
+        xcr0 = query_xcr0();
+    os_ymm = (xcr0 & 0x06) == 0x06;
+    os_zmm = (xcr0 & 0xE6) == 0xE6; // also the opmask and both halves of the upper ZMM registers
+
+    if (os_ymm && (regs[2] & (1u << 28)) != 0) {
+        flags |= FLAG_AVX;
+        if ((regs[2] & (1u << 12)) != 0)
+            flags |= FLAG_FMA;
+    }
+
+    if (max_leaf >= 7 && (flags & FLAG_AVX) != 0) {
+        query_cpuid(7, regs);
+        if ((regs[1] & (1u << 5)) != 0)
+            flags |= FLAG_AVX2;
+        if (os_zmm && (regs[1] & (1u << 16)) != 0)
+            flags |= FLAG_AVX512F;
+    }
+
+    return flags;
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Functions
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+CpuFeatures::SimdLevel CpuFeatures::get_simd_level() {
+    int level;
+    int limit = s_simd_limit.load(std::memory_order_relaxed);
+    unsigned int flags = get_flags();
+
+    if ((flags & FLAG_AVX512F) != 0)
+        level = SIMD_AVX512;
+    else if ((flags & (FLAG_AVX2 | FLAG_FMA)) == (FLAG_AVX2 | FLAG_FMA))
+        level = SIMD_AVX2;
+    else if ((flags & FLAG_AVX) != 0)
+        level = SIMD_AVX;
+    else if ((flags & FLAG_SSE2) != 0)
+        level = SIMD_SSE2;
+    else
+        level = SIMD_NONE;
+
+    return static_cast<SimdLevel>(level < limit ? level : limit);
+}
+
+void CpuFeatures::set_simd_limit(SimdLevel level) {
+    s_simd_limit.store(level, std::memory_order_relaxed);
+}
+
+CpuFeatures::SimdLevel CpuFeatures::get_simd_limit() {
+    return static_cast<SimdLevel>(s_simd_limit.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,100 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include "common.h"
+
+#include <atomic>
+
+// Lets GCC and Clang compile a function for an instruction set beyond the one the file is compiled for; MSVC accepts
+// any intrinsic anywhere. Such functions may only be called once CpuFeatures reports the instruction set.
+#if defined(__GNUC__) || defined(__clang__)
+    #define M_TARGET_AVX __attribute__((target("avx")))
+    #define M_TARGET_AVX2 __attribute__((target("avx2")))
+    #define M_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+    #define M_TARGET_AVX
+    #define M_TARGET_AVX2
+    #define M_TARGET_AVX512
+#endif
+
+// Reports the SIMD instruction sets of the processor, as far as the operating system saves their registers, so that
+// batch kernels can pick the widest path at runtime. The processor is queried once.
+class CpuFeatures {
+public:
+    // Enumerators
+    enum SimdLevel {
+        SIMD_NONE = 0,
+        SIMD_SSE2,
+        SIMD_AVX,
+        SIMD_AVX2, // also implies FMA
+        SIMD_AVX512 // AVX-512F
+    };
+
+private:
+    // Constants
+    static const unsigned int FLAG_SSE2 = 1;
+    static const unsigned int FLAG_AVX = 2;
+    static const unsigned int FLAG_AVX2 = 4;
+    static const unsigned int FLAG_FMA = 8;
+    static const unsigned int FLAG_AVX512F = 16;
+
+    // Variables
+    static std::atomic<int> s_simd_limit;
+
+    // Helper Functions
+    static unsigned int detect();
+    static unsigned int get_flags();
+
+public:
+    static bool has_sse2();
+    static bool has_avx();
+    static bool has_avx2();
+    static bool has_fma();
+    static bool has_avx512f();
+
+    // The widest level supported, capped by the limit
+    static SimdLevel get_simd_level();
+
+    // Caps the level that get_simd_level reports, for testing the narrower paths or ruling them out when
+    // troubleshooting. SIMD_AVX512 removes the cap.
+    static void set_simd_limit(SimdLevel level);
+    static SimdLevel get_simd_limit();
+};
+
+
+// Define inline functions
+
+inline unsigned int CpuFeatures::get_flags() {
+    static const unsigned int flags = detect();
+    return flags;
+}
+
+inline bool CpuFeatures::has_sse2() {
+    return (get_flags() & FLAG_SSE2) != 0;
+}
+
+inline bool CpuFeatures::has_avx() {
+    return (get_flags() & FLAG_AVX) != 0;
+}
+
+inline bool CpuFeatures::has_avx2() {
+    return (get_flags() & FLAG_AVX2) != 0;
+}
+
+inline bool CpuFeatures::has_fma() {
+    return (get_flags() & FLAG_FMA) != 0;
+}
+
+inline bool CpuFeatures::has_avx512f() {
+    return (get_flags() & FLAG_AVX512F) != 0;
+}
+
+#endif  /* CPU_FEATURES_H */
@@ -10,60 +10,92 @@
 #define DYNAMIC_ARRAY_H
 
 #include "common.h"
+#include "arena.h"
+#include "large_block.h"
+
+#include <type_traits>
+#include <utility>
 
 template <class T>
 class DynamicArray {
 protected:
 
     T* m_data;
-    unsigned int m_capacity;
-    unsigned int m_size;
+    size_t m_capacity;
+    size_t m_size;
+    Arena* m_arena; // allocate from the heap if null
 
+    T* allocate_data(size_t capacity) const;
+    void free_data();
     void grow();
-    void ensure_capacity(unsigned int s);
-    void ensure_capacity_pow2(unsigned int s);
+    void ensure_capacity(size_t s);
+    void ensure_capacity_pow2(size_t s);
+    void reallocate(size_t new_capacity);
+
+    // Moves the items to new space of the given capacity; resizes in place where possible if T is trivially copyable
+    void reallocate(size_t new_capacity, std::true_type trivially_copyable);
+    void reallocate(size_t new_capacity, std::false_type trivially_copyable);
 
 public:
     DynamicArray();
-    DynamicArray(unsigned int init_capacity);
+    DynamicArray(size_t init_capacity);
+
+    // Allocates from the arena, which must outlive the array. Copies of the array allocate from the heap, while the
+    // arena goes along with the space when moving or swapping.
+    DynamicArray(Arena& arena, size_t init_capacity = 1);
+
     DynamicArray(const DynamicArray<T>& other);
+    DynamicArray(DynamicArray<T>&& other);
     DynamicArray<T>& operator=(const DynamicArray<T>& other);
+    DynamicArray<T>& operator=(DynamicArray<T>&& other);
     virtual ~DynamicArray();
 
     void swap_data_with(DynamicArray<T>& other);
     void concat(const DynamicArray<T>& other);
 
-    unsigned int size_in_bytes() const;
-    unsigned int size() const;
+    size_t size_in_bytes() const;
+    size_t size() const;
+    size_t capacity() const;
     void clear(); // preserves space
     void reset(); // frees space
     bool empty() const;
-    unsigned int find(const T& item) const; // Returns size() if not found
-    unsigned int find2(T item) const; // Returns size() if not found
+    size_t find(const T& item) const; // Returns size() if not found
+    size_t find2(T item) const; // Returns size() if not found
     bool contains(const T& item) const;
     bool contains2(T item) const;
     void append(const T& item);
+    void append(T&& item);
     void append2(T item);
-    unsigned int get_append_index();
+    size_t get_append_index();
     T pop();
     void pop2(T& out);
     void cut_unused_pow2();
-    void cut_to_size_pow2(unsigned int s);
-    void cut_to_size(unsigned int s);
-    void swap(unsigned int i, unsigned int j);
+    void cut_to_size_pow2(size_t s);
+    void cut_to_size(size_t s);
+    void swap(size_t i, size_t j);
+
+    template <class... Args>
+    T& emplace_back(Args&&... args);
 
     // Warning: the ordering is not preserved
-    void remove_at(unsigned int index);
-    void remove_first(const T& item);
-    void remove_first2(T item);
-    void remove_all(const T& item);
+    void remove_at(size_t index); // O(1); moves the last item into the gap
+    bool remove_first(const T& item); // O(n); removes one matching item and returns whether there was any
+    bool remove_first2(T item);
+    void remove_all(const T& item); // O(n)
     void remove_all2(T item);
 
-    // Initializes N spots; increments size
-    void reserve(unsigned int count);
+    // Makes room for count items in total, without changing the size
+    void reserve(size_t count);
 
-    const T& get_append_item() const;
-    T& get_append_item();
+    // Default-initializes new spots or destructs the excess ones
+    void resize(size_t count);
+
+    // Frees unused space
+    void shrink_to_fit();
+
+    // Requests transparent huge pages for the storage; see LargeBlock::advise_huge_pages. Best called after reserving
+    // the final capacity.
+    bool advise_huge_pages();
 
     const T& first() const;
     const T& last() const;
@@ -71,58 +103,78 @@ public:
     T& first();
     T& last();
 
-    T* pat(unsigned int index) const;
-    T& operator[](unsigned int index); // does not perform boundary checks
-    const T& operator[](unsigned int index) const; // does not perform boundary checks
+    T& get_append_item();
+
+    T* pat(size_t index) const;
+    T& operator[](size_t index); // does not perform boundary checks
+    const T& operator[](size_t index) const; // does not perform boundary checks
 };
 
 
 template <class T>
 DynamicArray<T>::DynamicArray()
-    : m_capacity(1), m_size(0)
+    : m_capacity(1), m_size(0), m_arena(nullptr)
+{
+    m_data = allocate_data(m_capacity);
+}
+
+template <class T>
+DynamicArray<T>::DynamicArray(size_t init_capacity)
+    : m_capacity(init_capacity), m_size(0), m_arena(nullptr)
 {
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    if (m_capacity == 0) m_capacity = 1;
+    m_data = allocate_data(m_capacity);
 }
 
 template <class T>
-DynamicArray<T>::DynamicArray(unsigned int init_capacity)
-    : m_capacity(init_capacity), m_size(0)
+DynamicArray<T>::DynamicArray(Arena& arena, size_t init_capacity)
+    : m_capacity(init_capacity), m_size(0), m_arena(&arena)
 {
     if (m_capacity == 0) m_capacity = 1;
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    m_data = allocate_data(m_capacity);
 }
 
 template <class T>
 DynamicArray<T>::DynamicArray(const DynamicArray<T>& other)
-    : m_capacity(other.m_capacity), m_size(other.m_size)
+    : m_capacity(other.m_capacity), m_size(other.m_size), m_arena(nullptr)
 {
     // Allocate
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    m_data = allocate_data(m_capacity);
 
     // Deep copy
-    unsigned int i = 0;
+    size_t i = 0;
     for (; i < m_size; ++i)
         new (m_data + i) T(other.m_data[i]);
 }
 
+template <class T>
+DynamicArray<T>::DynamicArray(DynamicArray<T>&& other)
+    : m_data(other.m_data), m_capacity(other.m_capacity), m_size(other.m_size), m_arena(other.m_arena)
+{
+    // Leave the other array empty, but usable
+    other.m_capacity = 1;
+    other.m_size = 0;
+    other.m_data = other.allocate_data(other.m_capacity);
+}
+
 template <class T>
 DynamicArray<T>& DynamicArray<T>::operator=(const DynamicArray<T>& other) {
     if (&other != this) {
-        unsigned int i;
+        size_t i;
 
         // Destruct
         for (i = 0; i < m_size; ++i)
             (m_data + i)->~T();
 
         // Deallocate
-        free(m_data);
+        free_data();
 
         // Assign new info
         m_capacity = other.m_capacity;
         m_size = other.m_size;
 
         // Allocate
-        m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+        m_data = allocate_data(m_capacity);
 
         // Deep copy
         for (i = 0; i < m_size; ++i)
@@ -131,82 +183,128 @@ DynamicArray<T>& DynamicArray<T>::operator=(const DynamicArray<T>& other) {
     return *this;
 }
 
+template <class T>
+DynamicArray<T>& DynamicArray<T>::operator=(DynamicArray<T>&& other) {
+    if (&other != this) {
+        // Take over the other's space and hand it ours
+        clear();
+        swap_data_with(other);
+    }
+    return *this;
+}
+
 template <class T>
 DynamicArray<T>::~DynamicArray() {
     // Destruct
-    unsigned int i = 0;
+    size_t i = 0;
     for (; i < m_size; ++i)
         (m_data + i)->~T();
 
     // Deallocate
-    free(m_data);
+    free_data();
 }
 
 template <class T>
-void DynamicArray<T>::grow() {
-    if (m_size < m_capacity) return; // importatnt to be less than, since we always append one after growing
+inline T* DynamicArray<T>::allocate_data(size_t capacity) const {
+    if (m_arena != nullptr)
+        return reinterpret_cast<T*>(m_arena->allocate(sizeof(T) * capacity, std::alignment_of<T>::value));
+    else
+        return reinterpret_cast<T*>(LargeBlock::allocate(sizeof(T) * capacity));
+}
 
-    if ((m_capacity & (m_capacity - 1)) != 0) // if not pow2
-        m_capacity = 1;
-    while (m_capacity <= m_size) // correct
-        m_capacity <<= 1;
+template <class T>
+inline void DynamicArray<T>::free_data() {
+    if (m_arena != nullptr)
+        m_arena->deallocate(m_data, sizeof(T) * m_capacity);
+    else
+        LargeBlock::deallocate(m_data, sizeof(T) * m_capacity);
+}
 
-    T* orig_data = m_data;
+template <class T>
+inline void DynamicArray<T>::reallocate(size_t new_capacity, std::true_type trivially_copyable) {
+    // Let the allocator extend the block in place, or move it without holding both copies where it can; large blocks
+    // are remapped rather than copied
+    if (m_arena != nullptr)
+        m_data = reinterpret_cast<T*>(m_arena->reallocate(m_data, sizeof(T) * m_capacity, sizeof(T) * new_capacity, std::alignment_of<T>::value));
+    else
+        m_data = reinterpret_cast<T*>(LargeBlock::reallocate((void*)m_data, sizeof(T) * m_capacity, sizeof(T) * new_capacity));
+    m_capacity = new_capacity;
+}
+
+template <class T>
+void DynamicArray<T>::reallocate(size_t new_capacity, std::false_type trivially_copyable) {
+    size_t i;
+    T* new_data = allocate_data(new_capacity);
 
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
-    memcpy((void*)m_data, (void*)orig_data, sizeof(T) * m_size);
+    for (i = 0; i < m_size; ++i) {
+        new (new_data + i) T(std::move(m_data[i]));
+        (m_data + i)->~T();
+    }
 
-    free(orig_data);
+    free_data();
+    m_data = new_data;
+    m_capacity = new_capacity;
 }
 
 template <class T>
-void DynamicArray<T>::ensure_capacity(unsigned int s) {
-    if (s <= m_capacity) return;
+inline void DynamicArray<T>::reallocate(size_t new_capacity) {
+    reallocate(new_capacity, std::is_trivially_copyable<T>());
+}
 
-    m_capacity = s;
-    T* orig_data = m_data;
+template <class T>
+void DynamicArray<T>::grow() {
+    if (m_size < m_capacity) return; // importatnt to be less than, since we always append one after growing
 
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
-    memcpy((void*)m_data, (void*)orig_data, sizeof(T) * m_size);
+    size_t new_capacity = m_capacity;
+    if ((new_capacity & (new_capacity - 1)) != 0) // if not pow2
+        new_capacity = 1;
+    while (new_capacity <= m_size) // correct
+        new_capacity <<= 1;
 
-    free(orig_data);
+    reallocate(new_capacity);
 }
 
 template <class T>
-void DynamicArray<T>::ensure_capacity_pow2(unsigned int s) {
-    if (s <= m_capacity) return; // should be less than or equal to, since we do not append more than requested
+void DynamicArray<T>::ensure_capacity(size_t s) {
+    if (s <= m_capacity) return;
 
-    if ((m_capacity & (m_capacity - 1)) != 0) // if not pow2
-        m_capacity = 1;
-    while (m_capacity < s) // correct
-        m_capacity <<= 1;
+    reallocate(s);
+}
 
-    T* orig_data = m_data;
+template <class T>
+void DynamicArray<T>::ensure_capacity_pow2(size_t s) {
+    if (s <= m_capacity) return; // should be less than or equal to, since we do not append more than requested
 
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
-    memcpy((void*)m_data, (void*)orig_data, sizeof(T) * m_size);
+    size_t new_capacity = m_capacity;
+    if ((new_capacity & (new_capacity - 1)) != 0) // if not pow2
+        new_capacity = 1;
+    while (new_capacity < s) // correct
+        new_capacity <<= 1;
 
-    free(orig_data);
+    reallocate(new_capacity);
 }
 
 template <class T>
 void DynamicArray<T>::swap_data_with(DynamicArray<T>& other) {
     T* d = m_data;
-    unsigned int c = m_capacity;
-    unsigned int s = m_size;
+    size_t c = m_capacity;
+    size_t s = m_size;
+    Arena* a = m_arena;
 
     m_data = other.m_data;
     m_capacity = other.m_capacity;
     m_size = other.m_size;
+    m_arena = other.m_arena;
 
     other.m_data = d;
     other.m_capacity = c;
     other.m_size = s;
+    other.m_arena = a;
 }
 
 template <class T>
 void DynamicArray<T>::concat(const DynamicArray<T>& other) {
-    unsigned int i;
+    size_t i;
     ensure_capacity_pow2(m_size + other.m_size);
     for (i = 0; i < other.m_size; ++i) {
         new (m_data + m_size) T(other.m_data[i]);
@@ -215,19 +313,24 @@ void DynamicArray<T>::concat(const DynamicArray<T>& other) {
 }
 
 template <class T>
-inline unsigned int DynamicArray<T>::size_in_bytes() const {
+inline size_t DynamicArray<T>::size_in_bytes() const {
     return sizeof(T) * m_size;
 }
 
 template <class T>
-inline unsigned int DynamicArray<T>::size() const {
+inline size_t DynamicArray<T>::size() const {
     return m_size;
 }
 
+template <class T>
+inline size_t DynamicArray<T>::capacity() const {
+    return m_capacity;
+}
+
 template <class T>
 void DynamicArray<T>::clear() {
     // Destruct
-    unsigned int i;
+    size_t i;
     for (i = 0; i < m_size; ++i)
         (m_data + i)->~T();
 
@@ -239,9 +342,9 @@ template <class T>
 void DynamicArray<T>::reset() {
     clear();
 
+    free_data();
     m_capacity = 1;
-    free(m_data);
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    m_data = allocate_data(m_capacity);
 }
 
 template <class T>
@@ -250,16 +353,16 @@ inline bool DynamicArray<T>::empty() const {
 }
 
 template <class T>
-unsigned int DynamicArray<T>::find(const T& item) const {
-    unsigned int i = 0;
+size_t DynamicArray<T>::find(const T& item) const {
+    size_t i = 0;
     for (; i < m_size; ++i)
         if (m_data[i] == item) break;
     return i;
 }
 
 template <class T>
-unsigned int DynamicArray<T>::find2(T item) const {
-    unsigned int i = 0;
+size_t DynamicArray<T>::find2(T item) const {
+    size_t i = 0;
     for (; i < m_size; ++i)
         if (m_data[i] == item) break;
     return i;
@@ -267,19 +370,12 @@ unsigned int DynamicArray<T>::find2(T item) const {
 
 template <class T>
 bool DynamicArray<T>::contains(const T& item) const {
-    unsigned int i = 0;
-    for (; i < m_size; ++i)
-        if (m_data[i] == item)
-            return true;
-    return false;
+    return find(item) != m_size;
 }
 
 template <class T>
 bool DynamicArray<T>::contains2(T item) const {
-    unsigned int i = 0;
-    for (; i < m_size; ++i)
-        if (m_data[i] == item)
-            return true;
+    return find(item) != m_size;
 }
 
 template <class T>
@@ -291,20 +387,41 @@ void DynamicArray<T>::append(const T& item) {
     ++m_size;
 }
 
+template <class T>
+void DynamicArray<T>::append(T&& item) {
+    grow();
+
+    new (m_data + m_size) T(std::move(item));
+
+    ++m_size;
+}
+
 template <class T>
 void DynamicArray<T>::append2(T item) {
     grow();
 
-    new (m_data + m_size) T(item);
+    new (m_data + m_size) T(std::move(item));
+
+    ++m_size;
+}
+
+template <class T>
+template <class... Args>
+T& DynamicArray<T>::emplace_back(Args&&... args) {
+    grow();
+
+    T* item = new (m_data + m_size) T(std::forward<Args>(args)...);
 
     ++m_size;
+
+    return *item;
 }
 
 template <class T>
 T DynamicArray<T>::pop() {
     --m_size;
 
-    T v(m_data[m_size]);
+    T v(std::move(m_data[m_size]));
 
     (m_data + m_size)->~T();
 
@@ -314,7 +431,7 @@ T DynamicArray<T>::pop() {
 template <class T>
 void DynamicArray<T>::pop2(T& out) {
     --m_size;
-    out = m_data[m_size];
+    out = std::move(m_data[m_size]);
     (m_data + m_size)->~T();
 }
 
@@ -322,24 +439,17 @@ template <class T>
 void DynamicArray<T>::cut_unused_pow2() {
     if (m_size == m_capacity) return;
 
-    unsigned int orig_cap = m_capacity;
-
-    m_capacity = 1;
-    while (m_capacity < m_size) m_capacity <<= 1;
-
-    if (m_capacity == orig_cap) return;
+    size_t new_capacity = 1;
+    while (new_capacity < m_size) new_capacity <<= 1;
 
-    T* orig_data = m_data;
+    if (new_capacity == m_capacity) return;
 
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
-    memcpy(m_data, orig_data, sizeof(T) * m_size);
-
-    free(orig_data);
+    reallocate(new_capacity);
 }
 
 template <class T>
-void DynamicArray<T>::cut_to_size_pow2(unsigned int s) {
-    unsigned int i;
+void DynamicArray<T>::cut_to_size_pow2(size_t s) {
+    size_t i;
 
     // Deallocate unused
     for (i = s; i < m_size; ++i) {
@@ -348,90 +458,54 @@ void DynamicArray<T>::cut_to_size_pow2(unsigned int s) {
 
     m_size = s;
 
-    unsigned int oc = m_capacity;
-    m_capacity = 1;
-    while (m_capacity < m_size) m_capacity <<= 1;
-
-    if (m_capacity == oc) return;
-
-    T* orig_data = m_data;
-
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
-    memcpy((void*)m_data, (void*)orig_data, sizeof(T) * m_size);
-
-    free(orig_data);
+    cut_unused_pow2();
 }
 
 template <class T>
-void DynamicArray<T>::cut_to_size(unsigned int s) {
-    unsigned int i;
+void DynamicArray<T>::cut_to_size(size_t s) {
+    size_t i;
 
     // Deallocate unused
     for (i = s; i < m_size; ++i) {
         (m_data + i)->~T();
     }
 
-    unsigned int oc = m_capacity;
     m_size = s;
-    if (m_size == 0)
-        m_capacity = 1;
-    else
-        m_capacity = s;
-
-    if (m_capacity == oc) return;
-
-    T* orig_data = m_data;
-
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
-    memcpy((void*)m_data, (void*)orig_data, sizeof(T) * m_size);
 
-    free(orig_data);
+    shrink_to_fit();
 }
 
 template <class T>
-void DynamicArray<T>::swap(unsigned int i, unsigned int j) {
-    T temp(m_data[i]);
-    m_data[i] = m_data[j];
-    m_data[j] = temp;
+void DynamicArray<T>::swap(size_t i, size_t j) {
+    T temp(std::move(m_data[i]));
+    m_data[i] = std::move(m_data[j]);
+    m_data[j] = std::move(temp);
 }
 
 template <class T>
-void DynamicArray<T>::remove_at(unsigned int index) {
-    (m_data + index)->~T();
+void DynamicArray<T>::remove_at(size_t index) {
     --m_size;
-    if (index != m_size) {
-        memcpy((void*)(m_data + index), (void*)(m_data + m_size), sizeof(T));
-    }
+    if (index != m_size)
+        m_data[index] = std::move(m_data[m_size]);
+    (m_data + m_size)->~T();
 }
 
 template <class T>
-void DynamicArray<T>::remove_first(const T& item) {
-    unsigned int i = 0;
-    while (i < m_size) {
-        if (m_data[i] == item) {
-            remove_at(i);
-        }
-        else
-            ++i;
-    }
+bool DynamicArray<T>::remove_first(const T& item) {
+    size_t i = find(item);
+    if (i == m_size) return false;
+    remove_at(i);
+    return true;
 }
 
 template <class T>
-void DynamicArray<T>::remove_first2(T item) {
-    unsigned int i = 0;
-    while (i < m_size) {
-        if (m_data[i] == item) {
-            remove_at(i);
-            return;
-        }
-        else
-            ++i;
-    }
+bool DynamicArray<T>::remove_first2(T item) {
+    return remove_first(item);
 }
 
 template <class T>
 void DynamicArray<T>::remove_all(const T& item) {
-    unsigned int i = 0;
+    size_t i = 0;
     while (i < m_size) {
         if (m_data[i] == item) {
             remove_at(i);
@@ -443,38 +517,53 @@ void DynamicArray<T>::remove_all(const T& item) {
 
 template <class T>
 void DynamicArray<T>::remove_all2(T item) {
-    unsigned int i = 0;
-    while (i < m_size) {
-        if (m_data[i] == item) {
-            remove_at(i);
-        }
-        else
-            ++i;
-    }
+    remove_all(item);
+}
+
+template <class T>
+void DynamicArray<T>::reserve(size_t count) {
+    ensure_capacity(count);
 }
 
 template <class T>
-void DynamicArray<T>::reserve(unsigned int count) {
-    ensure_capacity(m_size + count);
+void DynamicArray<T>::resize(size_t count) {
+    size_t i;
 
-    unsigned int i = m_size;
-    m_size += count;
-    for (; i < m_size; ++i)
+    // Destruct the excess
+    for (i = count; i < m_size; ++i)
+        (m_data + i)->~T();
+
+    ensure_capacity(count);
+
+    // Initialize the new spots
+    for (i = m_size; i < count; ++i)
         new (m_data + i) T;
+
+    m_size = count;
 }
 
 template <class T>
-unsigned int DynamicArray<T>::get_append_index() {
-    grow(); // update size if necessary
+void DynamicArray<T>::shrink_to_fit() {
+    size_t new_capacity = m_size != 0 ? m_size : 1;
 
-    new (m_data + m_size) T;
+    if (new_capacity == m_capacity) return;
 
-    return m_size++;
+    reallocate(new_capacity);
 }
 
 template <class T>
-inline const T& DynamicArray<T>::get_append_item() const {
-    return m_data[get_append_index()];
+bool DynamicArray<T>::advise_huge_pages() {
+    if (m_arena != nullptr) return false;
+    return LargeBlock::advise_huge_pages(m_data, sizeof(T) * m_capacity);
+}
+
+template <class T>
+size_t DynamicArray<T>::get_append_index() {
+    grow(); // update size if necessary
+
+    new (m_data + m_size) T;
+
+    return m_size++;
 }
 
 template <class T>
@@ -503,17 +592,17 @@ inline T& DynamicArray<T>::last() {
 }
 
 template <class T>
-inline T* DynamicArray<T>::pat(unsigned int index) const {
+inline T* DynamicArray<T>::pat(size_t index) const {
     return m_data + index;
 }
 
 template <class T>
-inline T& DynamicArray<T>::operator[](unsigned int index) {
+inline T& DynamicArray<T>::operator[](size_t index) {
     return m_data[index];
 }
 
 template <class T>
-inline const T& DynamicArray<T>::operator[](unsigned int index) const {
+inline const T& DynamicArray<T>::operator[](size_t index) const {
     return m_data[index];
 }
 
@@ -10,6 +10,10 @@
 #define FAST_QUEUE_H
 
 #include "common.h"
+#include "arena.h"
+
+#include <type_traits>
+#include <utility>
 
 template <class T>
 class FastQueue {
@@ -17,84 +21,117 @@ protected:
     T* m_data;
     unsigned int m_head;
     unsigned int m_tail;
-    unsigned int m_capacity;
+    unsigned int m_capacity; // always a power of two; one spot is kept free to tell a full queue from an empty one
+    Arena* m_arena; // allocate from the heap if null
 
+    T* allocate_data(unsigned int capacity) const;
+    void free_data();
     void grow();
+    void reallocate(unsigned int new_capacity);
+    void destruct_all();
+
+    // Moves count items to uninitialized memory, leaving the source uninitialized
+    static void relocate(T* dest, T* src, unsigned int count, std::true_type trivially_copyable);
+    static void relocate(T* dest, T* src, unsigned int count, std::false_type trivially_copyable);
+    static void relocate(T* dest, T* src, unsigned int count);
+
+    static unsigned int round_up_pow2(unsigned int value);
 
 public:
     FastQueue();
     FastQueue(unsigned int init_capacity);
+
+    // Allocates from the arena, which must outlive the queue. Copies of the queue allocate from the heap, while the
+    // arena goes along with the space when moving.
+    FastQueue(Arena& arena, unsigned int init_capacity = 2);
+
     FastQueue(const FastQueue<T>& other);
+    FastQueue(FastQueue<T>&& other);
     FastQueue<T>& operator=(const FastQueue<T>& other);
+    FastQueue<T>& operator=(FastQueue<T>&& other);
     virtual ~FastQueue();
 
     unsigned int size() const;
+    unsigned int capacity() const; // number of items that fit without growing
     bool empty() const;
     void clear(); // preserves space
     void reset(); // frees space
+    void reserve(unsigned int count); // makes room for count items in total
 
     void enqueue(const T& item);
+    void enqueue(T&& item);
     void enqueue2(T item);
 
+    template <class... Args>
+    void emplace(Args&&... args);
+
+    // Appends count items; copied with memcpy if T is trivially copyable
+    void enqueue_range(const T* items, unsigned int count);
+
     void dequeue(T& item_out); // does not check if empty
     T dequeue2(); // does not check if empty
+
+    // Removes up to max_count items into items_out; copied with memcpy if T is trivially copyable. Returns the number
+    // of items removed.
+    unsigned int dequeue_range(T* items_out, unsigned int max_count);
+
+    // Removes the most recently enqueued item, allowing the queue to be used as a stack.
+    void dequeue_back(T& item_out); // does not check if empty
 };
 
 template <class T>
 FastQueue<T>::FastQueue()
-    : m_head(0), m_tail(0), m_capacity(2)
+    : m_head(0), m_tail(0), m_capacity(2), m_arena(nullptr)
 {
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    m_data = allocate_data(m_capacity);
 }
 
 template <class T>
 FastQueue<T>::FastQueue(unsigned int init_capacity)
-    : m_head(0), m_tail(0), m_capacity(init_capacity)
+    : m_head(0), m_tail(0), m_capacity(round_up_pow2(init_capacity)), m_arena(nullptr)
 {
-    if (m_capacity < 2) m_capacity = 2;
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    m_data = allocate_data(m_capacity);
+}
+
+template <class T>
+FastQueue<T>::FastQueue(Arena& arena, unsigned int init_capacity)
+    : m_head(0), m_tail(0), m_capacity(round_up_pow2(init_capacity)), m_arena(&arena)
+{
+    m_data = allocate_data(m_capacity);
 }
 
 template <class T>
 FastQueue<T>::FastQueue(const FastQueue<T>& other)
-    : m_head(other.m_head), m_tail(other.m_tail), m_capacity(other.m_capacity)
+    : m_head(other.m_head), m_tail(other.m_tail), m_capacity(other.m_capacity), m_arena(nullptr)
 {
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    m_data = allocate_data(m_capacity);
 
     // Deep copy
-    unsigned int i;
-    if (m_head > m_tail) {
-        for (i = 0; i < m_tail; ++i)
-            new (m_data + i) T(other.m_data[i]);
-        for (i = m_head; i < m_capacity; ++i)
-            new (m_data + i) T(other.m_data[i]);
-    }
-    else {
-        for (i = m_head; i < m_tail; ++i)
-            new (m_data + i) T(other.m_data[i]);
-    }
+    unsigned int mask = m_capacity - 1;
+    for (unsigned int i = m_head; i != m_tail; i = (i + 1) & mask)
+        new (m_data + i) T(other.m_data[i]);
+}
+
+template <class T>
+FastQueue<T>::FastQueue(FastQueue<T>&& other)
+    : m_data(other.m_data), m_head(other.m_head), m_tail(other.m_tail), m_capacity(other.m_capacity), m_arena(other.m_arena)
+{
+    // Leave the other queue empty, but usable
+    other.m_head = 0;
+    other.m_tail = 0;
+    other.m_capacity = 2;
+    other.m_data = other.allocate_data(other.m_capacity);
 }
 
 template <class T>
 FastQueue<T>& FastQueue<T>::operator=(const FastQueue<T>& other) {
     // Check for self-assignment
     if (this != &other) {
-        unsigned int i;
-
         // Destruct
-        if (m_head > m_tail) {
-            for (i = 0; i < m_tail; ++i)
-                (m_data + i)->~T();
-            for (i = m_head; i < m_capacity; ++i)
-                (m_data + i)->~T();
-        }
-        else {
-            for (i = m_head; i < m_tail; ++i)
-                (m_data + i)->~T();
-        }
+        destruct_all();
 
         // Dispose
-        free(m_data);
+        free_data();
 
         // Assign new data
         m_head = other.m_head;
@@ -102,77 +139,132 @@ FastQueue<T>& FastQueue<T>::operator=(const FastQueue<T>& other) {
         m_capacity = other.m_capacity;
 
         // Allocate
-        m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+        m_data = allocate_data(m_capacity);
 
         // Deep copy
-        if (m_head > m_tail) {
-            for (i = 0; i < m_tail; ++i)
-                new (m_data + i) T(other.m_data[i]);
-            for (i = m_head; i < m_capacity; ++i)
-                new (m_data + i) T(other.m_data[i]);
-        }
-        else {
-            for (i = m_head; i < m_tail; ++i)
-                new (m_data + i) T(other.m_data[i]);
-        }
+        unsigned int mask = m_capacity - 1;
+        for (unsigned int i = m_head; i != m_tail; i = (i + 1) & mask)
+            new (m_data + i) T(other.m_data[i]);
     }
     return *this;
 }
 
 template <class T>
-FastQueue<T>::~FastQueue() {
-    unsigned int i;
+FastQueue<T>& FastQueue<T>::operator=(FastQueue<T>&& other) {
+    if (this != &other) {
+        T* data = m_data;
+        unsigned int capacity = m_capacity;
+        Arena* arena = m_arena;
 
-    // Destruct
-    if (m_head > m_tail) {
-        for (i = 0; i < m_tail; ++i)
-            (m_data + i)->~T();
-        for (i = m_head; i < m_capacity; ++i)
-            (m_data + i)->~T();
-    }
-    else {
-        for (i = m_head; i < m_tail; ++i)
-            (m_data + i)->~T();
+        destruct_all();
+
+        // Take over the other's space and hand it ours
+        m_data = other.m_data;
+        m_head = other.m_head;
+        m_tail = other.m_tail;
+        m_capacity = other.m_capacity;
+        m_arena = other.m_arena;
+
+        other.m_data = data;
+        other.m_head = 0;
+        other.m_tail = 0;
+        other.m_capacity = capacity;
+        other.m_arena = arena;
     }
+    return *this;
+}
+
+template <class T>
+FastQueue<T>::~FastQueue() {
+    // Destruct
+    destruct_all();
 
     // Dispose
-    free(m_data);
+    free_data();
 }
 
 template <class T>
-void FastQueue<T>::grow() {
-    unsigned int next = m_tail + 1;
-
-    // Grow if full
-    if (next == m_head || (next == m_capacity && m_head == 0)) {
-        unsigned int new_cap = m_capacity << 1;
-        T* new_data = reinterpret_cast<T*>(malloc(sizeof(T) * new_cap));
-
-        // Deep copy isn't necessary here
-        if (m_head > m_tail) {
-            memcpy(new_data, m_data + m_head, (m_capacity - m_head) * sizeof(T));
-            memcpy(new_data + (m_capacity - m_head), m_data, m_tail * sizeof(T));
-            m_tail += m_capacity - m_head;
-        }
-        else {
-            memcpy(new_data, m_data + m_head, (m_tail - m_head) * sizeof(T));
-            m_tail -= m_head;
-        }
+inline T* FastQueue<T>::allocate_data(unsigned int capacity) const {
+    if (m_arena != nullptr)
+        return reinterpret_cast<T*>(m_arena->allocate(sizeof(T) * capacity, std::alignment_of<T>::value));
+    else
+        return reinterpret_cast<T*>(malloc(sizeof(T) * capacity));
+}
 
+template <class T>
+inline void FastQueue<T>::free_data() {
+    if (m_arena != nullptr)
+        m_arena->deallocate(m_data, sizeof(T) * m_capacity);
+    else
         free(m_data);
+}
+
+template <class T>
+inline unsigned int FastQueue<T>::round_up_pow2(unsigned int value) {
+    unsigned int capacity = 2;
+    while (capacity < value)
+        capacity <<= 1;
+    return capacity;
+}
+
+template <class T>
+inline void FastQueue<T>::relocate(T* dest, T* src, unsigned int count, std::true_type trivially_copyable) {
+    memcpy((void*)dest, (void*)src, count * sizeof(T));
+}
 
-        m_head = 0;
-        m_capacity = new_cap;
-        m_data = new_data;
+template <class T>
+void FastQueue<T>::relocate(T* dest, T* src, unsigned int count, std::false_type trivially_copyable) {
+    for (unsigned int i = 0; i < count; ++i) {
+        new (dest + i) T(std::move(src[i]));
+        (src + i)->~T();
     }
 }
 
+template <class T>
+inline void FastQueue<T>::relocate(T* dest, T* src, unsigned int count) {
+    relocate(dest, src, count, std::is_trivially_copyable<T>());
+}
+
+template <class T>
+void FastQueue<T>::destruct_all() {
+    unsigned int mask = m_capacity - 1;
+    for (unsigned int i = m_head; i != m_tail; i = (i + 1) & mask)
+        (m_data + i)->~T();
+}
+
+template <class T>
+void FastQueue<T>::reallocate(unsigned int new_capacity) {
+    unsigned int count = size();
+    unsigned int first = m_head <= m_tail ? count : m_capacity - m_head;
+    T* new_data = allocate_data(new_capacity);
+
+    // Unwrap the items to the front of the new space
+    relocate(new_data, m_data + m_head, first);
+    relocate(new_data + first, m_data, count - first);
+
+    free_data();
+
+    m_data = new_data;
+    m_head = 0;
+    m_tail = count;
+    m_capacity = new_capacity;
+}
+
+template <class T>
+inline void FastQueue<T>::grow() {
+    // Grow if full
+    if (((m_tail + 1) & (m_capacity - 1)) == m_head)
+        reallocate(m_capacity << 1);
+}
+
 template <class T>
 inline unsigned int FastQueue<T>::size() const {
-    if (m_head > m_tail)
-        return m_tail + m_capacity - m_head;
-    else
-        return m_tail - m_head;
+    return (m_tail - m_head) & (m_capacity - 1);
+}
+
+template <class T>
+inline unsigned int FastQueue<T>::capacity() const {
+    return m_capacity - 1;
 }
 
 template <class T>
@@ -183,17 +275,7 @@ inline bool FastQueue<T>::empty() const {
 template <class T>
 void FastQueue<T>::clear() {
     // Destruct
-    unsigned int i;
-    if (m_head > m_tail) {
-        for (i = 0; i < m_tail; ++i)
-            (m_data + i)->~T();
-        for (i = m_head; i < m_capacity; ++i)
-            (m_data + i)->~T();
-    }
-    else {
-        for (i = m_head; i < m_tail; ++i)
-            (m_data + i)->~T();
-    }
+    destruct_all();
 
     m_head = 0;
     m_tail = 0;
@@ -203,51 +285,136 @@ template <class T>
 void FastQueue<T>::reset() {
     clear();
 
+    free_data();
     m_capacity = 2;
-    free(m_data);
-    m_data = reinterpret_cast<T*>(malloc(sizeof(T) * m_capacity));
+    m_data = allocate_data(m_capacity);
+}
+
+template <class T>
+void FastQueue<T>::reserve(unsigned int count) {
+    if (count >= m_capacity)
+        reallocate(round_up_pow2(count + 1));
 }
 
 template <class T>
-void FastQueue<T>::enqueue(const T& item) {
+inline void FastQueue<T>::enqueue(const T& item) {
     grow(); // update size if necessary
 
     new (m_data + m_tail) T(item);
 
-    ++m_tail;
-    if (m_tail == m_capacity) m_tail = 0;
+    m_tail = (m_tail + 1) & (m_capacity - 1);
 }
 
 template <class T>
-void FastQueue<T>::enqueue2(T item) {
+inline void FastQueue<T>::enqueue(T&& item) {
+    grow(); // update size if necessary
+
+    new (m_data + m_tail) T(std::move(item));
+
+    m_tail = (m_tail + 1) & (m_capacity - 1);
+}
+
+template <class T>
+inline void FastQueue<T>::enqueue2(T item) {
     grow(); // update size if necessary
 
     new (m_data + m_tail) T(item);
 
-    ++m_tail;
-    if (m_tail == m_capacity) m_tail = 0;
+    m_tail = (m_tail + 1) & (m_capacity - 1);
+}
+
+template <class T>
+template <class... Args>
+inline void FastQueue<T>::emplace(Args&&... args) {
+    grow(); // update size if necessary
+
+    new (m_data + m_tail) T(std::forward<Args>(args)...);
+
+    m_tail = (m_tail + 1) & (m_capacity - 1);
+}
+
+template <class T>
+void FastQueue<T>::enqueue_range(const T* items, unsigned int count) {
+    unsigned int first, i;
+
+    reserve(size() + count);
+
+    // The free space may wrap around the end
+    first = m_capacity - m_tail;
+    if (first > count) first = count;
+
+    if (std::is_trivially_copyable<T>::value) {
+        memcpy((void*)(m_data + m_tail), (const void*)items, first * sizeof(T));
+        memcpy((void*)m_data, (const void*)(items + first), (count - first) * sizeof(T));
+    }
+    else {
+        for (i = 0; i < first; ++i)
+            new (m_data + m_tail + i) T(items[i]);
+        for (i = first; i < count; ++i)
+            new (m_data + i - first) T(items[i]);
+    }
+
+    m_tail = (m_tail + count) & (m_capacity - 1);
 }
 
 template <class T>
-void FastQueue<T>::dequeue(T& item_out) {
-    item_out = m_data[m_head];
+inline void FastQueue<T>::dequeue(T& item_out) {
+    item_out = std::move(m_data[m_head]);
 
     (m_data + m_head)->~T();
 
-    ++m_head;
-    if (m_head == m_capacity) m_head = 0;
+    m_head = (m_head + 1) & (m_capacity - 1);
 }
 
 template <class T>
-T FastQueue<T>::dequeue2() {
-    T k(m_data[m_head]);
+inline T FastQueue<T>::dequeue2() {
+    T k(std::move(m_data[m_head]));
 
     (m_data + m_head)->~T();
 
-    ++m_head;
-    if (m_head == m_capacity) m_head = 0;
+    m_head = (m_head + 1) & (m_capacity - 1);
 
     return k;
 }
 
+template <class T>
+unsigned int FastQueue<T>::dequeue_range(T* items_out, unsigned int max_count) {
+    unsigned int count = size();
+    unsigned int first, i;
+
+    if (count > max_count) count = max_count;
+
+    // The items may wrap around the end
+    first = m_capacity - m_head;
+    if (first > count) first = count;
+
+    if (std::is_trivially_copyable<T>::value) {
+        memcpy((void*)items_out, (const void*)(m_data + m_head), first * sizeof(T));
+        memcpy((void*)(items_out + first), (const void*)m_data, (count - first) * sizeof(T));
+    }
+    else {
+        for (i = 0; i < first; ++i) {
+            items_out[i] = std::move(m_data[m_head + i]);
+            (m_data + m_head + i)->~T();
+        }
+        for (i = first; i < count; ++i) {
+            items_out[i] = std::move(m_data[i - first]);
+            (m_data + i - first)->~T();
+        }
+    }
+
+    m_head = (m_head + count) & (m_capacity - 1);
+
+    return count;
+}
+
+template <class T>
+inline void FastQueue<T>::dequeue_back(T& item_out) {
+    m_tail = (m_tail - 1) & (m_capacity - 1);
+
+    item_out = std::move(m_data[m_tail]);
+
+    (m_data + m_tail)->~T();
+}
+
 #endif  /* FAST_QUEUE_H */
@@ -0,0 +1,582 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+
+#include "common.h"
+
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+// Hashes integers, enums and pointers, such as Ruby VALUEs and window handles, by mixing all their bits, since such
+// keys tend to differ only in their upper bits. Other keys are hashed with std::hash and mixed likewise.
+template <class K>
+struct FlatHash {
+private:
+    // Type-defines
+    typedef std::integral_constant<int, 0> IntegerKey;
+    typedef std::integral_constant<int, 1> PointerKey;
+    typedef std::integral_constant<int, 2> OtherKey;
+    typedef std::integral_constant<int, std::is_pointer<K>::value ? 1 : (std::is_integral<K>::value || std::is_enum<K>::value ? 0 : 2)> KeyKind;
+
+    static uint64_t to_bits(const K& key, IntegerKey kind);
+    static uint64_t to_bits(const K& key, PointerKey kind);
+    static uint64_t to_bits(const K& key, OtherKey kind);
+
+public:
+    size_t operator()(const K& key) const;
+};
+
+// An open-addressing hash table with Robin Hood probing. Entries live in one flat array, next to a compact array holding
+// the distance of every entry from the slot it hashes to. Lookups stop as soon as they pass an entry closer to its home
+// than the key would be, and erasing shifts the following entries back, so no tombstones are left behind.
+// Warning: inserting or erasing invalidates pointers and iterators to entries.
+template <class K, class Entry, class Hash>
+class FlatHashTable {
+public:
+    // Iterates over the entries in slot order
+    template <class E>
+    class IteratorBase {
+    private:
+        E* m_entries;
+        const unsigned short* m_distances;
+        size_t m_index;
+        size_t m_capacity;
+
+    public:
+        IteratorBase(E* entries, const unsigned short* distances, size_t index, size_t capacity);
+
+        E& operator*() const;
+        E* operator->() const;
+        IteratorBase<E>& operator++();
+        bool operator==(const IteratorBase<E>& other) const;
+        bool operator!=(const IteratorBase<E>& other) const;
+    };
+
+    // Type-defines
+    typedef IteratorBase<Entry> Iterator;
+    typedef IteratorBase<const Entry> ConstIterator;
+
+protected:
+    // Constants
+    static const size_t MIN_CAPACITY = 8;
+    static const unsigned short MAX_DISTANCE = 65535;
+
+    // Variables
+    Entry* m_entries;
+    unsigned short* m_distances; // probe distance plus one; zero marks an empty slot
+    size_t m_mask;
+    size_t m_size;
+    size_t m_max_size; // number of entries the table holds before growing, a load factor of 7/8
+    Hash m_hash;
+
+    // Helper Functions
+    void allocate(size_t capacity);
+    void destruct_all();
+    void rehash(size_t new_capacity);
+    size_t find_index(const K& key) const; // returns capacity if not found
+    size_t insert_new(Entry&& entry); // does not check for an existing key; returns the entry's slot
+    bool erase_at(size_t index);
+
+    static size_t capacity_for(size_t count);
+
+public:
+    FlatHashTable();
+    FlatHashTable(size_t init_count);
+    FlatHashTable(const FlatHashTable<K, Entry, Hash>& other);
+    FlatHashTable(FlatHashTable<K, Entry, Hash>&& other);
+    FlatHashTable<K, Entry, Hash>& operator=(const FlatHashTable<K, Entry, Hash>& other);
+    FlatHashTable<K, Entry, Hash>& operator=(FlatHashTable<K, Entry, Hash>&& other);
+    virtual ~FlatHashTable();
+
+    size_t size() const;
+    size_t capacity() const; // number of slots
+    bool empty() const;
+    void clear(); // preserves space
+    void reset(); // frees space
+    void reserve(size_t count); // makes room for count entries without growing
+
+    bool contains(const K& key) const;
+    bool erase(const K& key); // returns false if not found
+
+    Iterator begin();
+    Iterator end();
+    ConstIterator begin() const;
+    ConstIterator end() const;
+};
+
+// Maps keys to values in a FlatHashTable
+template <class K, class V>
+struct FlatHashMapEntry {
+    K m_key;
+    V m_value;
+};
+
+template <class K, class V, class Hash = FlatHash<K>>
+class FlatHashMap : public FlatHashTable<K, FlatHashMapEntry<K, V>, Hash> {
+public:
+    // Type-defines
+    typedef FlatHashMapEntry<K, V> Entry;
+    typedef FlatHashTable<K, Entry, Hash> Table;
+
+    FlatHashMap();
+    FlatHashMap(size_t init_count);
+
+    V* find(const K& key); // returns nullptr if not found
+    const V* find(const K& key) const; // returns nullptr if not found
+
+    // Returns false, leaving the current value, if the key is already present
+    bool insert(const K& key, const V& value);
+
+    // Inserts a default-initialized value if the key is not present
+    V& operator[](const K& key);
+};
+
+// A set of keys in a FlatHashTable
+template <class K>
+struct FlatHashSetEntry {
+    K m_key;
+};
+
+template <class K, class Hash = FlatHash<K>>
+class FlatHashSet : public FlatHashTable<K, FlatHashSetEntry<K>, Hash> {
+public:
+    // Type-defines
+    typedef FlatHashSetEntry<K> Entry;
+    typedef FlatHashTable<K, Entry, Hash> Table;
+
+    FlatHashSet();
+    FlatHashSet(size_t init_count);
+
+    // Returns false if the key is already present
+    bool insert(const K& key);
+};
+
+
+// Define template functions
+
+template <class K>
+inline uint64_t FlatHash<K>::to_bits(const K& key, IntegerKey kind) {
+    return static_cast<uint64_t>(key);
+}
+
+template <class K>
+inline uint64_t FlatHash<K>::to_bits(const K& key, PointerKey kind) {
+    return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key));
+}
+
+template <class K>
+inline uint64_t FlatHash<K>::to_bits(const K& key, OtherKey kind) {
+    return static_cast<uint64_t>(std::hash<K>()(key));
+}
+
+template <class K>
+inline size_t FlatHash<K>::operator()(const K& key) const {
+    // Finalizer of MurmurHash3, which lets every input bit affect the low bits used for indexing
+    uint64_t x = to_bits(key, KeyKind());
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+}
+
+template <class K, class Entry, class Hash>
+template <class E>
+inline FlatHashTable<K, Entry, Hash>::IteratorBase<E>::IteratorBase(E* entries, const unsigned short* distances, size_t index, size_t capacity) :
+    m_entries(entries),
+    m_distances(distances),
+    m_index(index),
+    m_capacity(capacity)
+{
+    while (m_index < m_capacity && m_distances[m_index] == 0)
+        ++m_index;
+}
+
+template <class K, class Entry, class Hash>
+template <class E>
+inline E& FlatHashTable<K, Entry, Hash>::IteratorBase<E>::operator*() const {
+    return m_entries[m_index];
+}
+
+template <class K, class Entry, class Hash>
+template <class E>
+inline E* FlatHashTable<K, Entry, Hash>::IteratorBase<E>::operator->() const {
+    return m_entries + m_index;
+}
+
+template <class K, class Entry, class Hash>
+template <class E>
+inline typename FlatHashTable<K, Entry, Hash>::template IteratorBase<E>& FlatHashTable<K, Entry, Hash>::IteratorBase<E>::operator++() {
+    do {
+        ++m_index;
+    } while (m_index < m_capacity && m_distances[m_index] == 0);
+    return *this;
+}
+
+template <class K, class Entry, class Hash>
+template <class E>
+inline bool FlatHashTable<K, Entry, Hash>::IteratorBase<E>::operator==(const IteratorBase<E>& other) const {
+    return m_index == other.m_index;
+}
+
+template <class K, class Entry, class Hash>
+template <class E>
+inline bool FlatHashTable<K, Entry, Hash>::IteratorBase<E>::operator!=(const IteratorBase<E>& other) const {
+    return m_index != other.m_index;
+}
+
+template <class K, class Entry, class Hash>
+FlatHashTable<K, Entry, Hash>::FlatHashTable() :
+    m_size(0)
+{
+    allocate(MIN_CAPACITY);
+}
+
+template <class K, class Entry, class Hash>
+FlatHashTable<K, Entry, Hash>::FlatHashTable(size_t init_count) :
+    m_size(0)
+{
+    allocate(capacity_for(init_count));
+}
+
+template <class K, class Entry, class Hash>
+FlatHashTable<K, Entry, Hash>::FlatHashTable(const FlatHashTable<K, Entry, Hash>& other) :
+    m_size(other.m_size),
+    m_hash(other.m_hash)
+{
+    size_t i;
+
+    allocate(other.m_mask + 1);
+
+    // Deep copy, keeping every entry in its slot
+    memcpy(m_distances, other.m_distances, sizeof(unsigned short) * (m_mask + 1));
+    for (i = 0; i <= m_mask; ++i)
+        if (m_distances[i] != 0)
+            new (m_entries + i) Entry(other.m_entries[i]);
+}
+
+template <class K, class Entry, class Hash>
+FlatHashTable<K, Entry, Hash>::FlatHashTable(FlatHashTable<K, Entry, Hash>&& other) :
+    m_entries(other.m_entries),
+    m_distances(other.m_distances),
+    m_mask(other.m_mask),
+    m_size(other.m_size),
+    m_max_size(other.m_max_size),
+    m_hash(other.m_hash)
+{
+    // Leave the other table empty, but usable
+    other.m_size = 0;
+    other.allocate(MIN_CAPACITY);
+}
+
+template <class K, class Entry, class Hash>
+FlatHashTable<K, Entry, Hash>& FlatHashTable<K, Entry, Hash>::operator=(const FlatHashTable<K, Entry, Hash>& other) {
+    if (this != &other) {
+        size_t i;
+
+        // Destruct and dispose
+        destruct_all();
+        free(m_entries);
+        free(m_distances);
+
+        // Deep copy, keeping every entry in its slot
+        m_size = other.m_size;
+        m_hash = other.m_hash;
+        allocate(other.m_mask + 1);
+        memcpy(m_distances, other.m_distances, sizeof(unsigned short) * (m_mask + 1));
+        for (i = 0; i <= m_mask; ++i)
+            if (m_distances[i] != 0)
+                new (m_entries + i) Entry(other.m_entries[i]);
+    }
+    return *this;
+}
+
+template <class K, class Entry, class Hash>
+FlatHashTable<K, Entry, Hash>& FlatHashTable<K, Entry, Hash>::operator=(FlatHashTable<K, Entry, Hash>&& other) {
+    if (this != &other) {
+        // Take over the other's space and hand it ours
+        clear();
+        std::swap(m_entries, other.m_entries);
+        std::swap(m_distances, other.m_distances);
+        std::swap(m_mask, other.m_mask);
+        std::swap(m_size, other.m_size);
+        std::swap(m_max_size, other.m_max_size);
+        std::swap(m_hash, other.m_hash);
+    }
+    return *this;
+}
+
+template <class K, class Entry, class Hash>
+FlatHashTable<K, Entry, Hash>::~FlatHashTable() {
+    // Destruct
+    destruct_all();
+
+    // Dispose
+    free(m_entries);
+    free(m_distances);
+}
+
+template <class K, class Entry, class Hash>
+void FlatHashTable<K, Entry, Hash>::allocate(size_t capacity) {
+    m_entries = reinterpret_cast<Entry*>(malloc(sizeof(Entry) * capacity));
+    m_distances = reinterpret_cast<unsigned short*>(calloc(capacity, sizeof(unsigned short)));
+    m_mask = capacity - 1;
+    m_max_size = capacity - capacity / 8;
+}
+
+template <class K, class Entry, class Hash>
+void FlatHashTable<K, Entry, Hash>::destruct_all() {
+    size_t i;
+    for (i = 0; i <= m_mask; ++i)
+        if (m_distances[i] != 0)
+            (m_entries + i)->~Entry();
+}
+
+template <class K, class Entry, class Hash>
+size_t FlatHashTable<K, Entry, Hash>::capacity_for(size_t count) {
+    size_t capacity = MIN_CAPACITY;
+    while (capacity - capacity / 8 < count)
+        capacity <<= 1;
+    return capacity;
+}
+
+template <class K, class Entry, class Hash>
+void FlatHashTable<K, Entry, Hash>::rehash(size_t new_capacity) {
+    size_t i;
+    size_t orig_capacity = m_mask + 1;
+    Entry* orig_entries = m_entries;
+    unsigned short* orig_distances = m_distances;
+
+    allocate(new_capacity);
+    m_size = 0;
+
+    // Move the entries over
+    for (i = 0; i < orig_capacity; ++i) {
+        if (orig_distances[i] != 0) {
+            insert_new(std::move(orig_entries[i]));
+            (orig_entries + i)->~Entry();
+        }
+    }
+
+    free(orig_entries);
+    free(orig_distances);
+}
+
+template <class K, class Entry, class Hash>
+size_t FlatHashTable<K, Entry, Hash>::find_index(const K& key) const {
+    size_t index = m_hash(key) & m_mask;
+    unsigned int distance = 1;
+
+    // An entry closer to its home than the key would be means the key is not there
+    while (m_distances[index] >= distance) {
+        if (m_distances[index] == distance && m_entries[index].m_key == key)
+            return index;
+        index = (index + 1) & m_mask;
+        ++distance;
+    }
+    return m_mask + 1;
+}
+
+template <class K, class Entry, class Hash>
+size_t FlatHashTable<K, Entry, Hash>::insert_new(Entry&& entry) {
+    if (m_size >= m_max_size)
+        rehash((m_mask + 1) << 1);
+
+    Entry carried(std::move(entry));
+    size_t index = m_hash(carried.m_key) & m_mask;
+    size_t placed_at = m_mask + 1;
+    unsigned int distance = 1;
+    unsigned short temp;
+
+    while (true) {
+        if (m_distances[index] == 0) {
+            new (m_entries + index) Entry(std::move(carried));
+            m_distances[index] = static_cast<unsigned short>(distance);
+            ++m_size;
+            return placed_at <= m_mask ? placed_at : index;
+        }
+        // Take the slot from an entry that is closer to its home, and carry that one on instead
+        if (m_distances[index] < distance) {
+            std::swap(carried, m_entries[index]);
+            temp = m_distances[index];
+            m_distances[index] = static_cast<unsigned short>(distance);
+            distance = temp;
+            if (placed_at > m_mask)
+                placed_at = index;
+        }
+        index = (index + 1) & m_mask;
+        ++distance;
+
+        // Grow if a probe sequence gets too long to record, which takes a very poor hash
+        if (distance == MAX_DISTANCE) {
+            K key(placed_at <= m_mask ? m_entries[placed_at].m_key : carried.m_key);
+            rehash((m_mask + 1) << 1);
+            insert_new(std::move(carried));
+            return find_index(key);
+        }
+    }
+}
+
+template <class K, class Entry, class Hash>
+bool FlatHashTable<K, Entry, Hash>::erase_at(size_t index) {
+    size_t next = (index + 1) & m_mask;
+
+    (m_entries + index)->~Entry();
+
+    // Shift the following entries back until one is at its home or a slot is empty
+    while (m_distances[next] > 1) {
+        new (m_entries + index) Entry(std::move(m_entries[next]));
+        (m_entries + next)->~Entry();
+        m_distances[index] = m_distances[next] - 1;
+        index = next;
+        next = (next + 1) & m_mask;
+    }
+    m_distances[index] = 0;
+
+    --m_size;
+    return true;
+}
+
+template <class K, class Entry, class Hash>
+inline size_t FlatHashTable<K, Entry, Hash>::size() const {
+    return m_size;
+}
+
+template <class K, class Entry, class Hash>
+inline size_t FlatHashTable<K, Entry, Hash>::capacity() const {
+    return m_mask + 1;
+}
+
+template <class K, class Entry, class Hash>
+inline bool FlatHashTable<K, Entry, Hash>::empty() const {
+    return m_size == 0;
+}
+
+template <class K, class Entry, class Hash>
+void FlatHashTable<K, Entry, Hash>::clear() {
+    destruct_all();
+    memset(m_distances, 0, sizeof(unsigned short) * (m_mask + 1));
+    m_size = 0;
+}
+
+template <class K, class Entry, class Hash>
+void FlatHashTable<K, Entry, Hash>::reset() {
+    clear();
+
+    free(m_entries);
+    free(m_distances);
+    allocate(MIN_CAPACITY);
+}
+
+template <class K, class Entry, class Hash>
+void FlatHashTable<K, Entry, Hash>::reserve(size_t count) {
+    size_t new_capacity = capacity_for(count);
+    if (new_capacity > m_mask + 1)
+        rehash(new_capacity);
+}
+
+template <class K, class Entry, class Hash>
+inline bool FlatHashTable<K, Entry, Hash>::contains(const K& key) const {
+    return find_index(key) <= m_mask;
+}
+
+template <class K, class Entry, class Hash>
+bool FlatHashTable<K, Entry, Hash>::erase(const K& key) {
+    size_t index = find_index(key);
+    if (index > m_mask) return false;
+    return erase_at(index);
+}
+
+template <class K, class Entry, class Hash>
+inline typename FlatHashTable<K, Entry, Hash>::Iterator FlatHashTable<K, Entry, Hash>::begin() {
+    return Iterator(m_entries, m_distances, 0, m_mask + 1);
+}
+
+template <class K, class Entry, class Hash>
+inline typename FlatHashTable<K, Entry, Hash>::Iterator FlatHashTable<K, Entry, Hash>::end() {
+    return Iterator(m_entries, m_distances, m_mask + 1, m_mask + 1);
+}
+
+template <class K, class Entry, class Hash>
+inline typename FlatHashTable<K, Entry, Hash>::ConstIterator FlatHashTable<K, Entry, Hash>::begin() const {
+    return ConstIterator(m_entries, m_distances, 0, m_mask + 1);
+}
+
+template <class K, class Entry, class Hash>
+inline typename FlatHashTable<K, Entry, Hash>::ConstIterator FlatHashTable<K, Entry, Hash>::end() const {
+    return ConstIterator(m_entries, m_distances, m_mask + 1, m_mask + 1);
+}
+
+template <class K, class V, class Hash>
+FlatHashMap<K, V, Hash>::FlatHashMap() :
+    Table()
+{
+}
+
+template <class K, class V, class Hash>
+FlatHashMap<K, V, Hash>::FlatHashMap(size_t init_count) :
+    Table(init_count)
+{
+}
+
+template <class K, class V, class Hash>
+inline V* FlatHashMap<K, V, Hash>::find(const K& key) {
+    size_t index = this->find_index(key);
+    return index <= this->m_mask ? &this->m_entries[index].m_value : nullptr;
+}
+
+template <class K, class V, class Hash>
+inline const V* FlatHashMap<K, V, Hash>::find(const K& key) const {
+    size_t index = this->find_index(key);
+    return index <= this->m_mask ? &this->m_entries[index].m_value : nullptr;
+}
+
+template <class K, class V, class Hash>
+bool FlatHashMap<K, V, Hash>::insert(const K& key, const V& value) {
+    if (this->find_index(key) <= this->m_mask) return false;
+    Entry entry = { key, value };
+    this->insert_new(std::move(entry));
+    return true;
+}
+
+template <class K, class V, class Hash>
+V& FlatHashMap<K, V, Hash>::operator[](const K& key) {
+    size_t index = this->find_index(key);
+    if (index > this->m_mask) {
+        Entry entry = { key, V() };
+        index = this->insert_new(std::move(entry));
+    }
+    return this->m_entries[index].m_value;
+}
+
+template <class K, class Hash>
+FlatHashSet<K, Hash>::FlatHashSet() :
+    Table()
+{
+}
+
+template <class K, class Hash>
+FlatHashSet<K, Hash>::FlatHashSet(size_t init_count) :
+    Table(init_count)
+{
+}
+
+template <class K, class Hash>
+bool FlatHashSet<K, Hash>::insert(const K& key) {
+    if (this->find_index(key) <= this->m_mask) return false;
+    Entry entry = { key };
+    this->insert_new(std::move(entry));
+    return true;
+}
+
+#endif  /* FLAT_HASH_MAP_H */
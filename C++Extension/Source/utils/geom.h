@@ -52,6 +52,14 @@ namespace Geom {
     class Transformation;
     class Quaternion;
     class BoundingBox;
+    class PointArray;
+    class Vector3f;
+    class Vector4f;
+    class BoundingBoxf;
+    class Transformationf;
+    class Ray;
+    class RayPacket;
+    class BoxPacket;
 
     template <class T>
     class BoxSpace;
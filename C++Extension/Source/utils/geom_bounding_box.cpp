@@ -9,6 +9,7 @@
 #include "geom_bounding_box.h"
 #include "geom_vector3d.h"
 #include "geom_transformation.h"
+#include "geom_ray.h"
 
 
 /*
@@ -149,69 +150,11 @@ bool Geom::BoundingBox::is_within(const BoundingBox& other) const {
 }
 
 bool Geom::BoundingBox::intersects_ray(const Geom::Vector3d& ray_point, const Geom::Vector3d& ray_vector) const {
-    if (is_point_inside(ray_point)) return true;
-
-    Geom::Vector3d v1, v2, pt;
-    treal si;
-
-    v1 = m_min - ray_point;
-    v2 = m_max - ray_point;
-
-    // X-axis normal
-    if (fabs(ray_vector.m_x) > M_EPSILON) {
-        si = v1.m_x / ray_vector.m_x;
-        if (si > (treal)(0.0)) {
-            pt = ray_point + ray_vector.scale(si);
-            if (pt.m_y > m_min.m_y && pt.m_y < m_max.m_y &&
-                pt.m_z > m_min.m_z && pt.m_z < m_max.m_z)
-                return true;
-        }
-        si = v2.m_x / ray_vector.m_x;
-        if (si > (treal)(0.0)) {
-            pt = ray_point + ray_vector.scale(si);
-            if (pt.m_y > m_min.m_y && pt.m_y < m_max.m_y &&
-                pt.m_z > m_min.m_z && pt.m_z < m_max.m_z)
-                return true;
-        }
-    }
-
-    // Y-axis normal
-    if (fabs(ray_vector.m_y) > M_EPSILON) {
-        si = v1.m_y / ray_vector.m_y;
-        if (si > (treal)(0.0)) {
-            pt = ray_point + ray_vector.scale(si);
-            if (pt.m_x > m_min.m_x && pt.m_x < m_max.m_x &&
-                pt.m_z > m_min.m_z && pt.m_z < m_max.m_z)
-                return true;
-        }
-        si = v2.m_y / ray_vector.m_y;
-        if (si > (treal)(0.0)) {
-            pt = ray_point + ray_vector.scale(si);
-            if (pt.m_x > m_min.m_x && pt.m_x < m_max.m_x &&
-                pt.m_z > m_min.m_z && pt.m_z < m_max.m_z)
-                return true;
-        }
-    }
-
-    // Z-axis normal
-    if (fabs(ray_vector.m_z) > M_EPSILON) {
-        si = v1.m_z / ray_vector.m_z;
-        if (si > (treal)(0.0)) {
-            pt = ray_point + ray_vector.scale(si);
-            if (pt.m_x > m_min.m_x && pt.m_x < m_max.m_x &&
-                pt.m_y > m_min.m_y && pt.m_y < m_max.m_y)
-                return true;
-        }
-        si = v2.m_z / ray_vector.m_z;
-        if (si > (treal)(0.0)) {
-            pt = ray_point + ray_vector.scale(si);
-            if (pt.m_x > m_min.m_x && pt.m_x < m_max.m_x &&
-                pt.m_y > m_min.m_y && pt.m_y < m_max.m_y)
-                return true;
-        }
-    }
+    return intersects_ray(Ray(ray_point, ray_vector));
+}
 
-    return false;
+bool Geom::BoundingBox::intersects_ray(const Ray& ray) const {
+    return ray.intersects_bounds(&m_min.m_x, &m_max.m_x);
 }
 
 bool Geom::BoundingBox::intersects_ray(const Geom::Vector3d& ray_point, const Geom::Vector3d& ray_vector, treal cone_angle) const {
@@ -43,6 +43,7 @@ public:
     bool overlaps_with(const BoundingBox& other) const;
     bool is_within(const BoundingBox& other) const;
     bool intersects_ray(const Geom::Vector3d& ray_point, const Geom::Vector3d& ray_vector) const;
+    bool intersects_ray(const Ray& ray) const; // slab test, with the box closed
     bool intersects_ray(const Geom::Vector3d& ray_point, const Geom::Vector3d& ray_vector, treal cone_angle) const; // Assuming ray_vector is normal
     treal get_width() const;
     treal get_height() const;
@@ -11,8 +11,12 @@
 
 #include "geom.h"
 #include "geom_bounding_box.h"
+#include "geom_float.h"
+#include "geom_ray.h"
 #include "fast_queue.h"
 
+// The boxes of items and nodes are stored in single precision, rounded outward, which halves their size and so the
+// memory traffic of the overlap queries. Queries may report a few more overlaps than exact boxes would, never fewer.
 template <class T>
 class Geom::BoxSpace
 {
@@ -20,14 +24,14 @@ public:
     // Structures
     struct Item {
         T m_data;
-        Geom::BoundingBox m_bb;
+        Geom::BoundingBoxf m_bb;
     };
 
     struct Node {
         unsigned int m_head;
         unsigned int m_tail;
         unsigned int m_next;
-        Geom::BoundingBox m_bb;
+        Geom::BoundingBoxf m_bb;
     };
 
     // Callbacks
@@ -169,8 +173,6 @@ Geom::BoxSpace<T>::BoxSpace(const BoxSpace<T>& other) :
 template <class T>
 Geom::BoxSpace<T>& Geom::BoxSpace<T>::operator=(const BoxSpace<T>& other) {
     if (this != &other) {
-        m_nodes = other.m_nodes;
-
         if (m_items)
             free(m_items);
         if (m_nodes)
@@ -248,12 +250,8 @@ void Geom::BoxSpace<T>::add_item(const T& item) {
         while (m_items_capacity <= m_num_items)
             m_items_capacity <<= 1;
 
-        if (m_items) {
-            Item* new_items = reinterpret_cast<Item*>(malloc(sizeof(Item) * m_items_capacity));
-            memcpy(new_items, m_items, sizeof(Item) * m_num_items);
-            free(m_items);
-            m_items = new_items;
-        }
+        if (m_items)
+            m_items = reinterpret_cast<Item*>(realloc(m_items, sizeof(Item) * m_items_capacity));
     }
 
     if (m_items == nullptr) {
@@ -276,7 +274,7 @@ void Geom::BoxSpace<T>::partition_aspects(unsigned int node_index, const char ax
     assert(node.m_bb.m_min[axis] < node.m_bb.m_max[axis]);
 
     // Compute centre
-    treal centre = (node.m_bb.m_min[axis] + node.m_bb.m_max[axis]) * (treal)(0.5);
+    treal centre = ((treal)node.m_bb.m_min[axis] + (treal)node.m_bb.m_max[axis]) * (treal)(0.5);
     // Partition
     // - all boxes with maximums less than centre go left
     // - all boxes with minimums greater than centre go right
@@ -328,13 +326,10 @@ void Geom::BoxSpace<T>::partition_aspects(unsigned int node_index, const char ax
     // Otherwise, create child nodes
     Node* znode;
 
-    // Allocate space for nodes if necessary
+    // Allocate space for nodes if necessary; the arrays are kept across updates, so this only happens as the tree grows
     if (m_num_nodes + 3 > m_nodes_capacity) {
-        znode = m_nodes;
         m_nodes_capacity <<= 1;
-        m_nodes = reinterpret_cast<Node*>(malloc(sizeof(Node) * m_nodes_capacity));
-        memcpy(m_nodes, znode, sizeof(Node) * m_num_nodes);
-        free(znode);
+        m_nodes = reinterpret_cast<Node*>(realloc(m_nodes, sizeof(Node) * m_nodes_capacity));
     }
 
     m_nodes[node_index].m_next = m_num_nodes;
@@ -368,7 +363,7 @@ void Geom::BoxSpace<T>::partition_aspects(unsigned int node_index, const char ax
 
 template <class T>
 void Geom::BoxSpace<T>::get_bounds(Geom::BoundingBox& box_out) const {
-    box_out = m_nodes[0].m_bb;
+    box_out = m_nodes[0].m_bb.to_double();
 }
 
 template <class T>
@@ -378,6 +373,7 @@ void Geom::BoxSpace<T>::update(
     void* user_data)
 {
     Item* item;
+    Geom::BoundingBox bb;
     Geom::Vector3d diff;
     unsigned int i;
     //char axis;
@@ -389,8 +385,10 @@ void Geom::BoxSpace<T>::update(
     m_nodes[0].m_bb.clear();
     for (i = 0; i < m_num_items; ++i) {
         item = m_items + i;
-        box_update_callback(item->m_data, item->m_bb, user_data);
-        item->m_bb.pad_out(margin);
+        bb = item->m_bb.to_double();
+        box_update_callback(item->m_data, bb, user_data);
+        bb.pad_out(margin);
+        item->m_bb = Geom::BoundingBoxf(bb);
         m_nodes[0].m_bb.add(item->m_bb);
     }
 
@@ -400,7 +398,7 @@ void Geom::BoxSpace<T>::update(
         // Divide <=> a node has more than a minimum, required number of nodes
         if (m_nodes[i].m_tail - m_nodes[i].m_head > m_min_items_per_node) {
             // Find an axis with the greatest min/max difference
-            diff = m_nodes[i].m_bb.m_max - m_nodes[i].m_bb.m_min;
+            diff = Geom::Vector3d(m_nodes[i].m_bb.get_width(), m_nodes[i].m_bb.get_height(), m_nodes[i].m_bb.get_depth());
             if (diff.m_x > diff.m_y) {
                 if (diff.m_x > diff.m_z) {
                     if (diff.m_x > M_EPSILON2)
@@ -794,16 +792,17 @@ void Geom::BoxSpace<T>::overlap_with(
     void* user_data) const
 {
     unsigned int i, j;
+    Geom::Ray ray(point, vector);
 
     cq.clear();
-    if (m_nodes[0].m_bb.intersects_ray(point, vector))
+    if (m_nodes[0].m_bb.intersects_ray(ray))
         cq.enqueue2(0);
 
     while (!cq.empty()) {
         i = cq.dequeue2();
         if (m_nodes[i].m_next == 0) {
             for (j = m_nodes[i].m_head; j < m_nodes[i].m_tail; ++j)
-                if (m_items[j].m_bb.intersects_ray(point, vector)) {
+                if (m_items[j].m_bb.intersects_ray(ray)) {
                     assert(m_items[j].m_bb.is_valid());
                     if (!overlap_callback(m_items[j].m_data, user_data))
                         return;
@@ -812,11 +811,11 @@ void Geom::BoxSpace<T>::overlap_with(
         else {
             j = m_nodes[i].m_next;
 
-            if (m_nodes[j].m_bb.intersects_ray(point, vector))
+            if (m_nodes[j].m_bb.intersects_ray(ray))
                 cq.enqueue2(j);
-            if (m_nodes[j + 1].m_bb.intersects_ray(point, vector))
+            if (m_nodes[j + 1].m_bb.intersects_ray(ray))
                 cq.enqueue2(j + 1);
-            if (m_nodes[j + 2].m_bb.intersects_ray(point, vector))
+            if (m_nodes[j + 2].m_bb.intersects_ray(ray))
                 cq.enqueue2(j + 2);
         }
     }
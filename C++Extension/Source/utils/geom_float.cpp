@@ -0,0 +1,181 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#include "geom_float.h"
+#include "geom_ray.h"
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector3f
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::Vector3f::Vector3f()
+    : m_x(0.0f), m_y(0.0f), m_z(0.0f)
+{
+}
+
+Geom::Vector3f::Vector3f(float x, float y, float z)
+    : m_x(x), m_y(y), m_z(z)
+{
+}
+
+Geom::Vector3f::Vector3f(const Vector3d& other)
+    : m_x((float)other.m_x), m_y((float)other.m_y), m_z((float)other.m_z)
+{
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Vector4f
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::Vector4f::Vector4f() :
+    Vector3f(),
+    m_w(0.0f)
+{
+}
+
+Geom::Vector4f::Vector4f(float x, float y, float z, float w) :
+    Vector3f(x, y, z),
+    m_w(w)
+{
+}
+
+Geom::Vector4f::Vector4f(const Vector4d& other) :
+    Vector3f(other),
+    m_w((float)other.m_w)
+{
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  BoundingBoxf
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::BoundingBoxf::BoundingBoxf() {
+    clear();
+}
+
+Geom::BoundingBoxf::BoundingBoxf(const BoundingBox& other) :
+    m_min(round_down(other.m_min.m_x), round_down(other.m_min.m_y), round_down(other.m_min.m_z)),
+    m_max(round_up(other.m_max.m_x), round_up(other.m_max.m_y), round_up(other.m_max.m_z))
+{
+}
+
+float Geom::BoundingBoxf::round_down(treal value) {
+    float res = (float)value;
+    if ((treal)res > value)
+        res = nextafterf(res, -HUGE_VALF);
+    return res;
+}
+
+float Geom::BoundingBoxf::round_up(treal value) {
+    float res = (float)value;
+    if ((treal)res < value)
+        res = nextafterf(res, HUGE_VALF);
+    return res;
+}
+
+Geom::BoundingBoxf& Geom::BoundingBoxf::add(const BoundingBoxf& other) {
+    Geom::min_float2(m_min.m_x, other.m_min.m_x);
+    Geom::min_float2(m_min.m_y, other.m_min.m_y);
+    Geom::min_float2(m_min.m_z, other.m_min.m_z);
+    Geom::max_float2(m_max.m_x, other.m_max.m_x);
+    Geom::max_float2(m_max.m_y, other.m_max.m_y);
+    Geom::max_float2(m_max.m_z, other.m_max.m_z);
+    return *this;
+}
+
+bool Geom::BoundingBoxf::overlaps_with(const BoundingBoxf& other) const {
+    return (other.m_max.m_x > m_min.m_x && other.m_min.m_x < m_max.m_x &&
+            other.m_max.m_y > m_min.m_y && other.m_min.m_y < m_max.m_y &&
+            other.m_max.m_z > m_min.m_z && other.m_min.m_z < m_max.m_z);
+}
+
+bool Geom::BoundingBoxf::overlaps_with(const BoundingBox& other) const {
+    // Compared in treal, into which floats convert exactly
+    return (other.m_max.m_x > m_min.m_x && other.m_min.m_x < m_max.m_x &&
+            other.m_max.m_y > m_min.m_y && other.m_min.m_y < m_max.m_y &&
+            other.m_max.m_z > m_min.m_z && other.m_min.m_z < m_max.m_z);
+}
+
+bool Geom::BoundingBoxf::is_within(const BoundingBox& other) const {
+    return (m_min.m_x > other.m_min.m_x && m_max.m_x < other.m_max.m_x &&
+            m_min.m_y > other.m_min.m_y && m_max.m_y < other.m_max.m_y &&
+            m_min.m_z > other.m_min.m_z && m_max.m_z < other.m_max.m_z);
+}
+
+bool Geom::BoundingBoxf::intersects_ray(const Geom::Vector3d& ray_point, const Geom::Vector3d& ray_vector) const {
+    return intersects_ray(Ray(ray_point, ray_vector));
+}
+
+bool Geom::BoundingBoxf::intersects_ray(const Ray& ray) const {
+    return ray.intersects_bounds(&m_min.m_x, &m_max.m_x);
+}
+
+bool Geom::BoundingBoxf::intersects_ray(const Geom::Vector3d& ray_point, const Geom::Vector3d& ray_vector, treal cone_angle) const {
+    return to_double().intersects_ray(ray_point, ray_vector, cone_angle);
+}
+
+void Geom::BoundingBoxf::clear() {
+    m_min.m_x = m_min.m_y = m_min.m_z = (float)BoundingBox::MAX_VALUE;
+    m_max.m_x = m_max.m_y = m_max.m_z = (float)BoundingBox::MIN_VALUE;
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Transformationf
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::Transformationf::Transformationf() :
+    m_xaxis(1.0f, 0.0f, 0.0f, 0.0f),
+    m_yaxis(0.0f, 1.0f, 0.0f, 0.0f),
+    m_zaxis(0.0f, 0.0f, 1.0f, 0.0f),
+    m_origin(0.0f, 0.0f, 0.0f, 1.0f)
+{
+}
+
+Geom::Transformationf::Transformationf(const Transformation& other) :
+    m_xaxis(other.m_xaxis),
+    m_yaxis(other.m_yaxis),
+    m_zaxis(other.m_zaxis),
+    m_origin(other.m_origin)
+{
+}
+
+Geom::Transformation Geom::Transformationf::to_double() const {
+    return Transformation(m_xaxis.to_double(), m_yaxis.to_double(), m_zaxis.to_double(), m_origin.to_double());
+}
+
+Geom::Vector3f Geom::Transformationf::transform_vector(const Vector3f& v) const {
+    float det;
+    if (fabs(m_origin.m_w) > 1.0e-6f)
+        det = 1.0f / m_origin.m_w;
+    else
+        det = 0.0f;
+
+    return Geom::Vector3f(
+        (m_xaxis.m_x * v.m_x + m_yaxis.m_x * v.m_y + m_zaxis.m_x * v.m_z + m_origin.m_x) * det,
+        (m_xaxis.m_y * v.m_x + m_yaxis.m_y * v.m_y + m_zaxis.m_y * v.m_z + m_origin.m_y) * det,
+        (m_xaxis.m_z * v.m_x + m_yaxis.m_z * v.m_y + m_zaxis.m_z * v.m_z + m_origin.m_z) * det);
+}
+
+Geom::Vector3f Geom::Transformationf::rotate_vector(const Vector3f& v) const {
+    return Geom::Vector3f(
+        m_xaxis.m_x * v.m_x + m_yaxis.m_x * v.m_y + m_zaxis.m_x * v.m_z,
+        m_xaxis.m_y * v.m_x + m_yaxis.m_y * v.m_y + m_zaxis.m_y * v.m_z,
+        m_xaxis.m_z * v.m_x + m_yaxis.m_z * v.m_y + m_zaxis.m_z * v.m_z);
+}
@@ -0,0 +1,142 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef GEOM_FLOAT_H
+#define GEOM_FLOAT_H
+
+#include "geom.h"
+#include "geom_vector3d.h"
+#include "geom_vector4d.h"
+#include "geom_bounding_box.h"
+#include "geom_transformation.h"
+
+// Single-precision twins of the geometry types, for bulk storage such as BVH nodes and mesh buffers, where half the
+// memory bandwidth matters more than precision. They exist alongside the treal types whichever way M_GEOM_USE_DOUBLE
+// is set. Conversions are explicit: vectors and transformations round to the nearest float, while bounding boxes
+// round outward, so that a converted box always contains the original one.
+
+class Geom::Vector3f
+{
+public:
+    // Variables
+    float m_x, m_y, m_z;
+
+    // Constructors
+    Vector3f();
+    Vector3f(float x, float y, float z);
+    explicit Vector3f(const Vector3d& other);
+
+    // Operators
+    float& operator [] (const int index);
+    const float& operator [] (const int index) const;
+
+    // Functions
+    Vector3d to_double() const;
+};
+
+class Geom::Vector4f : public Vector3f
+{
+public:
+    // Variables
+    float m_w;
+
+    // Constructors
+    Vector4f();
+    Vector4f(float x, float y, float z, float w);
+    explicit Vector4f(const Vector4d& other);
+
+    // Functions
+    Vector4d to_double() const;
+};
+
+class Geom::BoundingBoxf
+{
+public:
+    // Variables
+    Vector3f m_min, m_max;
+
+    // Constructors
+    BoundingBoxf(); // cleared
+    explicit BoundingBoxf(const BoundingBox& other); // rounded outward
+
+    // Functions
+    BoundingBox to_double() const; // exact
+    BoundingBoxf& add(const BoundingBoxf& other);
+    bool overlaps_with(const BoundingBoxf& other) const;
+    bool overlaps_with(const BoundingBox& other) const;
+    bool is_within(const BoundingBox& other) const;
+    bool intersects_ray(const Geom::Vector3d& ray_point, const Geom::Vector3d& ray_vector) const;
+    bool intersects_ray(const Ray& ray) const; // slab test, with the box closed
+    bool intersects_ray(const Geom::Vector3d& ray_point, const Geom::Vector3d& ray_vector, treal cone_angle) const; // Assuming ray_vector is normal
+    treal get_width() const;
+    treal get_height() const;
+    treal get_depth() const;
+    void clear();
+    bool is_valid() const;
+
+    // The nearest floats at or below, and at or above, a value
+    static float round_down(treal value);
+    static float round_up(treal value);
+};
+
+class Geom::Transformationf
+{
+public:
+    // Variables
+    Vector4f m_xaxis, m_yaxis, m_zaxis, m_origin;
+
+    // Constructors
+    Transformationf(); // identity
+    explicit Transformationf(const Transformation& other);
+
+    // Functions
+    Transformation to_double() const;
+    Vector3f transform_vector(const Vector3f& v) const; // same as Transformation::transform_vector, in floats
+    Vector3f rotate_vector(const Vector3f& v) const;
+};
+
+
+// Define inline functions
+
+inline float& Geom::Vector3f::operator [] (const int index) {
+    return (&m_x)[index];
+}
+
+inline const float& Geom::Vector3f::operator [] (const int index) const {
+    return (&m_x)[index];
+}
+
+inline Geom::Vector3d Geom::Vector3f::to_double() const {
+    return Vector3d((treal)m_x, (treal)m_y, (treal)m_z);
+}
+
+inline Geom::Vector4d Geom::Vector4f::to_double() const {
+    return Vector4d((treal)m_x, (treal)m_y, (treal)m_z, (treal)m_w);
+}
+
+inline Geom::BoundingBox Geom::BoundingBoxf::to_double() const {
+    return BoundingBox(m_min.to_double(), m_max.to_double());
+}
+
+inline treal Geom::BoundingBoxf::get_width() const {
+    return (treal)m_max.m_x - (treal)m_min.m_x;
+}
+
+inline treal Geom::BoundingBoxf::get_height() const {
+    return (treal)m_max.m_y - (treal)m_min.m_y;
+}
+
+inline treal Geom::BoundingBoxf::get_depth() const {
+    return (treal)m_max.m_z - (treal)m_min.m_z;
+}
+
+inline bool Geom::BoundingBoxf::is_valid() const {
+    return m_max.m_x >= m_min.m_x && m_max.m_y >= m_min.m_y && m_max.m_z >= m_min.m_z;
+}
+
+#endif /* GEOM_FLOAT_H */
@@ -0,0 +1,453 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#include "geom_point_array.h"
+
+#include <limits>
+
+#ifdef _MSC_VER
+    #include <malloc.h>
+#endif
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Constants
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+const size_t Geom::PointArray::ALIGNMENT = 64;
+const size_t Geom::PointArray::LANE_PADDING = 64 / sizeof(treal);
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  SIMD Helpers
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+// SSE2 registers of treal; loads and stores are aligned, except for vreal_storeu
+
+#ifdef M_GEOM_USE_DOUBLE
+
+typedef __m128d vreal;
+static const size_t VREAL_WIDTH = 2;
+
+static inline vreal vreal_load(const treal* p) { return _mm_load_pd(p); }
+static inline void vreal_store(treal* p, vreal a) { _mm_store_pd(p, a); }
+static inline void vreal_storeu(treal* p, vreal a) { _mm_storeu_pd(p, a); }
+static inline vreal vreal_set1(treal a) { return _mm_set1_pd(a); }
+static inline vreal vreal_add(vreal a, vreal b) { return _mm_add_pd(a, b); }
+static inline vreal vreal_sub(vreal a, vreal b) { return _mm_sub_pd(a, b); }
+static inline vreal vreal_mul(vreal a, vreal b) { return _mm_mul_pd(a, b); }
+static inline vreal vreal_min(vreal a, vreal b) { return _mm_min_pd(a, b); }
+static inline vreal vreal_max(vreal a, vreal b) { return _mm_max_pd(a, b); }
+static inline int vreal_less_mask(vreal a, vreal b) { return _mm_movemask_pd(_mm_cmplt_pd(a, b)); }
+
+#else
+
+typedef __m128 vreal;
+static const size_t VREAL_WIDTH = 4;
+
+static inline vreal vreal_load(const treal* p) { return _mm_load_ps(p); }
+static inline void vreal_store(treal* p, vreal a) { _mm_store_ps(p, a); }
+static inline void vreal_storeu(treal* p, vreal a) { _mm_storeu_ps(p, a); }
+static inline vreal vreal_set1(treal a) { return _mm_set1_ps(a); }
+static inline vreal vreal_add(vreal a, vreal b) { return _mm_add_ps(a, b); }
+static inline vreal vreal_sub(vreal a, vreal b) { return _mm_sub_ps(a, b); }
+static inline vreal vreal_mul(vreal a, vreal b) { return _mm_mul_ps(a, b); }
+static inline vreal vreal_min(vreal a, vreal b) { return _mm_min_ps(a, b); }
+static inline vreal vreal_max(vreal a, vreal b) { return _mm_max_ps(a, b); }
+static inline int vreal_less_mask(vreal a, vreal b) { return _mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+
+#endif
+
+static inline treal vreal_hmin(vreal a) {
+    treal lanes[VREAL_WIDTH];
+    vreal_storeu(lanes, a);
+    treal res = lanes[0];
+    for (size_t k = 1; k < VREAL_WIDTH; ++k)
+        Geom::min_treal2(res, lanes[k]);
+    return res;
+}
+
+static inline treal vreal_hmax(vreal a) {
+    treal lanes[VREAL_WIDTH];
+    vreal_storeu(lanes, a);
+    treal res = lanes[0];
+    for (size_t k = 1; k < VREAL_WIDTH; ++k)
+        Geom::max_treal2(res, lanes[k]);
+    return res;
+}
+
+static inline treal vreal_hsum(vreal a) {
+    treal lanes[VREAL_WIDTH];
+    vreal_storeu(lanes, a);
+    treal res = lanes[0];
+    for (size_t k = 1; k < VREAL_WIDTH; ++k)
+        res += lanes[k];
+    return res;
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Helper Functions
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+treal* Geom::PointArray::allocate_data(size_t capacity) {
+    size_t size = sizeof(treal) * capacity * 3;
+    void* data;
+#ifdef _MSC_VER
+    data = _aligned_malloc(size, ALIGNMENT);
+#else
+    if (posix_memalign(&data, ALIGNMENT, size) != 0)
+        data = nullptr;
+#endif
+    memset(data, 0, size);
+    return reinterpret_cast<treal*>(data);
+}
+
+void Geom::PointArray::free_data(treal* data) {
+#ifdef _MSC_VER
+    _aligned_free(data);
+#else
+    free(data);
+#endif
+}
+
+void Geom::PointArray::reallocate(size_t new_capacity) {
+    treal* new_data;
+
+    new_capacity = Geom::round_up(LANE_PADDING, new_capacity);
+    new_data = allocate_data(new_capacity);
+
+    // Lanes move to new offsets, so each is copied separately
+    memcpy(new_data, m_data, sizeof(treal) * m_size);
+    memcpy(new_data + new_capacity, m_data + m_capacity, sizeof(treal) * m_size);
+    memcpy(new_data + new_capacity * 2, m_data + m_capacity * 2, sizeof(treal) * m_size);
+
+    free_data(m_data);
+    m_data = new_data;
+    m_capacity = new_capacity;
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Constructors
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::PointArray::PointArray() :
+    m_size(0),
+    m_capacity(LANE_PADDING)
+{
+    m_data = allocate_data(m_capacity);
+}
+
+Geom::PointArray::PointArray(size_t init_capacity) :
+    m_size(0),
+    m_capacity(Geom::round_up(LANE_PADDING, init_capacity))
+{
+    m_data = allocate_data(m_capacity);
+}
+
+Geom::PointArray::PointArray(const PointArray& other) :
+    m_size(other.m_size),
+    m_capacity(other.m_capacity)
+{
+    m_data = allocate_data(m_capacity);
+    memcpy(m_data, other.m_data, sizeof(treal) * m_capacity * 3);
+}
+
+Geom::PointArray::PointArray(PointArray&& other) :
+    m_data(other.m_data),
+    m_size(other.m_size),
+    m_capacity(other.m_capacity)
+{
+    other.m_size = 0;
+    other.m_capacity = LANE_PADDING;
+    other.m_data = allocate_data(other.m_capacity);
+}
+
+Geom::PointArray::PointArray(const DynamicArray<Vector3d>& points) :
+    m_size(0),
+    m_capacity(Geom::round_up(LANE_PADDING, points.size()))
+{
+    m_data = allocate_data(m_capacity);
+    assign(points);
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Destructor
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::PointArray::~PointArray() {
+    free_data(m_data);
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Operators
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::PointArray& Geom::PointArray::operator = (const PointArray& other) {
+    if (this != &other) {
+        free_data(m_data);
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        m_data = allocate_data(m_capacity);
+        memcpy(m_data, other.m_data, sizeof(treal) * m_capacity * 3);
+    }
+    return *this;
+}
+
+Geom::PointArray& Geom::PointArray::operator = (PointArray&& other) {
+    if (this != &other) {
+        // Hand this storage over to the other, which ends up empty
+        treal* data = m_data;
+        size_t capacity = m_capacity;
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        other.m_data = data;
+        other.m_capacity = capacity;
+        other.clear();
+    }
+    return *this;
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Functions
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+void Geom::PointArray::clear() {
+    memset(m_data, 0, sizeof(treal) * m_capacity * 3);
+    m_size = 0;
+}
+
+void Geom::PointArray::reserve(size_t count) {
+    if (count > m_capacity)
+        reallocate(count);
+}
+
+void Geom::PointArray::resize(size_t count) {
+    if (count > m_capacity)
+        reallocate(count);
+    else if (count < m_size) {
+        // Restore the zero padding
+        memset(m_data + count, 0, sizeof(treal) * (m_size - count));
+        memset(m_data + m_capacity + count, 0, sizeof(treal) * (m_size - count));
+        memset(m_data + m_capacity * 2 + count, 0, sizeof(treal) * (m_size - count));
+    }
+    m_size = count;
+}
+
+void Geom::PointArray::assign(const Vector3d* points, size_t count) {
+    treal* xs;
+    treal* ys;
+    treal* zs;
+
+    clear();
+    reserve(count);
+
+    xs = get_xs();
+    ys = get_ys();
+    zs = get_zs();
+    for (size_t i = 0; i < count; ++i) {
+        xs[i] = points[i].m_x;
+        ys[i] = points[i].m_y;
+        zs[i] = points[i].m_z;
+    }
+    m_size = count;
+}
+
+void Geom::PointArray::assign(const DynamicArray<Vector3d>& points) {
+    if (points.empty())
+        clear();
+    else
+        assign(points.pat(0), points.size());
+}
+
+void Geom::PointArray::copy_to(DynamicArray<Vector3d>& points_out) const {
+    const treal* xs = get_xs();
+    const treal* ys = get_ys();
+    const treal* zs = get_zs();
+
+    points_out.resize(m_size);
+    for (size_t i = 0; i < m_size; ++i) {
+        Vector3d& point = points_out[i];
+        point.m_x = xs[i];
+        point.m_y = ys[i];
+        point.m_z = zs[i];
+    }
+}
+
+void Geom::PointArray::transform_self(const Transformation& tra) {
+    transform(tra, *this);
+}
+
+void Geom::PointArray::transform(const Transformation& tra, PointArray& points_out) const {
+    size_t i;
+    treal det = tra.get_determinant();
+
+    // Fold the w factor into the matrix
+    vreal m00 = vreal_set1(tra.m_xaxis.m_x * det), m01 = vreal_set1(tra.m_yaxis.m_x * det), m02 = vreal_set1(tra.m_zaxis.m_x * det), m03 = vreal_set1(tra.m_origin.m_x * det);
+    vreal m10 = vreal_set1(tra.m_xaxis.m_y * det), m11 = vreal_set1(tra.m_yaxis.m_y * det), m12 = vreal_set1(tra.m_zaxis.m_y * det), m13 = vreal_set1(tra.m_origin.m_y * det);
+    vreal m20 = vreal_set1(tra.m_xaxis.m_z * det), m21 = vreal_set1(tra.m_yaxis.m_z * det), m22 = vreal_set1(tra.m_zaxis.m_z * det), m23 = vreal_set1(tra.m_origin.m_z * det);
+
+    if (&points_out != this) {
+        points_out.clear();
+        points_out.reserve(m_size);
+    }
+
+    const treal* xs = get_xs();
+    const treal* ys = get_ys();
+    const treal* zs = get_zs();
+    treal* oxs = points_out.get_xs();
+    treal* oys = points_out.get_ys();
+    treal* ozs = points_out.get_zs();
+
+    // The lanes are padded, so the last vector can be processed whole; its padding is zeroed again below
+    for (i = 0; i < m_size; i += VREAL_WIDTH) {
+        vreal x = vreal_load(xs + i);
+        vreal y = vreal_load(ys + i);
+        vreal z = vreal_load(zs + i);
+        vreal_store(oxs + i, vreal_add(vreal_add(vreal_mul(m00, x), vreal_mul(m01, y)), vreal_add(vreal_mul(m02, z), m03)));
+        vreal_store(oys + i, vreal_add(vreal_add(vreal_mul(m10, x), vreal_mul(m11, y)), vreal_add(vreal_mul(m12, z), m13)));
+        vreal_store(ozs + i, vreal_add(vreal_add(vreal_mul(m20, x), vreal_mul(m21, y)), vreal_add(vreal_mul(m22, z), m23)));
+    }
+    for (i = m_size; i < m_size + (VREAL_WIDTH - m_size % VREAL_WIDTH) % VREAL_WIDTH; ++i) {
+        oxs[i] = (treal)(0.0);
+        oys[i] = (treal)(0.0);
+        ozs[i] = (treal)(0.0);
+    }
+
+    points_out.m_size = m_size;
+}
+
+void Geom::PointArray::get_bounding_box(BoundingBox& bb_out) const {
+    size_t i;
+    size_t n = m_size - m_size % VREAL_WIDTH;
+    const treal* xs = get_xs();
+    const treal* ys = get_ys();
+    const treal* zs = get_zs();
+    vreal min_x, min_y, min_z, max_x, max_y, max_z;
+
+    bb_out.clear();
+
+    min_x = min_y = min_z = vreal_set1(BoundingBox::MAX_VALUE);
+    max_x = max_y = max_z = vreal_set1(BoundingBox::MIN_VALUE);
+    for (i = 0; i < n; i += VREAL_WIDTH) {
+        vreal x = vreal_load(xs + i);
+        vreal y = vreal_load(ys + i);
+        vreal z = vreal_load(zs + i);
+        min_x = vreal_min(min_x, x);
+        min_y = vreal_min(min_y, y);
+        min_z = vreal_min(min_z, z);
+        max_x = vreal_max(max_x, x);
+        max_y = vreal_max(max_y, y);
+        max_z = vreal_max(max_z, z);
+    }
+
+    bb_out.m_min.m_x = vreal_hmin(min_x);
+    bb_out.m_min.m_y = vreal_hmin(min_y);
+    bb_out.m_min.m_z = vreal_hmin(min_z);
+    bb_out.m_max.m_x = vreal_hmax(max_x);
+    bb_out.m_max.m_y = vreal_hmax(max_y);
+    bb_out.m_max.m_z = vreal_hmax(max_z);
+
+    // Remaining points; the padding is zero and must not be included
+    for (; i < m_size; ++i)
+        bb_out.add(Vector3d(xs[i], ys[i], zs[i]));
+}
+
+void Geom::PointArray::get_centroid(Vector3d& centroid_out) const {
+    size_t i;
+    const treal* xs = get_xs();
+    const treal* ys = get_ys();
+    const treal* zs = get_zs();
+    vreal sum_x, sum_y, sum_z;
+
+    if (m_size == 0) {
+        centroid_out = Vector3d::ORIGIN;
+        return;
+    }
+
+    // The zero padding does not affect the sums
+    sum_x = sum_y = sum_z = vreal_set1((treal)(0.0));
+    for (i = 0; i < m_size; i += VREAL_WIDTH) {
+        sum_x = vreal_add(sum_x, vreal_load(xs + i));
+        sum_y = vreal_add(sum_y, vreal_load(ys + i));
+        sum_z = vreal_add(sum_z, vreal_load(zs + i));
+    }
+
+    centroid_out.m_x = vreal_hsum(sum_x);
+    centroid_out.m_y = vreal_hsum(sum_y);
+    centroid_out.m_z = vreal_hsum(sum_z);
+    centroid_out.scale_self((treal)(1.0) / (treal)(m_size));
+}
+
+size_t Geom::PointArray::find_nearest(const Vector3d& point, treal* dist_sq_out) const {
+    size_t i, k;
+    size_t n = m_size - m_size % VREAL_WIDTH;
+    size_t best_index = m_size;
+    treal best_dist_sq = std::numeric_limits<treal>::max();
+    treal lanes[VREAL_WIDTH];
+    const treal* xs = get_xs();
+    const treal* ys = get_ys();
+    const treal* zs = get_zs();
+    vreal px = vreal_set1(point.m_x);
+    vreal py = vreal_set1(point.m_y);
+    vreal pz = vreal_set1(point.m_z);
+    vreal best = vreal_set1(best_dist_sq);
+
+    for (i = 0; i < n; i += VREAL_WIDTH) {
+        vreal dx = vreal_sub(vreal_load(xs + i), px);
+        vreal dy = vreal_sub(vreal_load(ys + i), py);
+        vreal dz = vreal_sub(vreal_load(zs + i), pz);
+        vreal d = vreal_add(vreal_add(vreal_mul(dx, dx), vreal_mul(dy, dy)), vreal_mul(dz, dz));
+
+        // Closer points become rare as the search goes on, so they are resolved one lane at a time
+        if (vreal_less_mask(d, best) != 0) {
+            vreal_storeu(lanes, d);
+            for (k = 0; k < VREAL_WIDTH; ++k) {
+                if (lanes[k] < best_dist_sq) {
+                    best_dist_sq = lanes[k];
+                    best_index = i + k;
+                }
+            }
+            best = vreal_set1(best_dist_sq);
+        }
+    }
+
+    for (; i < m_size; ++i) {
+        treal dx = xs[i] - point.m_x;
+        treal dy = ys[i] - point.m_y;
+        treal dz = zs[i] - point.m_z;
+        treal d = dx * dx + dy * dy + dz * dz;
+        if (d < best_dist_sq) {
+            best_dist_sq = d;
+            best_index = i;
+        }
+    }
+
+    if (dist_sq_out != nullptr && best_index != m_size)
+        *dist_sq_out = best_dist_sq;
+    return best_index;
+}
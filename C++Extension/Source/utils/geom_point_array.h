@@ -0,0 +1,152 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef GEOM_POINT_ARRAY_H
+#define GEOM_POINT_ARRAY_H
+
+#include "geom.h"
+#include "geom_vector3d.h"
+#include "geom_transformation.h"
+#include "geom_bounding_box.h"
+#include "dynamic_array.h"
+
+// An array of points kept as separate x, y, and z lanes, so that batch operations over many points can process several
+// coordinates per SIMD instruction. Each lane starts on a cache line and the capacity is a multiple of LANE_PADDING,
+// so whole vectors can always be loaded from the lanes; the padding past the size is kept at zero.
+class Geom::PointArray
+{
+public:
+    // Constants
+    static const size_t ALIGNMENT; // in bytes
+    static const size_t LANE_PADDING; // in coordinates
+
+private:
+    // Variables
+    treal* m_data; // the three lanes, one after another
+    size_t m_size;
+    size_t m_capacity; // per lane
+
+    // Helper Functions
+    void reallocate(size_t new_capacity);
+
+    static treal* allocate_data(size_t capacity);
+    static void free_data(treal* data);
+
+public:
+    // Constructors
+    PointArray();
+    PointArray(size_t init_capacity);
+    PointArray(const PointArray& other);
+    PointArray(PointArray&& other);
+    PointArray(const DynamicArray<Vector3d>& points);
+
+    // Destructor
+    virtual ~PointArray();
+
+    // Operators
+    PointArray& operator = (const PointArray& other);
+    PointArray& operator = (PointArray&& other);
+
+    // Functions
+    size_t size() const;
+    size_t capacity() const;
+    bool empty() const;
+    void clear(); // preserves space
+
+    // Makes room for count points in total, without changing the size
+    void reserve(size_t count);
+
+    // New points are placed at the origin
+    void resize(size_t count);
+
+    void append(const Vector3d& point);
+    Vector3d get_at(size_t index) const;
+    void set_at(size_t index, const Vector3d& point);
+
+    // Conversion from and to arrays of points
+    void assign(const Vector3d* points, size_t count);
+    void assign(const DynamicArray<Vector3d>& points);
+    void copy_to(DynamicArray<Vector3d>& points_out) const; // replaces the contents
+
+    // Lanes, aligned to ALIGNMENT and readable up to capacity()
+    treal* get_xs();
+    treal* get_ys();
+    treal* get_zs();
+    const treal* get_xs() const;
+    const treal* get_ys() const;
+    const treal* get_zs() const;
+
+    // Batch operations
+    void transform_self(const Transformation& tra); // same as Transformation::transform_vector on each point
+    void transform(const Transformation& tra, PointArray& points_out) const;
+    void get_bounding_box(BoundingBox& bb_out) const; // cleared if there are no points
+    void get_centroid(Vector3d& centroid_out) const; // origin if there are no points
+
+    // Returns the index of the point closest to the given one, the first one among ties, or size() if there are no points
+    size_t find_nearest(const Vector3d& point, treal* dist_sq_out = nullptr) const;
+};
+
+
+// Define inline functions
+
+inline size_t Geom::PointArray::size() const {
+    return m_size;
+}
+
+inline size_t Geom::PointArray::capacity() const {
+    return m_capacity;
+}
+
+inline bool Geom::PointArray::empty() const {
+    return m_size == 0;
+}
+
+inline treal* Geom::PointArray::get_xs() {
+    return m_data;
+}
+
+inline treal* Geom::PointArray::get_ys() {
+    return m_data + m_capacity;
+}
+
+inline treal* Geom::PointArray::get_zs() {
+    return m_data + m_capacity * 2;
+}
+
+inline const treal* Geom::PointArray::get_xs() const {
+    return m_data;
+}
+
+inline const treal* Geom::PointArray::get_ys() const {
+    return m_data + m_capacity;
+}
+
+inline const treal* Geom::PointArray::get_zs() const {
+    return m_data + m_capacity * 2;
+}
+
+inline void Geom::PointArray::append(const Vector3d& point) {
+    if (m_size == m_capacity)
+        reallocate(m_capacity << 1);
+    m_data[m_size] = point.m_x;
+    m_data[m_capacity + m_size] = point.m_y;
+    m_data[m_capacity * 2 + m_size] = point.m_z;
+    ++m_size;
+}
+
+inline Geom::Vector3d Geom::PointArray::get_at(size_t index) const {
+    return Vector3d(m_data[index], m_data[m_capacity + index], m_data[m_capacity * 2 + index]);
+}
+
+inline void Geom::PointArray::set_at(size_t index, const Vector3d& point) {
+    m_data[index] = point.m_x;
+    m_data[m_capacity + index] = point.m_y;
+    m_data[m_capacity * 2 + index] = point.m_z;
+}
+
+#endif /* GEOM_POINT_ARRAY_H */
@@ -0,0 +1,277 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#include "geom_ray.h"
+#include "cpu_features.h"
+
+#ifdef M_GEOM_USE_DOUBLE
+    #include <immintrin.h>
+#endif
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Ray
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::Ray::Ray() :
+    m_inv_vector(std::numeric_limits<treal>::infinity())
+{
+}
+
+Geom::Ray::Ray(const Vector3d& point, const Vector3d& vector) {
+    set(point, vector);
+}
+
+void Geom::Ray::set(const Vector3d& point, const Vector3d& vector) {
+    m_point = point;
+    m_vector = vector;
+    m_inv_vector.m_x = (treal)(1.0) / vector.m_x;
+    m_inv_vector.m_y = (treal)(1.0) / vector.m_y;
+    m_inv_vector.m_z = (treal)(1.0) / vector.m_z;
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Packet Kernels
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+// Each kernel runs the slab test of Ray::intersects_bounds on several lanes, with the same operations in the same order,
+// so that every lane agrees with the scalar test exactly. Both distances are computed per axis, then the entry and exit
+// ones are selected by the sign of the reciprocal, as the signs may differ between rays. The boxes are either packed in
+// lanes (BOX_LANES), against one ray, or one box is tested against rays packed in lanes. Packed values are arrays of
+// WIDTH lanes per axis; the single box or ray is given as three coordinates.
+
+static const unsigned int PACKET_WIDTH = Geom::BoxPacket::WIDTH;
+
+static_assert(Geom::BoxPacket::WIDTH == Geom::RayPacket::WIDTH, "The kernels handle both packets alike");
+
+template <bool BOX_LANES>
+static unsigned int slab_scalar(const treal* mins, const treal* maxs, const treal* points, const treal* inv_vectors, unsigned int size) {
+    unsigned int lane, i;
+    unsigned int res = 0;
+    treal min[3], max[3];
+    Geom::Ray ray;
+
+    for (lane = 0; lane < size; ++lane) {
+        for (i = 0; i < 3; ++i) {
+            if (BOX_LANES) {
+                min[i] = mins[i * PACKET_WIDTH + lane];
+                max[i] = maxs[i * PACKET_WIDTH + lane];
+                ray.m_point[i] = points[i];
+                ray.m_inv_vector[i] = inv_vectors[i];
+            }
+            else {
+                min[i] = mins[i];
+                max[i] = maxs[i];
+                ray.m_point[i] = points[i * PACKET_WIDTH + lane];
+                ray.m_inv_vector[i] = inv_vectors[i * PACKET_WIDTH + lane];
+            }
+        }
+        if (ray.intersects_bounds(min, max))
+            res |= 1u << lane;
+    }
+
+    return res;
+}
+
+#ifdef M_GEOM_USE_DOUBLE
+
+// Two lanes per register
+template <bool PACKED>
+static inline __m128d load_lanes_sse2(const treal* values, unsigned int axis, unsigned int lane) {
+    return PACKED ? _mm_loadu_pd(values + axis * PACKET_WIDTH + lane) : _mm_set1_pd(values[axis]);
+}
+
+template <bool BOX_LANES>
+static unsigned int slab_sse2(const treal* mins, const treal* maxs, const treal* points, const treal* inv_vectors, unsigned int size) {
+    const __m128d zero = _mm_setzero_pd();
+    unsigned int lane, i;
+    unsigned int res = 0;
+
+    for (lane = 0; lane < size; lane += 2) {
+        __m128d t_near = _mm_setzero_pd();
+        __m128d t_far = _mm_set1_pd(std::numeric_limits<treal>::max());
+        for (i = 0; i < 3; ++i) {
+            __m128d p = load_lanes_sse2<!BOX_LANES>(points, i, lane);
+            __m128d inv = load_lanes_sse2<!BOX_LANES>(inv_vectors, i, lane);
+            __m128d t_min = _mm_mul_pd(_mm_sub_pd(load_lanes_sse2<BOX_LANES>(mins, i, lane), p), inv);
+            __m128d t_max = _mm_mul_pd(_mm_sub_pd(load_lanes_sse2<BOX_LANES>(maxs, i, lane), p), inv);
+            __m128d neg = _mm_cmplt_pd(inv, zero);
+            __m128d t1 = _mm_or_pd(_mm_and_pd(neg, t_max), _mm_andnot_pd(neg, t_min));
+            __m128d t2 = _mm_or_pd(_mm_and_pd(neg, t_min), _mm_andnot_pd(neg, t_max));
+            t_near = _mm_max_pd(t1, t_near);
+            t_far = _mm_min_pd(t2, t_far);
+        }
+        res |= (unsigned int)_mm_movemask_pd(_mm_cmple_pd(t_near, t_far)) << lane;
+    }
+
+    return res;
+}
+
+// Four lanes per register
+template <bool PACKED>
+M_TARGET_AVX static inline __m256d load_lanes_avx(const treal* values, unsigned int axis, unsigned int lane) {
+    return PACKED ? _mm256_loadu_pd(values + axis * PACKET_WIDTH + lane) : _mm256_set1_pd(values[axis]);
+}
+
+template <bool BOX_LANES>
+M_TARGET_AVX static unsigned int slab_avx(const treal* mins, const treal* maxs, const treal* points, const treal* inv_vectors, unsigned int size) {
+    unsigned int lane, i;
+    unsigned int res = 0;
+
+    for (lane = 0; lane < size; lane += 4) {
+        __m256d t_near = _mm256_setzero_pd();
+        __m256d t_far = _mm256_set1_pd(std::numeric_limits<treal>::max());
+        for (i = 0; i < 3; ++i) {
+            __m256d p = load_lanes_avx<!BOX_LANES>(points, i, lane);
+            __m256d inv = load_lanes_avx<!BOX_LANES>(inv_vectors, i, lane);
+            __m256d t_min = _mm256_mul_pd(_mm256_sub_pd(load_lanes_avx<BOX_LANES>(mins, i, lane), p), inv);
+            __m256d t_max = _mm256_mul_pd(_mm256_sub_pd(load_lanes_avx<BOX_LANES>(maxs, i, lane), p), inv);
+            __m256d neg = _mm256_cmp_pd(inv, _mm256_setzero_pd(), _CMP_LT_OQ);
+            __m256d t1 = _mm256_blendv_pd(t_min, t_max, neg);
+            __m256d t2 = _mm256_blendv_pd(t_max, t_min, neg);
+            t_near = _mm256_max_pd(t1, t_near);
+            t_far = _mm256_min_pd(t2, t_far);
+        }
+        res |= (unsigned int)_mm256_movemask_pd(_mm256_cmp_pd(t_near, t_far, _CMP_LE_OQ)) << lane;
+    }
+
+    return res;
+}
+
+// All eight lanes in one register
+template <bool PACKED>
+M_TARGET_AVX512 static inline __m512d load_lanes_avx512(const treal* values, unsigned int axis) {
+    return PACKED ? _mm512_loadu_pd(values + axis * PACKET_WIDTH) : _mm512_set1_pd(values[axis]);
+}
+
+template <bool BOX_LANES>
+M_TARGET_AVX512 static unsigned int slab_avx512(const treal* mins, const treal* maxs, const treal* points, const treal* inv_vectors, unsigned int size) {
+    static_assert(PACKET_WIDTH == 8, "One register holds all lanes");
+    __m512d t_near = _mm512_setzero_pd();
+    __m512d t_far = _mm512_set1_pd(std::numeric_limits<treal>::max());
+    unsigned int i;
+
+    for (i = 0; i < 3; ++i) {
+        __m512d p = load_lanes_avx512<!BOX_LANES>(points, i);
+        __m512d inv = load_lanes_avx512<!BOX_LANES>(inv_vectors, i);
+        __m512d t_min = _mm512_mul_pd(_mm512_sub_pd(load_lanes_avx512<BOX_LANES>(mins, i), p), inv);
+        __m512d t_max = _mm512_mul_pd(_mm512_sub_pd(load_lanes_avx512<BOX_LANES>(maxs, i), p), inv);
+        __mmask8 neg = _mm512_cmp_pd_mask(inv, _mm512_setzero_pd(), _CMP_LT_OQ);
+        __m512d t1 = _mm512_mask_blend_pd(neg, t_min, t_max);
+        __m512d t2 = _mm512_mask_blend_pd(neg, t_max, t_min);
+        t_near = _mm512_max_pd(t1, t_near);
+        t_far = _mm512_min_pd(t2, t_far);
+    }
+
+    return (unsigned int)_mm512_cmp_pd_mask(t_near, t_far, _CMP_LE_OQ) & ((1u << size) - 1);
+}
+
+#endif
+
+// Lanes at and past size are ignored; their results may be set by the kernels and are masked out here
+template <bool BOX_LANES>
+static unsigned int slab_packet(const treal* mins, const treal* maxs, const treal* points, const treal* inv_vectors, unsigned int size) {
+    if (size == 0) return 0;
+#ifdef M_GEOM_USE_DOUBLE
+    switch (CpuFeatures::get_simd_level()) {
+        case CpuFeatures::SIMD_AVX512:
+            return slab_avx512<BOX_LANES>(mins, maxs, points, inv_vectors, size);
+        case CpuFeatures::SIMD_AVX2:
+        case CpuFeatures::SIMD_AVX:
+            return slab_avx<BOX_LANES>(mins, maxs, points, inv_vectors, size) & ((1u << size) - 1);
+        case CpuFeatures::SIMD_SSE2:
+            return slab_sse2<BOX_LANES>(mins, maxs, points, inv_vectors, size) & ((1u << size) - 1);
+        default:
+            break;
+    }
+#endif
+    return slab_scalar<BOX_LANES>(mins, maxs, points, inv_vectors, size);
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  RayPacket
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::RayPacket::RayPacket() {
+    clear();
+}
+
+void Geom::RayPacket::clear() {
+    // Unused lanes hold zeros, and their results are masked out
+    memset(m_points, 0, sizeof(m_points));
+    memset(m_inv_vectors, 0, sizeof(m_inv_vectors));
+    m_size = 0;
+}
+
+bool Geom::RayPacket::add(const Ray& ray) {
+    if (m_size == WIDTH) return false;
+    for (int i = 0; i < 3; ++i) {
+        m_points[i][m_size] = ray.m_point[i];
+        m_inv_vectors[i][m_size] = ray.m_inv_vector[i];
+    }
+    ++m_size;
+    return true;
+}
+
+unsigned int Geom::RayPacket::intersects(const BoundingBox& box) const {
+    return slab_packet<false>(&box.m_min.m_x, &box.m_max.m_x, &m_points[0][0], &m_inv_vectors[0][0], m_size);
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  BoxPacket
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::BoxPacket::BoxPacket() {
+    clear();
+}
+
+void Geom::BoxPacket::clear() {
+    // Unused lanes hold cleared boxes
+    for (int i = 0; i < 3; ++i) {
+        for (unsigned int j = 0; j < WIDTH; ++j) {
+            m_mins[i][j] = BoundingBox::MAX_VALUE;
+            m_maxs[i][j] = BoundingBox::MIN_VALUE;
+        }
+    }
+    m_size = 0;
+}
+
+bool Geom::BoxPacket::add(const BoundingBox& box) {
+    if (m_size == WIDTH) return false;
+    for (int i = 0; i < 3; ++i) {
+        m_mins[i][m_size] = box.m_min[i];
+        m_maxs[i][m_size] = box.m_max[i];
+    }
+    ++m_size;
+    return true;
+}
+
+bool Geom::BoxPacket::add(const BoundingBoxf& box) {
+    if (m_size == WIDTH) return false;
+    for (int i = 0; i < 3; ++i) {
+        m_mins[i][m_size] = (treal)box.m_min[i];
+        m_maxs[i][m_size] = (treal)box.m_max[i];
+    }
+    ++m_size;
+    return true;
+}
+
+unsigned int Geom::BoxPacket::intersects(const Ray& ray) const {
+    return slab_packet<true>(&m_mins[0][0], &m_maxs[0][0], &ray.m_point.m_x, &ray.m_inv_vector.m_x, m_size);
+}
@@ -0,0 +1,122 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef GEOM_RAY_H
+#define GEOM_RAY_H
+
+#include "geom.h"
+#include "geom_vector3d.h"
+#include "geom_bounding_box.h"
+#include "geom_float.h"
+
+#include <limits>
+
+// A ray prepared for the slab test against boxes, which needs the reciprocals of the direction components. Zero
+// components have infinite reciprocals, of the sign of the zero.
+// Slab tests treat boxes as closed: a ray that only grazes a face, edge, or corner intersects the box. A ray starting
+// inside a box intersects it, and a ray with a zero vector intersects the boxes that contain its point. Cleared and
+// other inverted boxes are never intersected.
+class Geom::Ray
+{
+public:
+    // Variables
+    Vector3d m_point;
+    Vector3d m_vector;
+    Vector3d m_inv_vector;
+
+    // Constructors
+    Ray();
+    Ray(const Vector3d& point, const Vector3d& vector);
+
+    // Functions
+    void set(const Vector3d& point, const Vector3d& vector);
+
+    // The slab test against the box from min to max, given as three coordinates each, in treal or float
+    template <typename S>
+    bool intersects_bounds(const S* min, const S* max) const;
+};
+
+// Up to WIDTH rays, stored as separate coordinate lanes, for testing a ray packet, such as a bundle of rays cast from
+// one point, against a box at once
+class Geom::RayPacket
+{
+public:
+    // Constants
+    static const unsigned int WIDTH = 8;
+
+    // Variables
+    treal m_points[3][WIDTH];
+    treal m_inv_vectors[3][WIDTH];
+    unsigned int m_size;
+
+    // Constructors
+    RayPacket();
+
+    // Functions
+    void clear();
+    bool add(const Ray& ray); // returns false if the packet is full
+
+    // Returns the set of rays, one bit per ray, that intersect the box
+    unsigned int intersects(const BoundingBox& box) const;
+};
+
+// Up to WIDTH boxes, stored as separate coordinate lanes, for testing one ray against the children of a tree node at
+// once
+class Geom::BoxPacket
+{
+public:
+    // Constants
+    static const unsigned int WIDTH = 8;
+
+    // Variables
+    treal m_mins[3][WIDTH];
+    treal m_maxs[3][WIDTH];
+    unsigned int m_size;
+
+    // Constructors
+    BoxPacket();
+
+    // Functions
+    void clear();
+    bool add(const BoundingBox& box); // returns false if the packet is full
+    bool add(const BoundingBoxf& box);
+
+    // Returns the set of boxes, one bit per box, that the ray intersects
+    unsigned int intersects(const Ray& ray) const;
+};
+
+
+// Define template functions
+
+template <typename S>
+inline bool Geom::Ray::intersects_bounds(const S* min, const S* max) const {
+    treal t1, t2, t_near, t_far;
+
+    // The ray is on the positive side of its point
+    t_near = (treal)(0.0);
+    t_far = std::numeric_limits<treal>::max();
+
+    // Per axis, the ray enters the slab at t1 and leaves it at t2. A ray in the plane of a face, parallel to it, gets
+    // zero times infinity, a NaN, which max_treal and min_treal discard when it is their first argument.
+    for (int i = 0; i < 3; ++i) {
+        if (m_inv_vector[i] < (treal)(0.0)) {
+            t1 = ((treal)max[i] - m_point[i]) * m_inv_vector[i];
+            t2 = ((treal)min[i] - m_point[i]) * m_inv_vector[i];
+        }
+        else {
+            t1 = ((treal)min[i] - m_point[i]) * m_inv_vector[i];
+            t2 = ((treal)max[i] - m_point[i]) * m_inv_vector[i];
+        }
+        t_near = Geom::max_treal(t1, t_near);
+        t_far = Geom::min_treal(t2, t_far);
+    }
+
+    return t_near <= t_far;
+}
+
+#endif /* GEOM_RAY_H */
@@ -9,6 +9,11 @@
 #include "geom_transformation.h"
 #include "geom_vector4d.h"
 #include "geom_quaternion.h"
+#include "cpu_features.h"
+
+#ifdef M_GEOM_USE_DOUBLE
+    #include <immintrin.h>
+#endif
 
 
 /*
@@ -277,22 +282,19 @@ Geom::Transformation Geom::Transformation::rotatez(treal angle) {
 
 /*
  ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-  Operators
+  Multiplication Kernels
  ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 */
 
-Geom::Transformation& Geom::Transformation::operator = (const Transformation& other) {
-    if (this != &other) {
-        m_xaxis = other.m_xaxis;
-        m_yaxis = other.m_yaxis;
-        m_zaxis = other.m_zaxis;
-        m_origin = other.m_origin;
-    }
-    return *this;
-}
+// Each column of the product sums the columns of the first matrix, weighted by the components of the second one's
+// column, in the same order as the scalar product. The affine variants skip the last term of the axes, which is
+// multiplied by a zero w, and the multiplication of the origin by a unit w. Both matrices are read in full before the
+// result is stored, so the result may be either of them.
 
-Geom::Transformation operator * (const Geom::Transformation& a, const Geom::Transformation& b) {
-    return Geom::Transformation(
+static_assert(sizeof(Geom::Transformation) == sizeof(treal) * 16, "The kernels read transformations as 16 contiguous components");
+
+static void multiply_scalar(const Geom::Transformation& a, const Geom::Transformation& b, Geom::Transformation& res) {
+    res = Geom::Transformation(
         Geom::Vector4d(
             a[0][0] * b[0][0] + a[1][0] * b[0][1] + a[2][0] * b[0][2] + a[3][0] * b[0][3],
             a[0][1] * b[0][0] + a[1][1] * b[0][1] + a[2][1] * b[0][2] + a[3][1] * b[0][3],
@@ -315,6 +317,120 @@ Geom::Transformation operator * (const Geom::Transformation& a, const Geom::Tran
             a[0][3] * b[3][0] + a[1][3] * b[3][1] + a[2][3] * b[3][2] + a[3][3] * b[3][3]));
 }
 
+#ifdef M_GEOM_USE_DOUBLE
+
+// Each column in two registers
+template <bool AFFINE>
+static void multiply_sse2(const treal* a, const treal* b, treal* res) {
+    __m128d c0 = _mm_loadu_pd(a);
+    __m128d c0h = _mm_loadu_pd(a + 2);
+    __m128d c1 = _mm_loadu_pd(a + 4);
+    __m128d c1h = _mm_loadu_pd(a + 6);
+    __m128d c2 = _mm_loadu_pd(a + 8);
+    __m128d c2h = _mm_loadu_pd(a + 10);
+    __m128d c3 = _mm_loadu_pd(a + 12);
+    __m128d c3h = _mm_loadu_pd(a + 14);
+    __m128d r[8];
+
+    for (int j = 0; j < 4; ++j) {
+        const treal* bj = b + j * 4;
+        __m128d v0 = _mm_load1_pd(bj);
+        __m128d v1 = _mm_load1_pd(bj + 1);
+        __m128d v2 = _mm_load1_pd(bj + 2);
+        __m128d lo = _mm_add_pd(_mm_add_pd(_mm_mul_pd(c0, v0), _mm_mul_pd(c1, v1)), _mm_mul_pd(c2, v2));
+        __m128d hi = _mm_add_pd(_mm_add_pd(_mm_mul_pd(c0h, v0), _mm_mul_pd(c1h, v1)), _mm_mul_pd(c2h, v2));
+        if (!AFFINE) {
+            __m128d v3 = _mm_load1_pd(bj + 3);
+            lo = _mm_add_pd(lo, _mm_mul_pd(c3, v3));
+            hi = _mm_add_pd(hi, _mm_mul_pd(c3h, v3));
+        }
+        else if (j == 3) {
+            lo = _mm_add_pd(lo, c3);
+            hi = _mm_add_pd(hi, c3h);
+        }
+        r[j * 2] = lo;
+        r[j * 2 + 1] = hi;
+    }
+
+    for (int j = 0; j < 8; ++j)
+        _mm_storeu_pd(res + j * 2, r[j]);
+}
+
+// Each column in one register
+template <bool AFFINE>
+M_TARGET_AVX static void multiply_avx(const treal* a, const treal* b, treal* res) {
+    __m256d c0 = _mm256_loadu_pd(a);
+    __m256d c1 = _mm256_loadu_pd(a + 4);
+    __m256d c2 = _mm256_loadu_pd(a + 8);
+    __m256d c3 = _mm256_loadu_pd(a + 12);
+    __m256d r[4];
+
+    for (int j = 0; j < 4; ++j) {
+        const treal* bj = b + j * 4;
+        __m256d col = _mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(c0, _mm256_broadcast_sd(bj)),
+            _mm256_mul_pd(c1, _mm256_broadcast_sd(bj + 1))),
+            _mm256_mul_pd(c2, _mm256_broadcast_sd(bj + 2)));
+        if (!AFFINE)
+            col = _mm256_add_pd(col, _mm256_mul_pd(c3, _mm256_broadcast_sd(bj + 3)));
+        else if (j == 3)
+            col = _mm256_add_pd(col, c3);
+        r[j] = col;
+    }
+
+    for (int j = 0; j < 4; ++j)
+        _mm256_storeu_pd(res + j * 4, r[j]);
+}
+
+#endif
+
+static void multiply_kernel(const Geom::Transformation& a, const Geom::Transformation& b, Geom::Transformation& res, bool affine) {
+#ifdef M_GEOM_USE_DOUBLE
+    switch (CpuFeatures::get_simd_level()) {
+        case CpuFeatures::SIMD_AVX512:
+        case CpuFeatures::SIMD_AVX2:
+        case CpuFeatures::SIMD_AVX:
+            if (affine)
+                multiply_avx<true>(&a.m_xaxis.m_x, &b.m_xaxis.m_x, &res.m_xaxis.m_x);
+            else
+                multiply_avx<false>(&a.m_xaxis.m_x, &b.m_xaxis.m_x, &res.m_xaxis.m_x);
+            return;
+        case CpuFeatures::SIMD_SSE2:
+            if (affine)
+                multiply_sse2<true>(&a.m_xaxis.m_x, &b.m_xaxis.m_x, &res.m_xaxis.m_x);
+            else
+                multiply_sse2<false>(&a.m_xaxis.m_x, &b.m_xaxis.m_x, &res.m_xaxis.m_x);
+            return;
+        default:
+            break;
+    }
+#endif
+    multiply_scalar(a, b, res);
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Operators
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+Geom::Transformation& Geom::Transformation::operator = (const Transformation& other) {
+    if (this != &other) {
+        m_xaxis = other.m_xaxis;
+        m_yaxis = other.m_yaxis;
+        m_zaxis = other.m_zaxis;
+        m_origin = other.m_origin;
+    }
+    return *this;
+}
+
+Geom::Transformation operator * (const Geom::Transformation& a, const Geom::Transformation& b) {
+    Geom::Transformation res;
+    Geom::Transformation::multiply(a, b, res);
+    return res;
+}
+
 Geom::Vector4d operator * (const Geom::Transformation& t, const Geom::Vector4d& v) {
     return Geom::Vector4d(
         t[0][0] * v[0] + t[1][0] * v[1] + t[2][0] * v[2] + t[3][0] * v[3],
@@ -324,13 +440,264 @@ Geom::Vector4d operator * (const Geom::Transformation& t, const Geom::Vector4d&
 }
 
 
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Batch Kernels
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+// Each kernel computes the same products and sums, in the same order, as transform_vector (POINT) and rotate_vector,
+// so that results match the scalar functions exactly. Fused multiply-adds would round differently and are not used.
+// Points are read in full before their results are stored, so the input and output may be the same array.
+
+template <bool POINT>
+static void transform_batch_scalar(const Geom::Transformation& t, const Geom::Vector3d* in, Geom::Vector3d* out, size_t count, treal det) {
+    for (size_t i = 0; i < count; ++i) {
+        if (POINT)
+            out[i] = t.transform_vector(in[i], det);
+        else
+            out[i] = t.rotate_vector(in[i]);
+    }
+}
+
+#ifdef M_GEOM_USE_DOUBLE
+
+// Two of the coordinates in one register and the third one alongside
+template <bool POINT>
+static void transform_batch_sse2(const Geom::Transformation& t, const Geom::Vector3d* in, Geom::Vector3d* out, size_t count, treal det) {
+    __m128d cx = _mm_loadu_pd(&t.m_xaxis.m_x);
+    __m128d cy = _mm_loadu_pd(&t.m_yaxis.m_x);
+    __m128d cz = _mm_loadu_pd(&t.m_zaxis.m_x);
+    __m128d co = _mm_loadu_pd(&t.m_origin.m_x);
+    __m128d cx2 = _mm_load_sd(&t.m_xaxis.m_z);
+    __m128d cy2 = _mm_load_sd(&t.m_yaxis.m_z);
+    __m128d cz2 = _mm_load_sd(&t.m_zaxis.m_z);
+    __m128d co2 = _mm_load_sd(&t.m_origin.m_z);
+    __m128d vdet = _mm_set1_pd(det);
+
+    for (size_t i = 0; i < count; ++i) {
+        __m128d vx = _mm_load1_pd(&in[i].m_x);
+        __m128d vy = _mm_load1_pd(&in[i].m_y);
+        __m128d vz = _mm_load1_pd(&in[i].m_z);
+        __m128d r = _mm_add_pd(_mm_add_pd(_mm_mul_pd(cx, vx), _mm_mul_pd(cy, vy)), _mm_mul_pd(cz, vz));
+        __m128d r2 = _mm_add_sd(_mm_add_sd(_mm_mul_sd(cx2, vx), _mm_mul_sd(cy2, vy)), _mm_mul_sd(cz2, vz));
+        if (POINT) {
+            r = _mm_mul_pd(_mm_add_pd(r, co), vdet);
+            r2 = _mm_mul_sd(_mm_add_sd(r2, co2), vdet);
+        }
+        _mm_storeu_pd(&out[i].m_x, r);
+        _mm_store_sd(&out[i].m_z, r2);
+    }
+}
+
+// All three coordinates in one register; the fourth lane is discarded
+template <bool POINT>
+M_TARGET_AVX static void transform_batch_avx(const Geom::Transformation& t, const Geom::Vector3d* in, Geom::Vector3d* out, size_t count, treal det) {
+    __m256d cx = _mm256_loadu_pd(&t.m_xaxis.m_x);
+    __m256d cy = _mm256_loadu_pd(&t.m_yaxis.m_x);
+    __m256d cz = _mm256_loadu_pd(&t.m_zaxis.m_x);
+    __m256d co = _mm256_loadu_pd(&t.m_origin.m_x);
+    __m256d vdet = _mm256_set1_pd(det);
+
+    for (size_t i = 0; i < count; ++i) {
+        __m256d vx = _mm256_broadcast_sd(&in[i].m_x);
+        __m256d vy = _mm256_broadcast_sd(&in[i].m_y);
+        __m256d vz = _mm256_broadcast_sd(&in[i].m_z);
+        __m256d r = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(cx, vx), _mm256_mul_pd(cy, vy)), _mm256_mul_pd(cz, vz));
+        if (POINT)
+            r = _mm256_mul_pd(_mm256_add_pd(r, co), vdet);
+        _mm_storeu_pd(&out[i].m_x, _mm256_castpd256_pd128(r));
+        _mm_store_sd(&out[i].m_z, _mm256_extractf128_pd(r, 1));
+    }
+}
+
+// In functions targeting AVX-512F, GCC fuses plain multiplies and adds into FMA, which rounds differently. The variants
+// that take a rounding mode are never fused.
+#define M_MUL512(a, b) _mm512_mul_round_pd(a, b, _MM_FROUND_CUR_DIRECTION)
+#define M_ADD512(a, b) _mm512_add_round_pd(a, b, _MM_FROUND_CUR_DIRECTION)
+
+// Two points per register. Four points, twelve coordinates, are loaded and stored at a time with whole registers; the
+// remaining ones go through masked loads and stores. Masked stores are not used in the main loop, since a load that
+// overlaps the disabled lanes of a recent masked store stalls until the store completes.
+template <bool POINT>
+M_TARGET_AVX512 static void transform_batch_avx512(const Geom::Transformation& t, const Geom::Vector3d* in, Geom::Vector3d* out, size_t count, treal det) {
+    // Lanes 0 to 7 index the first source and 8 to 15 the second one
+    const __m512i idx_x = _mm512_set_epi64(3, 3, 3, 3, 0, 0, 0, 0);
+    const __m512i idx_y = _mm512_set_epi64(4, 4, 4, 4, 1, 1, 1, 1);
+    const __m512i idx_z = _mm512_set_epi64(5, 5, 5, 5, 2, 2, 2, 2);
+    const __m512i idx_x23 = _mm512_set_epi64(9, 9, 9, 9, 6, 6, 6, 6);
+    const __m512i idx_y23 = _mm512_set_epi64(10, 10, 10, 10, 7, 7, 7, 7);
+    const __m512i idx_z23 = _mm512_set_epi64(11, 11, 11, 11, 8, 8, 8, 8);
+    const __m512i idx_pack = _mm512_set_epi64(9, 8, 6, 5, 4, 2, 1, 0);
+    const __m512i idx_pack23 = _mm512_set_epi64(6, 6, 6, 6, 6, 5, 4, 2);
+    __m512d cx = _mm512_broadcast_f64x4(_mm256_loadu_pd(&t.m_xaxis.m_x));
+    __m512d cy = _mm512_broadcast_f64x4(_mm256_loadu_pd(&t.m_yaxis.m_x));
+    __m512d cz = _mm512_broadcast_f64x4(_mm256_loadu_pd(&t.m_zaxis.m_x));
+    __m512d co = _mm512_broadcast_f64x4(_mm256_loadu_pd(&t.m_origin.m_x));
+    __m512d vdet = _mm512_set1_pd(det);
+    size_t i;
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        const treal* src = &in[i].m_x;
+        treal* dst = &out[i].m_x;
+        __m512d v = _mm512_loadu_pd(src);
+        __m512d v2 = _mm512_castpd256_pd512(_mm256_loadu_pd(src + 8));
+        __m512d r = M_ADD512(M_ADD512(
+            M_MUL512(cx, _mm512_permutexvar_pd(idx_x, v)),
+            M_MUL512(cy, _mm512_permutexvar_pd(idx_y, v))),
+            M_MUL512(cz, _mm512_permutexvar_pd(idx_z, v)));
+        __m512d r2 = M_ADD512(M_ADD512(
+            M_MUL512(cx, _mm512_permutex2var_pd(v, idx_x23, v2)),
+            M_MUL512(cy, _mm512_permutex2var_pd(v, idx_y23, v2))),
+            M_MUL512(cz, _mm512_permutex2var_pd(v, idx_z23, v2)));
+        if (POINT) {
+            r = M_MUL512(M_ADD512(r, co), vdet);
+            r2 = M_MUL512(M_ADD512(r2, co), vdet);
+        }
+        _mm512_storeu_pd(dst, _mm512_permutex2var_pd(r, idx_pack, r2));
+        _mm256_storeu_pd(dst + 8, _mm512_castpd512_pd256(_mm512_permutexvar_pd(idx_pack23, r2)));
+    }
+
+    for (; i < count; i += 2) {
+        __mmask8 mask = (count - i >= 2) ? 0x3F : 0x07;
+        __m512d v = _mm512_maskz_loadu_pd(mask, &in[i].m_x);
+        __m512d r = M_ADD512(M_ADD512(
+            M_MUL512(cx, _mm512_permutexvar_pd(idx_x, v)),
+            M_MUL512(cy, _mm512_permutexvar_pd(idx_y, v))),
+            M_MUL512(cz, _mm512_permutexvar_pd(idx_z, v)));
+        if (POINT)
+            r = M_MUL512(M_ADD512(r, co), vdet);
+        _mm512_mask_storeu_pd(&out[i].m_x, mask, _mm512_permutex2var_pd(r, idx_pack, r));
+    }
+}
+
+#undef M_MUL512
+#undef M_ADD512
+
+#endif
+
+template <bool POINT>
+static void transform_batch(const Geom::Transformation& t, const Geom::Vector3d* in, Geom::Vector3d* out, size_t count, treal det) {
+#ifdef M_GEOM_USE_DOUBLE
+    switch (CpuFeatures::get_simd_level()) {
+        case CpuFeatures::SIMD_AVX512:
+            transform_batch_avx512<POINT>(t, in, out, count, det);
+            return;
+        case CpuFeatures::SIMD_AVX2:
+        case CpuFeatures::SIMD_AVX:
+            transform_batch_avx<POINT>(t, in, out, count, det);
+            return;
+        case CpuFeatures::SIMD_SSE2:
+            transform_batch_sse2<POINT>(t, in, out, count, det);
+            return;
+        default:
+            break;
+    }
+#endif
+    transform_batch_scalar<POINT>(t, in, out, count, det);
+}
+
+
 /*
  ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   Functions
  ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 */
 
+Geom::Transformation::KIND Geom::Transformation::get_kind() const {
+    treal xx, yy, zz, xy, xz, yz, tol;
+
+    if (m_xaxis.m_w != (treal)(0.0) || m_yaxis.m_w != (treal)(0.0) || m_zaxis.m_w != (treal)(0.0))
+        return KIND_PROJECTIVE;
+
+    xx = m_xaxis.m_x * m_xaxis.m_x + m_xaxis.m_y * m_xaxis.m_y + m_xaxis.m_z * m_xaxis.m_z;
+    yy = m_yaxis.m_x * m_yaxis.m_x + m_yaxis.m_y * m_yaxis.m_y + m_yaxis.m_z * m_yaxis.m_z;
+    zz = m_zaxis.m_x * m_zaxis.m_x + m_zaxis.m_y * m_zaxis.m_y + m_zaxis.m_z * m_zaxis.m_z;
+    xy = m_xaxis.m_x * m_yaxis.m_x + m_xaxis.m_y * m_yaxis.m_y + m_xaxis.m_z * m_yaxis.m_z;
+    xz = m_xaxis.m_x * m_zaxis.m_x + m_xaxis.m_y * m_zaxis.m_y + m_xaxis.m_z * m_zaxis.m_z;
+    yz = m_yaxis.m_x * m_zaxis.m_x + m_yaxis.m_y * m_zaxis.m_y + m_yaxis.m_z * m_zaxis.m_z;
+
+    // Tight tolerances, since the rigid and uniform inverses trust the axes to be orthogonal
+    tol = xx * M_EPSILON_SQ;
+    if (xx < M_EPSILON_SQ || fabs(yy - xx) > tol || fabs(zz - xx) > tol || fabs(xy) > tol || fabs(xz) > tol || fabs(yz) > tol)
+        return KIND_AFFINE;
+
+    return fabs(xx - (treal)(1.0)) > M_EPSILON_SQ ? KIND_UNIFORM : KIND_RIGID;
+}
+
 Geom::Transformation Geom::Transformation::inverse() const {
+    return inverse(get_kind());
+}
+
+Geom::Transformation Geom::Transformation::inverse(KIND kind) const {
+    treal inv[16], det, s;
+    int i;
+
+    if (kind == KIND_PROJECTIVE)
+        return inverse_general();
+
+    if (kind == KIND_AFFINE) {
+        // The rows of the inverse rotation part are the cross products of the axes, over the determinant
+        inv[0] = m_yaxis.m_y * m_zaxis.m_z - m_yaxis.m_z * m_zaxis.m_y;
+        inv[4] = m_yaxis.m_z * m_zaxis.m_x - m_yaxis.m_x * m_zaxis.m_z;
+        inv[8] = m_yaxis.m_x * m_zaxis.m_y - m_yaxis.m_y * m_zaxis.m_x;
+        inv[1] = m_zaxis.m_y * m_xaxis.m_z - m_zaxis.m_z * m_xaxis.m_y;
+        inv[5] = m_zaxis.m_z * m_xaxis.m_x - m_zaxis.m_x * m_xaxis.m_z;
+        inv[9] = m_zaxis.m_x * m_xaxis.m_y - m_zaxis.m_y * m_xaxis.m_x;
+        inv[2] = m_xaxis.m_y * m_yaxis.m_z - m_xaxis.m_z * m_yaxis.m_y;
+        inv[6] = m_xaxis.m_z * m_yaxis.m_x - m_xaxis.m_x * m_yaxis.m_z;
+        inv[10] = m_xaxis.m_x * m_yaxis.m_y - m_xaxis.m_y * m_yaxis.m_x;
+        det = m_xaxis.m_x * inv[0] + m_xaxis.m_y * inv[4] + m_xaxis.m_z * inv[8];
+        s = det;
+    }
+    else {
+        // The transpose, over the squared scale
+        inv[0] = m_xaxis.m_x;
+        inv[4] = m_xaxis.m_y;
+        inv[8] = m_xaxis.m_z;
+        inv[1] = m_yaxis.m_x;
+        inv[5] = m_yaxis.m_y;
+        inv[9] = m_yaxis.m_z;
+        inv[2] = m_zaxis.m_x;
+        inv[6] = m_zaxis.m_y;
+        inv[10] = m_zaxis.m_z;
+        if (kind == KIND_RIGID) {
+            s = (treal)(1.0);
+            det = (treal)(1.0);
+        }
+        else {
+            s = m_xaxis.m_x * m_xaxis.m_x + m_xaxis.m_y * m_xaxis.m_y + m_xaxis.m_z * m_xaxis.m_z;
+            det = s * sqrt(s);
+        }
+    }
+
+    // Singular as a whole, just as in inverse_general
+    if (fabs(det * m_origin.m_w) > M_EPSILON) {
+        inv[3] = (treal)(0.0);
+        inv[7] = (treal)(0.0);
+        inv[11] = (treal)(0.0);
+        if (kind != KIND_RIGID) {
+            s = (treal)(1.0) / s;
+            for (i = 0; i < 11; ++i)
+                inv[i] *= s;
+        }
+
+        // The translation, undone by the inverse rotation part, over the origin's w
+        s = (treal)(1.0) / m_origin.m_w;
+        inv[12] = -(inv[0] * m_origin.m_x + inv[4] * m_origin.m_y + inv[8] * m_origin.m_z) * s;
+        inv[13] = -(inv[1] * m_origin.m_x + inv[5] * m_origin.m_y + inv[9] * m_origin.m_z) * s;
+        inv[14] = -(inv[2] * m_origin.m_x + inv[6] * m_origin.m_y + inv[10] * m_origin.m_z) * s;
+        inv[15] = s;
+    }
+    else {
+        for (i = 0; i < 16; ++i)
+            inv[i] = (treal)(0.0);
+    }
+
+    return Transformation(inv);
+}
+
+Geom::Transformation Geom::Transformation::inverse_general() const {
     treal inv[16], det;
     int i;
 
@@ -543,7 +910,7 @@ Geom::Transformation Geom::Transformation::rotate_xaxis_to(const Vector3d& dir)
     Transformation t2(dir2, yaxis2, normal);
     // Unrotate matrix with respect to t1.
     // Then rotate the result with respect to t2.
-    Transformation result(t2 * t1.inverse() * (*this));
+    Transformation result(t2 * t1.inverse(KIND_RIGID) * (*this));
     result.m_origin = m_origin;
 
     return result;
@@ -574,7 +941,7 @@ Geom::Transformation Geom::Transformation::rotate_yaxis_to(const Vector3d& dir)
     Transformation t2(dir2, yaxis2, normal);
     // Unrotate matrix with respect to t1.
     // Then rotate the result with respect to t2.
-    Transformation result(t2 * t1.inverse() * (*this));
+    Transformation result(t2 * t1.inverse(KIND_RIGID) * (*this));
     result.m_origin = m_origin;
 
     return result;
@@ -605,7 +972,7 @@ Geom::Transformation Geom::Transformation::rotate_zaxis_to(const Vector3d& dir)
     Transformation t2(dir2, yaxis2, normal);
     // Unrotate matrix with respect to t1.
     // Then rotate the result with respect to t2.
-    Transformation result(t2 * t1.inverse() * (*this));
+    Transformation result(t2 * t1.inverse(KIND_RIGID) * (*this));
     result.m_origin = m_origin;
 
     return result;
@@ -747,6 +1114,78 @@ Geom::Vector3d Geom::Transformation::transform_vector(const Vector3d& v, treal d
         (m_xaxis[2] * v[0] + m_yaxis[2] * v[1] + m_zaxis[2] * v[2] + m_origin[2]) * det);
 }
 
+bool Geom::Transformation::is_affine() const {
+    return m_xaxis.m_w == (treal)(0.0) && m_yaxis.m_w == (treal)(0.0) && m_zaxis.m_w == (treal)(0.0) && m_origin.m_w == (treal)(1.0);
+}
+
+void Geom::Transformation::multiply(const Transformation& a, const Transformation& b, Transformation& res) {
+    multiply_kernel(a, b, res, a.is_affine() && b.is_affine());
+}
+
+void Geom::Transformation::concatenate(const Transformation* chain, size_t count, Transformation& res) {
+    bool affine;
+
+    if (count == 0) {
+        res = IDENTITY;
+        return;
+    }
+
+    // The product of affine transformations stays affine, so only the next factor needs checking
+    res = chain[0];
+    affine = res.is_affine();
+    for (size_t i = 1; i < count; ++i) {
+        affine = affine && chain[i].is_affine();
+        multiply_kernel(res, chain[i], res, affine);
+    }
+}
+
+Geom::Vector3d Geom::Transformation::transform_normal(const Vector3d& n) const {
+    return get_normal_transformation().rotate_vector(n);
+}
+
+Geom::Transformation Geom::Transformation::get_normal_transformation() const {
+    return get_normal_transformation(get_kind());
+}
+
+Geom::Transformation Geom::Transformation::get_normal_transformation(KIND kind) const {
+    treal s;
+
+    // The inverse transpose of the rotation part: the rotation part itself when rigid, or over the squared scale when
+    // uniform
+    if (kind == KIND_RIGID)
+        return Transformation(m_xaxis, m_yaxis, m_zaxis);
+    if (kind == KIND_UNIFORM) {
+        s = (treal)(1.0) / m_xaxis.dot(m_xaxis);
+        return Transformation(m_xaxis.scale(s), m_yaxis.scale(s), m_zaxis.scale(s));
+    }
+
+    // Otherwise, its columns are the cross products of the axes over the determinant
+    Vector3d xaxis(m_yaxis.cross(m_zaxis));
+    Vector3d yaxis(m_zaxis.cross(m_xaxis));
+    Vector3d zaxis(m_xaxis.cross(m_yaxis));
+    treal det = m_xaxis.dot(xaxis);
+    if (fabs(det) > M_EPSILON_SQ) {
+        det = (treal)(1.0) / det;
+        xaxis.scale_self(det);
+        yaxis.scale_self(det);
+        zaxis.scale_self(det);
+    }
+    return Transformation(xaxis, yaxis, zaxis);
+}
+
+void Geom::Transformation::transform_points(const Vector3d* points, Vector3d* points_out, size_t count) const {
+    transform_batch<true>(*this, points, points_out, count, get_determinant());
+}
+
+void Geom::Transformation::rotate_vectors(const Vector3d* vectors, Vector3d* vectors_out, size_t count) const {
+    transform_batch<false>(*this, vectors, vectors_out, count, (treal)(1.0));
+}
+
+void Geom::Transformation::transform_normals(const Vector3d* normals, Vector3d* normals_out, size_t count) const {
+    Transformation normal_tra(get_normal_transformation());
+    transform_batch<false>(normal_tra, normals, normals_out, count, (treal)(1.0));
+}
+
 treal Geom::Transformation::get_determinant() const {
     if (fabs(m_origin.m_w) > M_EPSILON)
         return (treal)(1.0) / m_origin.m_w;
@@ -17,6 +17,17 @@ Geom::Vector4d operator * (const Geom::Transformation& t, const Geom::Vector4d&
 class Geom::Transformation
 {
 public:
+    // Enumerators
+
+    // Classes of transformations, from the most to the least specific; each one admits a cheaper inverse than the next
+    enum KIND
+    {
+        KIND_RIGID = 0, // orthonormal axes, possibly mirrored
+        KIND_UNIFORM = 1, // orthogonal axes of equal length
+        KIND_AFFINE = 2,
+        KIND_PROJECTIVE = 3 // nonzero w components in the axes
+    };
+
     // Variables
     Vector4d m_xaxis, m_yaxis, m_zaxis, m_origin;
 
@@ -50,7 +61,21 @@ public:
     const Vector4d& operator [] (const int index) const;
 
     // Functions
+
+    // Same as a * b; the result may be either factor. Affine factors, whose bottom row is constant, skip its terms.
+    static void multiply(const Transformation& a, const Transformation& b, Transformation& res);
+
+    // The product of a chain of transformations, from the outermost one, such as the path from a model down to an
+    // instance nested in several components. Gives the identity for an empty chain.
+    static void concatenate(const Transformation* chain, size_t count, Transformation& res);
+
+    KIND get_kind() const;
+
+    // Uses the cheapest path valid for the kind; inverse_general always runs the full 4x4 cofactor expansion.
+    // A kind more specific than the actual one gives a wrong result.
     Transformation inverse() const;
+    Transformation inverse(KIND kind) const;
+    Transformation inverse_general() const;
     Vector3d get_scale() const;
     Transformation& set_scale(const Vector3d& scale);
     Transformation& normalize_self();
@@ -67,6 +92,18 @@ public:
     Vector3d transform_vector2(const Vector3d& v) const;
     Vector3d rotate_vector(const Vector3d& v) const;
 
+    // Maps a normal through the inverse transpose, which keeps it perpendicular to transformed surfaces. The result is
+    // not normalized.
+    Vector3d transform_normal(const Vector3d& n) const;
+    Transformation get_normal_transformation() const;
+    Transformation get_normal_transformation(KIND kind) const;
+
+    // Batch versions of transform_vector, rotate_vector, and transform_normal over contiguous arrays. Results match
+    // the single-vector functions exactly. The output may be the same array as the input.
+    void transform_points(const Vector3d* points, Vector3d* points_out, size_t count) const;
+    void rotate_vectors(const Vector3d* vectors, Vector3d* vectors_out, size_t count) const;
+    void transform_normals(const Vector3d* normals, Vector3d* normals_out, size_t count) const;
+
     treal get_determinant() const;
     void extract_w_factor();
 
@@ -75,6 +112,7 @@ public:
     void get_normal_zaxis(Geom::Vector3d& res) const;
     void get_normal_origin(Geom::Vector3d& res) const;
 
+    bool is_affine() const; // the bottom row is (0, 0, 0, 1)
     bool is_uniform() const;
     bool is_flipped() const;
     bool is_flat() const;
@@ -0,0 +1,102 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#include "large_block.h"
+
+#ifdef __linux__
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Constants
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+const size_t LargeBlock::MAP_THRESHOLD = 16 * 1024 * 1024;
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Functions
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+#ifdef __linux__
+
+static size_t round_to_pages(size_t size) {
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (size + page_size - 1) & ~(page_size - 1);
+}
+
+void* LargeBlock::reallocate(void* ptr, size_t old_size, size_t new_size) {
+    void* new_ptr;
+    bool old_mapped = ptr != nullptr && is_mapped(old_size);
+
+    if (!is_mapped(new_size)) {
+        if (!old_mapped)
+            return realloc(ptr, new_size);
+
+        // Shrinking below the threshold moves the contents back to the heap
+        new_ptr = malloc(new_size);
+        if (new_ptr != nullptr) {
+            memcpy(new_ptr, ptr, new_size);
+            munmap(ptr, round_to_pages(old_size));
+        }
+        return new_ptr;
+    }
+
+    if (old_mapped) {
+        new_ptr = mremap(ptr, round_to_pages(old_size), round_to_pages(new_size), MREMAP_MAYMOVE);
+        return new_ptr != MAP_FAILED ? new_ptr : nullptr;
+    }
+
+    // Crossing the threshold costs one last copy
+    new_ptr = mmap(nullptr, round_to_pages(new_size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (new_ptr == MAP_FAILED)
+        return nullptr;
+    if (ptr != nullptr) {
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+        free(ptr);
+    }
+    return new_ptr;
+}
+
+void LargeBlock::deallocate(void* ptr, size_t size) {
+    if (ptr == nullptr) return;
+    if (is_mapped(size))
+        munmap(ptr, round_to_pages(size));
+    else
+        free(ptr);
+}
+
+bool LargeBlock::advise_huge_pages(void* ptr, size_t size) {
+#ifdef MADV_HUGEPAGE
+    if (ptr != nullptr && is_mapped(size))
+        return madvise(ptr, round_to_pages(size), MADV_HUGEPAGE) == 0;
+#endif
+    return false;
+}
+
+#else
+
+void* LargeBlock::reallocate(void* ptr, size_t old_size, size_t new_size) {
+    return realloc(ptr, new_size);
+}
+
+void LargeBlock::deallocate(void* ptr, size_t size) {
+    free(ptr);
+}
+
+bool LargeBlock::advise_huge_pages(void* ptr, size_t size) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef LARGE_BLOCK_H
+#define LARGE_BLOCK_H
+
+#include "common.h"
+
+#include <cstddef>
+
+// Allocates the storage of growable arrays. On Linux, blocks of at least MAP_THRESHOLD bytes are anonymous mappings,
+// which are grown with mremap by remapping their pages rather than copying them. Smaller blocks, and all blocks on
+// other platforms, come from malloc and realloc. Whether a block is mapped depends on its size alone, so callers must
+// pass the size the block was allocated or last reallocated with.
+class LargeBlock {
+public:
+    // Constants
+    static const size_t MAP_THRESHOLD; // in bytes
+
+    static bool is_mapped(size_t size);
+
+    static void* allocate(size_t size);
+    static void* reallocate(void* ptr, size_t old_size, size_t new_size); // keeps the contents that fit
+    static void deallocate(void* ptr, size_t size);
+
+    // Asks the system to back a mapped block with transparent huge pages, which cuts TLB misses when walking large
+    // arrays, such as BVH nodes or mesh buffers. The advice stays with the block as it grows. Returns false if the
+    // block is not mapped or the platform has no such advice.
+    static bool advise_huge_pages(void* ptr, size_t size);
+};
+
+
+// Define inline functions
+
+inline bool LargeBlock::is_mapped(size_t size) {
+#ifdef __linux__
+    return size >= MAP_THRESHOLD;
+#else
+    return false;
+#endif
+}
+
+inline void* LargeBlock::allocate(size_t size) {
+    if (!is_mapped(size))
+        return malloc(size);
+    return reallocate(nullptr, 0, size);
+}
+
+#endif  /* LARGE_BLOCK_H */
@@ -0,0 +1,214 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include "common.h"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// A bounded lock-free queue for any number of producer and consumer threads. Every cell carries a sequence number,
+// which tells a producer whether the cell is free on the current lap and a consumer whether it is filled, so threads
+// only contend on the position they advance.
+template <class T>
+class MpmcQueue {
+private:
+    // Disable copy constructor and assignment operator
+    MpmcQueue(const MpmcQueue<T>& other);
+    MpmcQueue<T>& operator=(const MpmcQueue<T>& other);
+
+    // Structures
+    struct Cell {
+        std::atomic<size_t> m_sequence;
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type m_storage;
+    };
+
+    // Variables
+    Cell* m_cells;
+    size_t m_mask;
+    char m_padding1[64];
+    std::atomic<size_t> m_tail; // next position to enqueue at
+    char m_padding2[64];
+    std::atomic<size_t> m_head; // next position to dequeue from
+    char m_padding3[64];
+
+    // Helper Functions
+    T* item_at(size_t pos);
+    size_t claim(std::atomic<size_t>& position, size_t lap_offset, size_t max_count, size_t& pos_out);
+
+public:
+    // The capacity is rounded up to a power of two
+    MpmcQueue(unsigned int capacity);
+    virtual ~MpmcQueue();
+
+    unsigned int capacity() const;
+    unsigned int size() const; // approximate while other threads access the queue
+    bool empty() const; // approximate while other threads access the queue
+
+    // Return false if the queue is full or empty, respectively
+    bool try_enqueue(const T& item);
+    bool try_dequeue(T& item_out);
+
+    // Spin, and then yield, until there is room or an item
+    void enqueue(const T& item);
+    void dequeue(T& item_out);
+
+    // Transfer as many items as fit or are available, up to count, claiming all cells at once. Return the number of
+    // items transferred.
+    unsigned int enqueue_n(const T* items, unsigned int count);
+    unsigned int dequeue_n(T* items_out, unsigned int count);
+};
+
+
+// Define template functions
+
+template <class T>
+MpmcQueue<T>::MpmcQueue(unsigned int capacity) {
+    size_t i;
+    size_t cap = 2;
+
+    while (cap < capacity)
+        cap <<= 1;
+    m_mask = cap - 1;
+
+    m_cells = reinterpret_cast<Cell*>(malloc(sizeof(Cell) * cap));
+    for (i = 0; i < cap; ++i)
+        new (&m_cells[i].m_sequence) std::atomic<size_t>(i);
+
+    m_tail.store(0, std::memory_order_relaxed);
+    m_head.store(0, std::memory_order_relaxed);
+}
+
+template <class T>
+MpmcQueue<T>::~MpmcQueue() {
+    size_t pos;
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+
+    // Destruct remaining items
+    for (pos = m_head.load(std::memory_order_relaxed); pos != tail; ++pos)
+        item_at(pos)->~T();
+
+    free(m_cells);
+}
+
+template <class T>
+inline T* MpmcQueue<T>::item_at(size_t pos) {
+    return reinterpret_cast<T*>(&m_cells[pos & m_mask].m_storage);
+}
+
+template <class T>
+size_t MpmcQueue<T>::claim(std::atomic<size_t>& position, size_t lap_offset, size_t max_count, size_t& pos_out) {
+    size_t pos = position.load(std::memory_order_relaxed);
+    size_t count;
+    size_t seq = 0;
+
+    if (max_count == 0) return 0;
+
+    while (true) {
+        // Count the consecutive cells ready on this lap: a free cell has a sequence equal to its position, a filled
+        // one is a step ahead. Only the thread that advances the position past a ready cell may touch it.
+        for (count = 0; count < max_count; ++count) {
+            seq = m_cells[(pos + count) & m_mask].m_sequence.load(std::memory_order_acquire);
+            if (seq != pos + count + lap_offset) break;
+        }
+        if (count != 0) {
+            if (position.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                pos_out = pos;
+                return count;
+            }
+        }
+        else if (static_cast<ptrdiff_t>(seq - (pos + lap_offset)) < 0)
+            return 0; // full or empty
+        else
+            pos = position.load(std::memory_order_relaxed); // another thread got ahead
+    }
+}
+
+template <class T>
+inline unsigned int MpmcQueue<T>::capacity() const {
+    return static_cast<unsigned int>(m_mask + 1);
+}
+
+template <class T>
+inline unsigned int MpmcQueue<T>::size() const {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    return static_cast<ptrdiff_t>(tail - head) > 0 ? static_cast<unsigned int>(tail - head) : 0;
+}
+
+template <class T>
+inline bool MpmcQueue<T>::empty() const {
+    return size() == 0;
+}
+
+template <class T>
+bool MpmcQueue<T>::try_enqueue(const T& item) {
+    return enqueue_n(&item, 1) != 0;
+}
+
+template <class T>
+bool MpmcQueue<T>::try_dequeue(T& item_out) {
+    return dequeue_n(&item_out, 1) != 0;
+}
+
+template <class T>
+void MpmcQueue<T>::enqueue(const T& item) {
+    unsigned int attempt = 0;
+    while (enqueue_n(&item, 1) == 0) {
+        if (++attempt > 64)
+            std::this_thread::yield();
+    }
+}
+
+template <class T>
+void MpmcQueue<T>::dequeue(T& item_out) {
+    unsigned int attempt = 0;
+    while (dequeue_n(&item_out, 1) == 0) {
+        if (++attempt > 64)
+            std::this_thread::yield();
+    }
+}
+
+template <class T>
+unsigned int MpmcQueue<T>::enqueue_n(const T* items, unsigned int count) {
+    size_t pos;
+    size_t i;
+    size_t n = claim(m_tail, 0, count, pos);
+
+    for (i = 0; i < n; ++i) {
+        new (item_at(pos + i)) T(items[i]);
+        m_cells[(pos + i) & m_mask].m_sequence.store(pos + i + 1, std::memory_order_release);
+    }
+
+    return static_cast<unsigned int>(n);
+}
+
+template <class T>
+unsigned int MpmcQueue<T>::dequeue_n(T* items_out, unsigned int count) {
+    size_t pos;
+    size_t i;
+    size_t n = claim(m_head, 1, count, pos);
+    T* item;
+
+    for (i = 0; i < n; ++i) {
+        item = item_at(pos + i);
+        items_out[i] = std::move(*item);
+        item->~T();
+        // Free the cell for the producer one lap ahead
+        m_cells[(pos + i) & m_mask].m_sequence.store(pos + i + m_mask + 1, std::memory_order_release);
+    }
+
+    return static_cast<unsigned int>(n);
+}
+
+#endif  /* MPMC_QUEUE_H */
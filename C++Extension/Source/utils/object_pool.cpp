@@ -0,0 +1,219 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#include "object_pool.h"
+
+#include <cstdint>
+#include <thread>
+
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+    #include <immintrin.h>
+#endif
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Constants
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+const size_t ObjectPool::SLAB_SIZE = 64 * 1024;
+const size_t ObjectPool::BATCH_SIZE = 32;
+const unsigned int ObjectPool::LOCK_SPIN_COUNT = 64;
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Variables
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+ThreadLocalSlot ObjectPool::s_cache(ObjectPool::delete_cache);
+
+std::atomic_flag ObjectPool::s_guard = ATOMIC_FLAG_INIT;
+ObjectPool::FreeBlock* ObjectPool::s_heads[NUM_SIZE_CLASSES] = { nullptr };
+
+std::atomic<unsigned long long> ObjectPool::s_num_hits(0);
+std::atomic<unsigned long long> ObjectPool::s_num_misses(0);
+std::atomic<unsigned long long> ObjectPool::s_num_large(0);
+std::atomic<size_t> ObjectPool::s_resident_bytes(0);
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Thread Cache
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+ObjectPool::ThreadCache::ThreadCache() :
+    m_num_hits(0),
+    m_num_misses(0),
+    m_num_large(0)
+{
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        m_heads[i] = nullptr;
+        m_counts[i] = 0;
+    }
+}
+
+ObjectPool::ThreadCache::~ThreadCache() {
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i)
+        flush(*this, i, m_counts[i]);
+    publish_counters(*this);
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Helper Functions
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+void M_TLS_CLEANUP ObjectPool::delete_cache(void* cache) {
+    delete static_cast<ThreadCache*>(cache);
+}
+
+void ObjectPool::pause_cpu() {
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+    _mm_pause();
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+void ObjectPool::lock() {
+    unsigned int attempt = 0;
+    // The shared lists are held briefly, so spin first; a holder that was preempted needs the processor, though
+    while (s_guard.test_and_set(std::memory_order_acquire)) {
+        if (++attempt > LOCK_SPIN_COUNT)
+            std::this_thread::yield();
+        else
+            pause_cpu();
+    }
+}
+
+void ObjectPool::unlock() {
+    s_guard.clear(std::memory_order_release);
+}
+
+void ObjectPool::publish_counters(ThreadCache& cache) {
+    if (cache.m_num_hits != 0) {
+        s_num_hits.fetch_add(cache.m_num_hits, std::memory_order_relaxed);
+        cache.m_num_hits = 0;
+    }
+    if (cache.m_num_misses != 0) {
+        s_num_misses.fetch_add(cache.m_num_misses, std::memory_order_relaxed);
+        cache.m_num_misses = 0;
+    }
+    if (cache.m_num_large != 0) {
+        s_num_large.fetch_add(cache.m_num_large, std::memory_order_relaxed);
+        cache.m_num_large = 0;
+    }
+}
+
+void* ObjectPool::refill(ThreadCache& cache, size_t size_class) {
+    size_t i, num_blocks;
+    size_t block_size = (size_class + 1) * SIZE_CLASS_STEP;
+    FreeBlock* block;
+    FreeBlock* shared_head;
+    FreeBlock* shared_tail;
+    char* slab;
+    char* position;
+
+    ++cache.m_num_misses;
+    publish_counters(cache);
+
+    // Take a batch from the shared list
+    lock();
+    for (i = 0; i < BATCH_SIZE + 1 && s_heads[size_class] != nullptr; ++i) {
+        block = s_heads[size_class];
+        s_heads[size_class] = block->m_next;
+        block->m_next = cache.m_heads[size_class];
+        cache.m_heads[size_class] = block;
+    }
+    unlock();
+    cache.m_counts[size_class] += i;
+
+    if (i == 0) {
+        // Carve a new slab; a batch goes to this thread, the rest to the shared list
+        slab = reinterpret_cast<char*>(malloc(SLAB_SIZE));
+        if (slab == nullptr)
+            return nullptr;
+        s_resident_bytes.fetch_add(SLAB_SIZE, std::memory_order_relaxed);
+
+        position = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(slab) + SIZE_CLASS_STEP - 1) & ~(static_cast<uintptr_t>(SIZE_CLASS_STEP) - 1));
+        num_blocks = (SLAB_SIZE - (position - slab)) / block_size;
+
+        for (i = 0; i < BATCH_SIZE + 1 && i < num_blocks; ++i, position += block_size) {
+            block = reinterpret_cast<FreeBlock*>(position);
+            block->m_next = cache.m_heads[size_class];
+            cache.m_heads[size_class] = block;
+        }
+        cache.m_counts[size_class] += i;
+
+        if (i < num_blocks) {
+            shared_head = reinterpret_cast<FreeBlock*>(position);
+            for (; i < num_blocks - 1; ++i, position += block_size)
+                reinterpret_cast<FreeBlock*>(position)->m_next = reinterpret_cast<FreeBlock*>(position + block_size);
+            shared_tail = reinterpret_cast<FreeBlock*>(position);
+
+            lock();
+            shared_tail->m_next = s_heads[size_class];
+            s_heads[size_class] = shared_head;
+            unlock();
+        }
+    }
+
+    block = cache.m_heads[size_class];
+    cache.m_heads[size_class] = block->m_next;
+    --cache.m_counts[size_class];
+    return block;
+}
+
+void ObjectPool::flush(ThreadCache& cache, size_t size_class, size_t count) {
+    size_t i;
+    FreeBlock* head = cache.m_heads[size_class];
+    FreeBlock* tail = head;
+
+    if (count == 0) return;
+
+    // Detach the first count blocks
+    for (i = 1; i < count; ++i)
+        tail = tail->m_next;
+    cache.m_heads[size_class] = tail->m_next;
+    cache.m_counts[size_class] -= count;
+
+    lock();
+    tail->m_next = s_heads[size_class];
+    s_heads[size_class] = head;
+    unlock();
+
+    publish_counters(cache);
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Functions
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+void ObjectPool::flush_thread_cache() {
+    ThreadCache& cache = get_cache();
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i)
+        flush(cache, i, cache.m_counts[i]);
+    publish_counters(cache);
+}
+
+void ObjectPool::get_stats(Stats& stats_out) {
+    publish_counters(get_cache());
+    stats_out.m_num_hits = s_num_hits.load(std::memory_order_relaxed);
+    stats_out.m_num_misses = s_num_misses.load(std::memory_order_relaxed);
+    stats_out.m_num_large = s_num_large.load(std::memory_order_relaxed);
+    stats_out.m_resident_bytes = s_resident_bytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,206 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include "common.h"
+#include "thread_local_slot.h"
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+// Recycles small blocks of memory for objects that are created and destroyed at high rates, such as event records.
+// Sizes are rounded up to one of NUM_SIZE_CLASSES classes, SIZE_CLASS_STEP bytes apart. Each thread keeps its own free
+// lists, so most requests take no lock; blocks move between a thread and the shared lists BATCH_SIZE at a time. Blocks
+// are carved from slabs, which are kept for the lifetime of the process. Requests beyond MAX_SIZE are passed on to
+// malloc and free.
+// Blocks may be freed on a thread other than the one that allocated them.
+class ObjectPool {
+public:
+    // Constants
+    static const size_t SIZE_CLASS_STEP = 16; // in bytes; also the alignment of the blocks
+    static const size_t NUM_SIZE_CLASSES = 16;
+    static const size_t MAX_SIZE = SIZE_CLASS_STEP * NUM_SIZE_CLASSES;
+    static const size_t SLAB_SIZE; // in bytes
+    static const size_t BATCH_SIZE; // in blocks
+    static const unsigned int LOCK_SPIN_COUNT; // pauses before a thread waiting for the shared lists yields
+
+    // Structures
+
+    // Counters since the start of the process. The counts of other threads are published whenever they go to the
+    // shared lists and when they exit, so they may lag behind.
+    struct Stats {
+        unsigned long long m_num_hits; // served from the thread's own free list
+        unsigned long long m_num_misses; // served from the shared lists or a new slab
+        unsigned long long m_num_large; // beyond MAX_SIZE
+        size_t m_resident_bytes; // held in slabs, whether in use or free
+    };
+
+private:
+    // Structures
+    struct FreeBlock {
+        FreeBlock* m_next;
+    };
+
+    struct ThreadCache {
+        FreeBlock* m_heads[NUM_SIZE_CLASSES];
+        size_t m_counts[NUM_SIZE_CLASSES];
+        unsigned long long m_num_hits;
+        unsigned long long m_num_misses;
+        unsigned long long m_num_large;
+
+        ThreadCache();
+        ~ThreadCache(); // hands the blocks back to the shared lists
+    };
+
+    // Variables
+    static ThreadLocalSlot s_cache; // the ThreadCache of the thread, created on first use
+
+    static std::atomic_flag s_guard; // guards the shared lists
+    static FreeBlock* s_heads[NUM_SIZE_CLASSES];
+
+    static std::atomic<unsigned long long> s_num_hits;
+    static std::atomic<unsigned long long> s_num_misses;
+    static std::atomic<unsigned long long> s_num_large;
+    static std::atomic<size_t> s_resident_bytes;
+
+    // Helper Functions
+    static ThreadCache& get_cache();
+    static void M_TLS_CLEANUP delete_cache(void* cache);
+    static size_t get_size_class(size_t size);
+    static void pause_cpu();
+    static void lock();
+    static void unlock();
+    static void publish_counters(ThreadCache& cache);
+    static void* refill(ThreadCache& cache, size_t size_class); // returns one block and caches up to a batch more, or nullptr if out of memory
+    static void flush(ThreadCache& cache, size_t size_class, size_t count);
+
+public:
+    // Returns nullptr if out of memory, like malloc
+    static void* allocate(size_t size);
+    static void deallocate(void* ptr, size_t size); // size must match the allocation
+
+    // Returns nullptr if out of memory
+    template <class T, class... Args>
+    static T* create(Args&&... args);
+
+    template <class T>
+    static void destroy(T* object);
+
+    // Default-initialized items; returns nullptr if out of memory
+    template <class T>
+    static T* create_array(size_t count);
+
+    template <class T>
+    static void destroy_array(T* items, size_t count);
+
+    // Hands the calling thread's free blocks back to the shared lists
+    static void flush_thread_cache();
+
+    static void get_stats(Stats& stats_out);
+};
+
+
+// Define inline functions
+
+inline ObjectPool::ThreadCache& ObjectPool::get_cache() {
+    ThreadCache* cache = static_cast<ThreadCache*>(s_cache.get());
+    if (cache == nullptr) {
+        cache = new ThreadCache;
+        s_cache.set(cache);
+    }
+    return *cache;
+}
+
+inline size_t ObjectPool::get_size_class(size_t size) {
+    return size == 0 ? 0 : (size - 1) / SIZE_CLASS_STEP;
+}
+
+inline void* ObjectPool::allocate(size_t size) {
+    ThreadCache& cache = get_cache();
+    FreeBlock* block;
+    size_t size_class;
+
+    if (size > MAX_SIZE) {
+        ++cache.m_num_large;
+        return malloc(size);
+    }
+
+    size_class = get_size_class(size);
+    block = cache.m_heads[size_class];
+    if (block == nullptr)
+        return refill(cache, size_class);
+
+    cache.m_heads[size_class] = block->m_next;
+    --cache.m_counts[size_class];
+    ++cache.m_num_hits;
+    return block;
+}
+
+inline void ObjectPool::deallocate(void* ptr, size_t size) {
+    ThreadCache& cache = get_cache();
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(ptr);
+    size_t size_class;
+
+    if (ptr == nullptr) return;
+
+    if (size > MAX_SIZE) {
+        free(ptr);
+        return;
+    }
+
+    size_class = get_size_class(size);
+    block->m_next = cache.m_heads[size_class];
+    cache.m_heads[size_class] = block;
+
+    // Keep at most two batches, so that a thread that only frees does not hoard blocks
+    if (++cache.m_counts[size_class] > BATCH_SIZE * 2)
+        flush(cache, size_class, BATCH_SIZE);
+}
+
+
+// Define template functions
+
+template <class T, class... Args>
+T* ObjectPool::create(Args&&... args) {
+    static_assert(std::alignment_of<T>::value <= SIZE_CLASS_STEP, "ObjectPool blocks are not aligned enough for this type");
+    void* ptr = allocate(sizeof(T));
+    if (ptr == nullptr) return nullptr;
+    return new (ptr) T(std::forward<Args>(args)...);
+}
+
+template <class T>
+void ObjectPool::destroy(T* object) {
+    if (object != nullptr) {
+        object->~T();
+        deallocate(object, sizeof(T));
+    }
+}
+
+template <class T>
+T* ObjectPool::create_array(size_t count) {
+    static_assert(std::alignment_of<T>::value <= SIZE_CLASS_STEP, "ObjectPool blocks are not aligned enough for this type");
+    T* items = reinterpret_cast<T*>(allocate(sizeof(T) * count));
+    if (items == nullptr) return nullptr;
+    for (size_t i = 0; i < count; ++i)
+        new (items + i) T;
+    return items;
+}
+
+template <class T>
+void ObjectPool::destroy_array(T* items, size_t count) {
+    if (items != nullptr) {
+        for (size_t i = 0; i < count; ++i)
+            (items + i)->~T();
+        deallocate(items, sizeof(T) * count);
+    }
+}
+
+#endif  /* OBJECT_POOL_H */
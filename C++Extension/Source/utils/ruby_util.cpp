@@ -325,15 +325,15 @@ VALUE RU::to_value(const wchar_t* wc_str, unsigned int wc_str_len) {
 #endif
 }
 
-// Note: the returned string must be freed after use
-wchar_t* RU::value_to_wc_str(VALUE value) {
+// Note: the returned string must be freed after use, unless it is allocated from an arena
+wchar_t* RU::value_to_wc_str(VALUE value, Arena* arena) {
 #ifdef HAVE_RUBY_ENCODING_H
     VALUE v_str = StringValue(value);
     rb_encoding* enc = rb_enc_get(v_str);
     char* begin = RSTRING_PTR(v_str);
     char* end = RSTRING_END(v_str);
     unsigned int wc_str_len = static_cast<unsigned int>(rb_enc_strlen(begin, end, enc));
-    wchar_t* res_str = new wchar_t[wc_str_len + 1];
+    wchar_t* res_str = arena ? reinterpret_cast<wchar_t*>(arena->allocate(sizeof(wchar_t) * (wc_str_len + 1), sizeof(wchar_t))) : new wchar_t[wc_str_len + 1];
     unsigned int i;
     char* last = begin;
     char* next;
@@ -348,7 +348,7 @@ wchar_t* RU::value_to_wc_str(VALUE value) {
     VALUE v_str = StringValue(value);
     char* c_str = RSTRING_PTR(v_str);
     unsigned int c_len = static_cast<unsigned int>(RSTRING_LEN(v_str));
-    wchar_t* res_str = new wchar_t[c_len + 1];
+    wchar_t* res_str = arena ? reinterpret_cast<wchar_t*>(arena->allocate(sizeof(wchar_t) * (c_len + 1), sizeof(wchar_t))) : new wchar_t[c_len + 1];
     unsigned int i;
     for (i = 0; i < c_len; ++i)
         res_str[i] = c_str[i];
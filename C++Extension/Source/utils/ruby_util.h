@@ -19,11 +19,25 @@
 #include "geom_quaternion.h"
 #include "geom_bounding_box.h"
 #include "geom_box_space.h"
+#include "geom_float.h"
+#include "geom_ray.h"
+#include "geom_point_array.h"
 
+#include "arena.h"
+#include "atomic_bit_buffer.h"
 #include "bit_buffer.h"
+#include "blocking_queue.h"
 #include "buffer.h"
+#include "cpu_features.h"
 #include "dynamic_array.h"
 #include "fast_queue.h"
+#include "flat_hash_map.h"
+#include "large_block.h"
+#include "mpmc_queue.h"
+#include "object_pool.h"
+#include "small_vector.h"
+#include "spsc_queue.h"
+#include "task_graph.h"
 #include "thread_hive.h"
 
 namespace RU {
@@ -309,7 +323,8 @@ namespace RU {
         return StringValuePtr(value);
     }
 
-    wchar_t* value_to_wc_str(VALUE value);
+    // The returned string must be freed with delete[], unless it is allocated from an arena
+    wchar_t* value_to_wc_str(VALUE value, Arena* arena = nullptr);
 
 
     inline bool value_to_bool(VALUE value) {
@@ -0,0 +1,384 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include "common.h"
+
+#include <type_traits>
+#include <utility>
+
+// An array that keeps up to N items within itself and only moves them to the heap when it grows beyond that, for short
+// temporary lists, such as the vertices of a face.
+template <class T, size_t N>
+class SmallVector {
+protected:
+    static_assert(N > 0, "SmallVector requires room for at least one inline item");
+
+    // Type-defines
+    typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type Storage;
+
+    // Variables
+    T* m_data; // points to m_inline until the items spill to the heap
+    size_t m_capacity;
+    size_t m_size;
+    Storage m_inline[N];
+
+    // Helper Functions
+    void grow();
+    void reallocate(size_t new_capacity);
+    T* get_inline();
+
+    // Moves count items to uninitialized memory, leaving the source uninitialized
+    static void relocate(T* dest, T* src, size_t count, std::true_type trivially_copyable);
+    static void relocate(T* dest, T* src, size_t count, std::false_type trivially_copyable);
+
+    // Takes over the other's items, leaving it empty
+    void take_from(SmallVector<T, N>& other);
+
+public:
+    SmallVector();
+    SmallVector(const SmallVector<T, N>& other);
+    SmallVector(SmallVector<T, N>&& other);
+    SmallVector<T, N>& operator=(const SmallVector<T, N>& other);
+    SmallVector<T, N>& operator=(SmallVector<T, N>&& other);
+    virtual ~SmallVector();
+
+    size_t size() const;
+    size_t capacity() const;
+    bool empty() const;
+    bool is_inline() const; // whether the items are still kept within the vector
+    void clear(); // preserves space
+    void reset(); // frees heap space, if any
+
+    void append(const T& item);
+    void append(T&& item);
+
+    template <class... Args>
+    T& emplace_back(Args&&... args);
+
+    T pop();
+
+    // Warning: the ordering is not preserved
+    void remove_at(size_t index);
+
+    // Makes room for count items in total, without changing the size
+    void reserve(size_t count);
+
+    // Default-initializes new spots or destructs the excess ones
+    void resize(size_t count);
+
+    const T& first() const;
+    const T& last() const;
+
+    T& first();
+    T& last();
+
+    T* begin();
+    T* end();
+    const T* begin() const;
+    const T* end() const;
+
+    T* pat(size_t index) const;
+    T& operator[](size_t index); // does not perform boundary checks
+    const T& operator[](size_t index) const; // does not perform boundary checks
+};
+
+
+// Define template functions
+
+template <class T, size_t N>
+SmallVector<T, N>::SmallVector() :
+    m_capacity(N),
+    m_size(0)
+{
+    m_data = get_inline();
+}
+
+template <class T, size_t N>
+SmallVector<T, N>::SmallVector(const SmallVector<T, N>& other) :
+    m_capacity(N),
+    m_size(0)
+{
+    size_t i;
+
+    m_data = get_inline();
+    reserve(other.m_size);
+
+    // Deep copy
+    for (i = 0; i < other.m_size; ++i)
+        new (m_data + i) T(other.m_data[i]);
+    m_size = other.m_size;
+}
+
+template <class T, size_t N>
+SmallVector<T, N>::SmallVector(SmallVector<T, N>&& other) :
+    m_capacity(N),
+    m_size(0)
+{
+    m_data = get_inline();
+    take_from(other);
+}
+
+template <class T, size_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(const SmallVector<T, N>& other) {
+    if (this != &other) {
+        size_t i;
+
+        clear();
+        reserve(other.m_size);
+
+        // Deep copy
+        for (i = 0; i < other.m_size; ++i)
+            new (m_data + i) T(other.m_data[i]);
+        m_size = other.m_size;
+    }
+    return *this;
+}
+
+template <class T, size_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(SmallVector<T, N>&& other) {
+    if (this != &other) {
+        reset();
+        take_from(other);
+    }
+    return *this;
+}
+
+template <class T, size_t N>
+SmallVector<T, N>::~SmallVector() {
+    reset();
+}
+
+template <class T, size_t N>
+inline T* SmallVector<T, N>::get_inline() {
+    return reinterpret_cast<T*>(m_inline);
+}
+
+template <class T, size_t N>
+inline void SmallVector<T, N>::relocate(T* dest, T* src, size_t count, std::true_type trivially_copyable) {
+    memcpy((void*)dest, (void*)src, count * sizeof(T));
+}
+
+template <class T, size_t N>
+void SmallVector<T, N>::relocate(T* dest, T* src, size_t count, std::false_type trivially_copyable) {
+    for (size_t i = 0; i < count; ++i) {
+        new (dest + i) T(std::move(src[i]));
+        (src + i)->~T();
+    }
+}
+
+template <class T, size_t N>
+void SmallVector<T, N>::take_from(SmallVector<T, N>& other) {
+    if (other.is_inline()) {
+        // Inline items have to be moved one by one
+        relocate(m_data, other.m_data, other.m_size, std::is_trivially_copyable<T>());
+    }
+    else {
+        // Heap space can be handed over as is
+        m_data = other.m_data;
+        m_capacity = other.m_capacity;
+        other.m_data = other.get_inline();
+        other.m_capacity = N;
+    }
+    m_size = other.m_size;
+    other.m_size = 0;
+}
+
+template <class T, size_t N>
+void SmallVector<T, N>::reallocate(size_t new_capacity) {
+    T* new_data;
+
+    if (!is_inline() && std::is_trivially_copyable<T>::value)
+        new_data = reinterpret_cast<T*>(realloc((void*)m_data, sizeof(T) * new_capacity));
+    else {
+        new_data = reinterpret_cast<T*>(malloc(sizeof(T) * new_capacity));
+        relocate(new_data, m_data, m_size, std::is_trivially_copyable<T>());
+        if (!is_inline())
+            free(m_data);
+    }
+
+    m_data = new_data;
+    m_capacity = new_capacity;
+}
+
+template <class T, size_t N>
+inline void SmallVector<T, N>::grow() {
+    if (m_size == m_capacity)
+        reallocate(m_capacity << 1);
+}
+
+template <class T, size_t N>
+inline size_t SmallVector<T, N>::size() const {
+    return m_size;
+}
+
+template <class T, size_t N>
+inline size_t SmallVector<T, N>::capacity() const {
+    return m_capacity;
+}
+
+template <class T, size_t N>
+inline bool SmallVector<T, N>::empty() const {
+    return m_size == 0;
+}
+
+template <class T, size_t N>
+inline bool SmallVector<T, N>::is_inline() const {
+    return m_data == reinterpret_cast<const T*>(m_inline);
+}
+
+template <class T, size_t N>
+void SmallVector<T, N>::clear() {
+    // Destruct
+    for (size_t i = 0; i < m_size; ++i)
+        (m_data + i)->~T();
+
+    m_size = 0;
+}
+
+template <class T, size_t N>
+void SmallVector<T, N>::reset() {
+    clear();
+
+    if (!is_inline()) {
+        free(m_data);
+        m_data = get_inline();
+        m_capacity = N;
+    }
+}
+
+template <class T, size_t N>
+inline void SmallVector<T, N>::append(const T& item) {
+    grow();
+
+    new (m_data + m_size) T(item);
+
+    ++m_size;
+}
+
+template <class T, size_t N>
+inline void SmallVector<T, N>::append(T&& item) {
+    grow();
+
+    new (m_data + m_size) T(std::move(item));
+
+    ++m_size;
+}
+
+template <class T, size_t N>
+template <class... Args>
+inline T& SmallVector<T, N>::emplace_back(Args&&... args) {
+    grow();
+
+    T* item = new (m_data + m_size) T(std::forward<Args>(args)...);
+
+    ++m_size;
+
+    return *item;
+}
+
+template <class T, size_t N>
+T SmallVector<T, N>::pop() {
+    --m_size;
+
+    T v(std::move(m_data[m_size]));
+
+    (m_data + m_size)->~T();
+
+    return v;
+}
+
+template <class T, size_t N>
+void SmallVector<T, N>::remove_at(size_t index) {
+    --m_size;
+    if (index != m_size)
+        m_data[index] = std::move(m_data[m_size]);
+    (m_data + m_size)->~T();
+}
+
+template <class T, size_t N>
+void SmallVector<T, N>::reserve(size_t count) {
+    if (count > m_capacity)
+        reallocate(count);
+}
+
+template <class T, size_t N>
+void SmallVector<T, N>::resize(size_t count) {
+    size_t i;
+
+    // Destruct the excess
+    for (i = count; i < m_size; ++i)
+        (m_data + i)->~T();
+
+    reserve(count);
+
+    // Initialize the new spots
+    for (i = m_size; i < count; ++i)
+        new (m_data + i) T;
+
+    m_size = count;
+}
+
+template <class T, size_t N>
+inline const T& SmallVector<T, N>::first() const {
+    return m_data[0];
+}
+
+template <class T, size_t N>
+inline const T& SmallVector<T, N>::last() const {
+    return m_data[m_size - 1];
+}
+
+template <class T, size_t N>
+inline T& SmallVector<T, N>::first() {
+    return m_data[0];
+}
+
+template <class T, size_t N>
+inline T& SmallVector<T, N>::last() {
+    return m_data[m_size - 1];
+}
+
+template <class T, size_t N>
+inline T* SmallVector<T, N>::begin() {
+    return m_data;
+}
+
+template <class T, size_t N>
+inline T* SmallVector<T, N>::end() {
+    return m_data + m_size;
+}
+
+template <class T, size_t N>
+inline const T* SmallVector<T, N>::begin() const {
+    return m_data;
+}
+
+template <class T, size_t N>
+inline const T* SmallVector<T, N>::end() const {
+    return m_data + m_size;
+}
+
+template <class T, size_t N>
+inline T* SmallVector<T, N>::pat(size_t index) const {
+    return m_data + index;
+}
+
+template <class T, size_t N>
+inline T& SmallVector<T, N>::operator[](size_t index) {
+    return m_data[index];
+}
+
+template <class T, size_t N>
+inline const T& SmallVector<T, N>::operator[](size_t index) const {
+    return m_data[index];
+}
+
+#endif  /* SMALL_VECTOR_H */
@@ -0,0 +1,193 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include "common.h"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// A bounded lock-free queue for exactly one producer thread and one consumer thread, such as a hook thread handing
+// events to the Ruby thread. Each side keeps a cached copy of the other side's position, so the shared positions are
+// only read when the cached one suggests the queue is full or empty.
+template <class T>
+class SpscQueue {
+private:
+    // Disable copy constructor and assignment operator
+    SpscQueue(const SpscQueue<T>& other);
+    SpscQueue<T>& operator=(const SpscQueue<T>& other);
+
+    // Type-defines
+    typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type Storage;
+
+    // Variables
+    Storage* m_data;
+    size_t m_mask;
+    char m_padding1[64];
+    std::atomic<size_t> m_tail; // written by the producer
+    size_t m_cached_head;
+    char m_padding2[64];
+    std::atomic<size_t> m_head; // written by the consumer
+    size_t m_cached_tail;
+    char m_padding3[64];
+
+    // Helper Functions
+    T* item_at(size_t pos);
+
+public:
+    // The capacity is rounded up to a power of two
+    SpscQueue(unsigned int capacity);
+    virtual ~SpscQueue();
+
+    unsigned int capacity() const;
+    unsigned int size() const; // approximate while the other thread accesses the queue
+    bool empty() const; // approximate while the other thread accesses the queue
+
+    // Producer side
+    bool try_enqueue(const T& item); // returns false if full
+    void enqueue(const T& item); // spins, and then yields, until there is room
+    unsigned int enqueue_n(const T* items, unsigned int count); // returns the number of items that fit
+
+    // Consumer side
+    bool try_dequeue(T& item_out); // returns false if empty
+    void dequeue(T& item_out); // spins, and then yields, until there is an item
+    unsigned int dequeue_n(T* items_out, unsigned int count); // returns the number of items available
+};
+
+
+// Define template functions
+
+template <class T>
+SpscQueue<T>::SpscQueue(unsigned int capacity) :
+    m_cached_head(0),
+    m_cached_tail(0)
+{
+    size_t cap = 2;
+
+    while (cap < capacity)
+        cap <<= 1;
+    m_mask = cap - 1;
+
+    m_data = reinterpret_cast<Storage*>(malloc(sizeof(Storage) * cap));
+
+    m_tail.store(0, std::memory_order_relaxed);
+    m_head.store(0, std::memory_order_relaxed);
+}
+
+template <class T>
+SpscQueue<T>::~SpscQueue() {
+    size_t pos;
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+
+    // Destruct remaining items
+    for (pos = m_head.load(std::memory_order_relaxed); pos != tail; ++pos)
+        item_at(pos)->~T();
+
+    free(m_data);
+}
+
+template <class T>
+inline T* SpscQueue<T>::item_at(size_t pos) {
+    return reinterpret_cast<T*>(m_data + (pos & m_mask));
+}
+
+template <class T>
+inline unsigned int SpscQueue<T>::capacity() const {
+    return static_cast<unsigned int>(m_mask + 1);
+}
+
+template <class T>
+inline unsigned int SpscQueue<T>::size() const {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    return static_cast<ptrdiff_t>(tail - head) > 0 ? static_cast<unsigned int>(tail - head) : 0;
+}
+
+template <class T>
+inline bool SpscQueue<T>::empty() const {
+    return size() == 0;
+}
+
+template <class T>
+inline bool SpscQueue<T>::try_enqueue(const T& item) {
+    return enqueue_n(&item, 1) != 0;
+}
+
+template <class T>
+void SpscQueue<T>::enqueue(const T& item) {
+    unsigned int attempt = 0;
+    while (enqueue_n(&item, 1) == 0) {
+        if (++attempt > 64)
+            std::this_thread::yield();
+    }
+}
+
+template <class T>
+unsigned int SpscQueue<T>::enqueue_n(const T* items, unsigned int count) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t room = m_mask + 1 - (tail - m_cached_head);
+    size_t i;
+
+    if (room < count) {
+        m_cached_head = m_head.load(std::memory_order_acquire);
+        room = m_mask + 1 - (tail - m_cached_head);
+        if (room < count)
+            count = static_cast<unsigned int>(room);
+    }
+
+    for (i = 0; i < count; ++i)
+        new (item_at(tail + i)) T(items[i]);
+    m_tail.store(tail + count, std::memory_order_release);
+
+    return count;
+}
+
+template <class T>
+inline bool SpscQueue<T>::try_dequeue(T& item_out) {
+    return dequeue_n(&item_out, 1) != 0;
+}
+
+template <class T>
+void SpscQueue<T>::dequeue(T& item_out) {
+    unsigned int attempt = 0;
+    while (dequeue_n(&item_out, 1) == 0) {
+        if (++attempt > 64)
+            std::this_thread::yield();
+    }
+}
+
+template <class T>
+unsigned int SpscQueue<T>::dequeue_n(T* items_out, unsigned int count) {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    size_t available = m_cached_tail - head;
+    size_t i;
+    T* item;
+
+    if (available < count) {
+        m_cached_tail = m_tail.load(std::memory_order_acquire);
+        available = m_cached_tail - head;
+        if (available < count)
+            count = static_cast<unsigned int>(available);
+    }
+
+    for (i = 0; i < count; ++i) {
+        item = item_at(head + i);
+        items_out[i] = std::move(*item);
+        item->~T();
+    }
+    m_head.store(head + count, std::memory_order_release);
+
+    return count;
+}
+
+#endif  /* SPSC_QUEUE_H */
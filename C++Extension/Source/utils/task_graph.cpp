@@ -0,0 +1,172 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#include "task_graph.h"
+
+
+TaskGraph::TaskGraph() :
+    m_group(nullptr),
+    m_timing_enabled(false)
+{
+}
+
+TaskGraph::~TaskGraph() {
+    clear();
+}
+
+void TaskGraph::node_task(void* user_data, ThreadHive* hive) {
+    Node* node = reinterpret_cast<Node*>(user_data);
+    TaskGraph* graph = node->m_graph;
+    Node* successor;
+    unsigned int i;
+
+    if (graph->m_timing_enabled)
+        node->m_start_time = graph->get_elapsed_time();
+
+    node->m_task_callback(node->m_user_data, hive);
+
+    if (graph->m_timing_enabled)
+        node->m_finish_time = graph->get_elapsed_time();
+
+    // Release the successors this node was the last to wait for; they are enqueued from within the task, so in the
+    // work-stealing mode they stay on this bee unless stolen
+    for (i = 0; i < node->m_successors.size(); ++i) {
+        successor = graph->m_nodes[node->m_successors[i]];
+        if (successor->m_num_waiting.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            successor->m_releaser = node->m_index;
+            hive->enqueue(*graph->m_group, &node_task, successor);
+        }
+    }
+}
+
+bool TaskGraph::is_acyclic() const {
+    unsigned int num_nodes = static_cast<unsigned int>(m_nodes.size());
+    unsigned int* num_waiting = new unsigned int[num_nodes];
+    DynamicArray<unsigned int> ready;
+    unsigned int num_visited = 0;
+    unsigned int i, j, index;
+
+    for (i = 0; i < num_nodes; ++i) {
+        num_waiting[i] = m_nodes[i]->m_num_predecessors;
+        if (num_waiting[i] == 0)
+            ready.append(i);
+    }
+
+    while (!ready.empty()) {
+        index = ready.pop();
+        ++num_visited;
+        const Node* node = m_nodes[index];
+        for (j = 0; j < node->m_successors.size(); ++j) {
+            if (--num_waiting[node->m_successors[j]] == 0)
+                ready.append(node->m_successors[j]);
+        }
+    }
+
+    delete[] num_waiting;
+    return num_visited == num_nodes;
+}
+
+unsigned int TaskGraph::add_task(TaskCallback task_callback, void* user_data, const char* name) {
+    Node* node = new Node;
+    node->m_graph = this;
+    node->m_task_callback = task_callback;
+    node->m_user_data = user_data;
+    node->m_name = name;
+    node->m_index = static_cast<unsigned int>(m_nodes.size());
+    node->m_num_predecessors = 0;
+    node->m_num_waiting.store(0);
+    node->m_releaser = node->m_index;
+    node->m_start_time = 0.0;
+    node->m_finish_time = 0.0;
+
+    m_nodes.append(node);
+    return node->m_index;
+}
+
+void TaskGraph::add_dependency(unsigned int predecessor, unsigned int successor) {
+    assert(predecessor < m_nodes.size() && successor < m_nodes.size());
+    m_nodes[predecessor]->m_successors.append(successor);
+    ++m_nodes[successor]->m_num_predecessors;
+}
+
+void TaskGraph::clear() {
+    for (unsigned int i = 0; i < m_nodes.size(); ++i)
+        delete m_nodes[i];
+    m_nodes.clear();
+}
+
+void TaskGraph::set_timing_enabled(bool state) {
+    m_timing_enabled = state;
+}
+
+bool TaskGraph::run(ThreadHive& hive) {
+    ThreadHive::TaskGroup group;
+    Node* node;
+    unsigned int i;
+
+    if (!is_acyclic()) return false;
+
+    // All counters must be reset before the first root is enqueued
+    for (i = 0; i < m_nodes.size(); ++i) {
+        node = m_nodes[i];
+        node->m_num_waiting.store(node->m_num_predecessors, std::memory_order_relaxed);
+        node->m_releaser = i;
+        node->m_start_time = 0.0;
+        node->m_finish_time = 0.0;
+    }
+
+    m_group = &group;
+    m_run_start = Clock::now();
+
+    for (i = 0; i < m_nodes.size(); ++i) {
+        if (m_nodes[i]->m_num_predecessors == 0)
+            hive.enqueue(group, &node_task, m_nodes[i]);
+    }
+
+    hive.wait(group);
+    m_group = nullptr;
+
+    return true;
+}
+
+void TaskGraph::print_critical_path(FILE* stream) const {
+    DynamicArray<const Node*> path;
+    const Node* node = nullptr;
+    const Node* releaser;
+    unsigned int i;
+    double ready_time;
+
+    if (!m_timing_enabled || m_nodes.empty()) {
+        fprintf(stream, "TaskGraph: no timing data\n");
+        return;
+    }
+
+    // The node that finished last ends the critical path; every node was held back by its releaser
+    for (i = 0; i < m_nodes.size(); ++i) {
+        if (node == nullptr || m_nodes[i]->m_finish_time > node->m_finish_time)
+            node = m_nodes[i];
+    }
+    while (true) {
+        path.append(node);
+        if (node->m_releaser == node->m_index) break;
+        node = m_nodes[node->m_releaser];
+    }
+
+    fprintf(stream, "TaskGraph: critical path of %u tasks, %.3f ms\n", static_cast<unsigned int>(path.size()), path.first()->m_finish_time * 1000.0);
+    fprintf(stream, "%12s %12s %12s  %s\n", "start (ms)", "wait (ms)", "run (ms)", "task");
+    for (i = static_cast<unsigned int>(path.size()); i-- > 0;) {
+        node = path[i];
+        releaser = m_nodes[node->m_releaser];
+        ready_time = releaser != node ? releaser->m_finish_time : 0.0;
+        fprintf(stream, "%12.3f %12.3f %12.3f  ", node->m_start_time * 1000.0, (node->m_start_time - ready_time) * 1000.0, (node->m_finish_time - node->m_start_time) * 1000.0);
+        if (node->m_name != nullptr)
+            fprintf(stream, "%s\n", node->m_name);
+        else
+            fprintf(stream, "#%u\n", node->m_index);
+    }
+}
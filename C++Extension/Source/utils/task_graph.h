@@ -0,0 +1,100 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include "thread_hive.h"
+#include "dynamic_array.h"
+
+#include <chrono>
+
+// Runs tasks on a ThreadHive in dependency order. A task is enqueued as soon as the last of its predecessors completes,
+// so independent chains overlap rather than being separated by hive-wide barriers.
+class TaskGraph {
+public:
+    // Type-defines
+    typedef ThreadHive::TaskCallback TaskCallback;
+
+private:
+    // Disable copy constructor and assignment operator
+    TaskGraph(const TaskGraph& other);
+    TaskGraph& operator=(const TaskGraph& other);
+
+    // Type-defines
+    typedef std::chrono::steady_clock Clock;
+
+    // Structures
+    struct Node {
+        TaskGraph* m_graph;
+        TaskCallback m_task_callback;
+        void* m_user_data;
+        const char* m_name;
+        unsigned int m_index;
+        DynamicArray<unsigned int> m_successors;
+        unsigned int m_num_predecessors;
+        std::atomic<unsigned int> m_num_waiting; // predecessors yet to complete in the current run
+        unsigned int m_releaser; // predecessor that completed last; equals the node's own index for roots
+        double m_start_time; // seconds since the start of the run
+        double m_finish_time;
+    };
+
+    // Variables
+    DynamicArray<Node*> m_nodes;
+    ThreadHive::TaskGroup* m_group;
+    Clock::time_point m_run_start;
+    bool m_timing_enabled;
+
+    // Helper Functions
+    static void node_task(void* user_data, ThreadHive* hive);
+
+    double get_elapsed_time() const;
+    bool is_acyclic() const;
+
+public:
+    TaskGraph();
+    virtual ~TaskGraph();
+
+    // Adds a task and returns its index. The name, if any, is referenced rather than copied.
+    unsigned int add_task(TaskCallback task_callback, void* user_data, const char* name = nullptr);
+
+    // Makes successor wait for predecessor to complete
+    void add_dependency(unsigned int predecessor, unsigned int successor);
+
+    unsigned int get_num_tasks() const;
+    void clear();
+
+    // Records start and finish times of the tasks during subsequent runs, for print_critical_path
+    void set_timing_enabled(bool state);
+    bool get_timing_enabled() const;
+
+    // Runs all tasks and waits for them to complete. Safe to call from within a task of the same hive. The graph can
+    // be run again afterwards. Returns false, without running anything, if the dependencies contain a cycle.
+    bool run(ThreadHive& hive);
+
+    // Prints the chain of tasks that determined the length of the last timed run, along with the time every task spent
+    // waiting for a bee after becoming runnable
+    void print_critical_path(FILE* stream) const;
+};
+
+
+// Define inline functions
+
+inline unsigned int TaskGraph::get_num_tasks() const {
+    return static_cast<unsigned int>(m_nodes.size());
+}
+
+inline bool TaskGraph::get_timing_enabled() const {
+    return m_timing_enabled;
+}
+
+inline double TaskGraph::get_elapsed_time() const {
+    return std::chrono::duration<double>(Clock::now() - m_run_start).count();
+}
+
+#endif  /* TASK_GRAPH_H */
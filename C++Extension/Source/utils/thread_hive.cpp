@@ -10,6 +10,15 @@
 #include <string.h>
 
 
+const unsigned int ThreadHive::DEFAULT_SPIN_COUNT(1000);
+const unsigned int ThreadHive::NUM_IDLE_YIELDS(10);
+
+ThreadLocalSlot ThreadHive::s_current_bee;
+ThreadLocalSlot ThreadHive::s_current_priority;
+static_assert(ThreadHive::PRIORITY_INTERACTIVE == 0, "A thread that never set its priority reads as interactive");
+ThreadHive* ThreadHive::s_first_hive = nullptr;
+std::atomic_flag ThreadHive::s_hives_guard = ATOMIC_FLAG_INIT;
+
 unsigned int ThreadHive::get_num_processors() {
 #ifdef _WIN32
     _SYSTEM_INFO sinfo;
@@ -20,260 +29,747 @@ unsigned int ThreadHive::get_num_processors() {
 #endif
 }
 
-ThreadHive::ThreadHive(unsigned int num_bees) :
-    m_num_bees(num_bees),
-    m_num_working(0),
-    m_sem_val(0)
+ThreadHive::ThreadHive(unsigned int num_bees, Mode mode, unsigned int spin_count) :
+    m_num_wakeups(0),
+    m_spin_count(spin_count),
+    m_mode(mode),
+    m_terminate(false),
+    m_affinity_enabled(false),
+    m_num_queued(0),
+    m_num_background(0),
+    m_num_pending(0),
+    m_num_sleeping(0),
+    m_next_bee(0),
+    m_num_live(0),
+    m_num_idle(0),
+    m_idle_timeout(0)
 {
-#ifdef _WIN32
-    m_bees = (HANDLE*)malloc(sizeof(HANDLE) * m_num_bees);
-    memset(m_bees, 0, sizeof(HANDLE) * m_num_bees);
-
-    //InitializeCriticalSectionAndSpinCount(&m_queue_mutex, 0x00000400);
-    //InitializeCriticalSectionAndSpinCount(&m_user_mutex, 0x00000400);
-    InitializeCriticalSection(&m_queue_mutex);
-    InitializeCriticalSection(&m_user_mutex);
-    InitializeCriticalSection(&m_sem_mutex);
-    InitializeConditionVariable(&m_all_idle_cond);
-    InitializeConditionVariable(&m_sem_cond);
-
-    for (unsigned int i = 0; i < m_num_bees; ++i) {
-        m_bees[i] = CreateThread(NULL, 0, thread_task, this, 0, NULL);
-    }
-#else
-    m_bees = (pthread_t*)malloc(sizeof(pthread_t) * m_num_bees);
-    memset(m_bees, 0, sizeof(pthread_t) * m_num_bees);
-
-    pthread_mutex_init(&m_queue_mutex, NULL);
-    pthread_mutex_init(&m_user_mutex, NULL);
-    pthread_mutex_init(&m_sem_mutex, NULL);
-    pthread_cond_init(&m_all_idle_cond, NULL);
-    pthread_cond_init(&m_sem_cond, NULL);
+    unsigned int i;
 
-    for (unsigned int i = 0; i < m_num_bees; ++i) {
-        pthread_create(m_bees + i, NULL, &thread_task, this);
+    if (num_bees == 0) num_bees = 1;
+    m_max_bees = get_num_processors();
+    if (m_max_bees < num_bees) m_max_bees = num_bees;
+    m_num_bees.store(num_bees);
+
+    init_mutex(m_bees_mutex);
+    init_mutex(m_queue_mutex);
+    init_mutex(m_background_mutex);
+    init_mutex(m_user_mutex);
+    init_mutex(m_sem_mutex);
+    init_condition(m_all_idle_cond);
+    init_condition(m_sem_cond);
+
+    m_bees = new Bee[m_max_bees];
+    m_counters = allocate_counters(m_max_bees + 1);
+
+    // Bees steal from each other, so all slots must be set up before any bee is started
+    for (i = 0; i < m_max_bees; ++i) {
+        m_bees[i].m_hive = this;
+        m_bees[i].m_index = i;
+        m_bees[i].m_num_tasks.store(0);
+        m_bees[i].m_state.store(BEE_STOPPED);
+        init_mutex(m_bees[i].m_tasks_mutex);
     }
-#endif
+
+    lock_mutex(m_bees_mutex);
+    for (i = 0; i < num_bees; ++i)
+        start_bee(m_bees + i);
+    unlock_mutex(m_bees_mutex);
+
+    // Register
+    while (s_hives_guard.test_and_set(std::memory_order_acquire))
+        yield_thread();
+    m_next_hive = s_first_hive;
+    s_first_hive = this;
+    s_hives_guard.clear(std::memory_order_release);
 }
 
 ThreadHive::~ThreadHive() {
     unsigned int i;
+    ThreadHive** link;
+
+    // Unregister
+    while (s_hives_guard.test_and_set(std::memory_order_acquire))
+        yield_thread();
+    for (link = &s_first_hive; *link != this; link = &(*link)->m_next_hive) {}
+    *link = m_next_hive;
+    s_hives_guard.clear(std::memory_order_release);
 
     wait_until_finished();
+
+    // Bees are no longer started once terminating
+    lock_mutex(m_bees_mutex);
+    lock_mutex(m_sem_mutex);
+    m_terminate.store(true);
+    broadcast_condition(m_sem_cond);
+    unlock_mutex(m_sem_mutex);
+    unlock_mutex(m_bees_mutex);
+
+    for (i = 0; i < m_max_bees; ++i) {
+        if (m_bees[i].m_state.load() != BEE_STOPPED)
+            join_thread(m_bees[i].m_thread);
+    }
+
+    // Bees poll each other's deques until they exit, so none may go before all are joined
+    for (i = 0; i < m_max_bees; ++i)
+        destroy_mutex(m_bees[i].m_tasks_mutex);
+
+    delete[] m_bees;
+    free_counters(m_counters);
+
+    destroy_mutex(m_bees_mutex);
+    destroy_mutex(m_queue_mutex);
+    destroy_mutex(m_background_mutex);
+    destroy_mutex(m_user_mutex);
+    destroy_mutex(m_sem_mutex);
+    destroy_condition(m_all_idle_cond);
+    destroy_condition(m_sem_cond);
+}
+
 #ifdef _WIN32
 
-    EnterCriticalSection(&m_sem_mutex);
-    m_sem_val = 2; // terminate
-    WakeAllConditionVariable(&m_sem_cond);
-    LeaveCriticalSection(&m_sem_mutex);
+DWORD WINAPI ThreadHive::thread_task(LPVOID arg) {
+    Bee* bee = reinterpret_cast<Bee*>(arg);
+    bee->m_hive->run_bee(bee);
+    return 0;
+}
 
-    WaitForMultipleObjects(m_num_bees, m_bees, TRUE, INFINITE);
+void ThreadHive::init_mutex(Mutex& mutex) {
+    InitializeCriticalSection(&mutex);
+}
 
-    for (i = 0; i < m_num_bees; ++i) {
-        if (m_bees[i] != NULL)
-            CloseHandle(m_bees[i]);
-    }
+void ThreadHive::destroy_mutex(Mutex& mutex) {
+    DeleteCriticalSection(&mutex);
+}
+
+void ThreadHive::lock_mutex(Mutex& mutex) {
+    EnterCriticalSection(&mutex);
+}
+
+void ThreadHive::unlock_mutex(Mutex& mutex) {
+    LeaveCriticalSection(&mutex);
+}
 
-    DeleteCriticalSection(&m_queue_mutex);
-    DeleteCriticalSection(&m_user_mutex);
-    DeleteCriticalSection(&m_sem_mutex);
+void ThreadHive::init_condition(Condition& cond) {
+    InitializeConditionVariable(&cond);
+}
+
+void ThreadHive::destroy_condition(Condition& cond) {
     // Condition variables cannot be deleted on Windows
+}
+
+void ThreadHive::wait_condition(Condition& cond, Mutex& mutex) {
+    SleepConditionVariableCS(&cond, &mutex, INFINITE);
+}
+
+bool ThreadHive::wait_condition_timed(Condition& cond, Mutex& mutex, unsigned int milliseconds) {
+    return SleepConditionVariableCS(&cond, &mutex, milliseconds) != 0;
+}
+
+void ThreadHive::signal_condition(Condition& cond) {
+    WakeConditionVariable(&cond);
+}
+
+void ThreadHive::broadcast_condition(Condition& cond) {
+    WakeAllConditionVariable(&cond);
+}
+
+void ThreadHive::yield_thread() {
+    SwitchToThread();
+}
+
+void ThreadHive::pause_cpu() {
+    YieldProcessor();
+}
+
+void ThreadHive::join_thread(Thread& thread) {
+    if (thread != NULL) {
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+        thread = NULL;
+    }
+}
+
+void ThreadHive::set_thread_affinity(Thread& thread, int processor) {
+    DWORD_PTR process_mask, system_mask;
+    if (thread == NULL) return;
+    if (processor < 0) {
+        GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+        SetThreadAffinityMask(thread, process_mask);
+    }
+    else
+        SetThreadAffinityMask(thread, static_cast<DWORD_PTR>(1) << (processor % (sizeof(DWORD_PTR) * 8)));
+}
 
 #else
 
-    pthread_mutex_lock(&m_sem_mutex);
-    m_sem_val = 2; // terminate
-    pthread_cond_broadcast(&m_sem_cond);
-    pthread_mutex_unlock(&m_sem_mutex);
+void* ThreadHive::thread_task(void* arg) {
+    Bee* bee = reinterpret_cast<Bee*>(arg);
+    bee->m_hive->run_bee(bee);
+    return 0;
+}
+
+void ThreadHive::init_mutex(Mutex& mutex) {
+    pthread_mutex_init(&mutex, NULL);
+}
+
+void ThreadHive::destroy_mutex(Mutex& mutex) {
+    pthread_mutex_destroy(&mutex);
+}
+
+void ThreadHive::lock_mutex(Mutex& mutex) {
+    pthread_mutex_lock(&mutex);
+}
+
+void ThreadHive::unlock_mutex(Mutex& mutex) {
+    pthread_mutex_unlock(&mutex);
+}
+
+void ThreadHive::init_condition(Condition& cond) {
+    pthread_cond_init(&cond, NULL);
+}
 
-    for (i = 0; i < m_num_bees; ++i) {
-        if (m_bees[i] != NULL)
-            pthread_join(m_bees[i], NULL);
+void ThreadHive::destroy_condition(Condition& cond) {
+    pthread_cond_destroy(&cond);
+}
+
+void ThreadHive::wait_condition(Condition& cond, Mutex& mutex) {
+    pthread_cond_wait(&cond, &mutex);
+}
+
+bool ThreadHive::wait_condition_timed(Condition& cond, Mutex& mutex, unsigned int milliseconds) {
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += milliseconds / 1000;
+    deadline.tv_nsec += (milliseconds % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= 1000000000L;
     }
+    return pthread_cond_timedwait(&cond, &mutex, &deadline) == 0;
+}
 
-    pthread_mutex_destroy(&m_queue_mutex);
-    pthread_mutex_destroy(&m_user_mutex);
-    pthread_mutex_destroy(&m_sem_mutex);
-    pthread_cond_destroy(&m_all_idle_cond);
-    pthread_cond_destroy(&m_sem_cond);
+void ThreadHive::signal_condition(Condition& cond) {
+    pthread_cond_signal(&cond);
+}
 
+void ThreadHive::broadcast_condition(Condition& cond) {
+    pthread_cond_broadcast(&cond);
+}
+
+void ThreadHive::yield_thread() {
+    sched_yield();
+}
+
+void ThreadHive::pause_cpu() {
+#if defined(__i386__) || defined(__x86_64__)
+    _mm_pause();
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
 #endif
 }
 
-#ifdef _WIN32
+void ThreadHive::join_thread(Thread& thread) {
+    pthread_join(thread, NULL);
+}
 
-DWORD WINAPI ThreadHive::thread_task(LPVOID arg) {
-    ThreadHive* hive = reinterpret_cast<ThreadHive*>(arg);
+void ThreadHive::set_thread_affinity(Thread& thread, int processor) {
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    unsigned int i;
+    unsigned int num_processors = get_num_processors();
 
-    while (true) {
-        EnterCriticalSection(&(hive->m_queue_mutex));
+    CPU_ZERO(&cpu_set);
+    if (processor < 0) {
+        for (i = 0; i < num_processors; ++i)
+            CPU_SET(i, &cpu_set);
+    }
+    else
+        CPU_SET(processor % num_processors, &cpu_set);
+    pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpu_set);
+#endif
+}
+
+#endif
 
-        if (hive->m_tasks.empty()) {
-            LeaveCriticalSection(&(hive->m_queue_mutex));
+ThreadHive::Counters* ThreadHive::allocate_counters(unsigned int count) {
+    size_t size = sizeof(Counters) * count;
+    void* data;
+    Counters* counters;
+    unsigned int i;
 
-            // Sleep thread while nothing to process
-            EnterCriticalSection(&(hive->m_sem_mutex));
-            while (hive->m_sem_val == 0)
-                SleepConditionVariableCS(&(hive->m_sem_cond), &(hive->m_sem_mutex), INFINITE);
-            if (hive->m_sem_val == 2) {
-                LeaveCriticalSection(&(hive->m_sem_mutex));
-                break;
-            }
-            else {
-                hive->m_sem_val = 0;
-                LeaveCriticalSection(&(hive->m_sem_mutex));
-            }
-        }
-        else {
-            // Get task
-            Task task;
-            hive->m_tasks.dequeue(task);
+    static_assert(sizeof(Counters) % CACHE_LINE_SIZE == 0, "Counters must fill whole cache lines");
+#ifdef _MSC_VER
+    data = _aligned_malloc(size, CACHE_LINE_SIZE);
+#else
+    if (posix_memalign(&data, CACHE_LINE_SIZE, size) != 0)
+        data = nullptr;
+#endif
+    counters = reinterpret_cast<Counters*>(data);
+    for (i = 0; i < count; ++i) {
+        new (counters + i) Counters;
+        reset_counters(counters[i]);
+    }
+    return counters;
+}
 
-            // Increment working counter
-            ++(hive->m_num_working);
+void ThreadHive::free_counters(Counters* counters) {
+    // Counters are trivially destructible
+#ifdef _MSC_VER
+    _aligned_free(counters);
+#else
+    free(counters);
+#endif
+}
 
-            LeaveCriticalSection(&(hive->m_queue_mutex));
+void ThreadHive::reset_counters(Counters& counters) {
+    counters.m_num_tasks.store(0, std::memory_order_relaxed);
+    counters.m_num_steals.store(0, std::memory_order_relaxed);
+    counters.m_busy_time.store(0, std::memory_order_relaxed);
+    counters.m_idle_time.store(0, std::memory_order_relaxed);
+    counters.m_queue_time.store(0, std::memory_order_relaxed);
+    counters.m_max_task_time.store(0, std::memory_order_relaxed);
+}
 
-            // Process task
-            task.m_task_callback(task.m_user_data, hive);
+void ThreadHive::counters_to_stats(const Counters& counters, Stats& stats_out) {
+    stats_out.m_num_tasks = counters.m_num_tasks.load(std::memory_order_relaxed);
+    stats_out.m_num_steals = counters.m_num_steals.load(std::memory_order_relaxed);
+    stats_out.m_busy_time = counters.m_busy_time.load(std::memory_order_relaxed) * 1.0e-9;
+    stats_out.m_idle_time = counters.m_idle_time.load(std::memory_order_relaxed) * 1.0e-9;
+    stats_out.m_queue_time = counters.m_queue_time.load(std::memory_order_relaxed) * 1.0e-9;
+    stats_out.m_max_task_time = counters.m_max_task_time.load(std::memory_order_relaxed) * 1.0e-9;
+}
 
-            // Decrement working counter
-            EnterCriticalSection(&(hive->m_queue_mutex));
+void ThreadHive::for_each_hive(void (*callback)(ThreadHive* hive, void* user_data), void* user_data) {
+    ThreadHive* hive;
 
-            --(hive->m_num_working);
+    while (s_hives_guard.test_and_set(std::memory_order_acquire))
+        yield_thread();
+    for (hive = s_first_hive; hive != nullptr; hive = hive->m_next_hive)
+        callback(hive, user_data);
+    s_hives_guard.clear(std::memory_order_release);
+}
 
-            // Signal completion
-            if (hive->m_num_working == 0 && hive->m_tasks.empty())
-                WakeConditionVariable(&(hive->m_all_idle_cond));
+void ThreadHive::start_bee(Bee* bee) {
+    // Expects m_bees_mutex to be locked
+    if (bee->m_state.load() == BEE_EXITED)
+        join_thread(bee->m_thread);
+    bee->m_state.store(BEE_RUNNING);
+    m_num_live.fetch_add(1);
+#ifdef _WIN32
+    bee->m_thread = CreateThread(NULL, 0, thread_task, bee, 0, NULL);
+#else
+    pthread_create(&bee->m_thread, NULL, &thread_task, bee);
+#endif
+    if (m_affinity_enabled.load())
+        set_thread_affinity(bee->m_thread, bee->m_index);
+}
 
-            LeaveCriticalSection(&(hive->m_queue_mutex));
+void ThreadHive::grow() {
+    unsigned int i;
+
+    lock_mutex(m_bees_mutex);
+    if (!m_terminate.load() && m_num_live.load() < m_num_bees.load()) {
+        for (i = 0; i < m_max_bees; ++i) {
+            if (m_bees[i].m_state.load() != BEE_RUNNING) {
+                start_bee(m_bees + i);
+                break;
+            }
         }
     }
+    unlock_mutex(m_bees_mutex);
+}
 
-    return 0;
+bool ThreadHive::try_retire(Bee* bee, bool surplus) {
+    bool retired = false;
+
+    // A bee with queued tasks of its own must stay
+    if (bee->m_num_tasks.load() != 0) return false;
+
+    lock_mutex(m_bees_mutex);
+    // Every surplus bee is woken at once when the hive shrinks, so the surplus is checked again here, where only one
+    // of them retires at a time
+    if (surplus && m_num_live.load() <= m_num_bees.load()) {
+        unlock_mutex(m_bees_mutex);
+        return false;
+    }
+    // Enqueuers count the task before checking the number of live bees, while a retiring bee drops the count before
+    // checking for tasks, so either the enqueuer starts a bee or the retiring bee sees the task
+    m_num_live.fetch_sub(1);
+    if (m_num_queued.load() == 0 || m_terminate.load()) {
+        // The slot may be reused right away; the new bee joins the old thread first
+        bee->m_state.store(BEE_EXITED);
+        retired = true;
+    }
+    else
+        m_num_live.fetch_add(1);
+    unlock_mutex(m_bees_mutex);
+
+    return retired;
 }
 
-#else
+void ThreadHive::run_bee(Bee* bee) {
+    Task task;
+    bool timed_out;
 
-void* ThreadHive::thread_task(void* arg) {
-    ThreadHive* hive = reinterpret_cast<ThreadHive*>(arg);
+    s_current_bee.set(bee);
 
     while (true) {
-        pthread_mutex_lock(&(hive->m_queue_mutex));
+        if (pop_task(bee, task))
+            run_task(task);
+        else if (m_terminate.load())
+            break;
+        else if (m_num_live.load() > m_num_bees.load() && try_retire(bee, true))
+            break;
+        else {
+            m_num_idle.fetch_add(1);
+            timed_out = idle_wait(nullptr);
+            m_num_idle.fetch_sub(1);
+            if (timed_out && try_retire(bee, false))
+                break;
+        }
+    }
 
-        if (hive->m_tasks.empty()) {
-            pthread_mutex_unlock(&(hive->m_queue_mutex));
+    s_current_bee.set(nullptr);
+}
 
-            // Sleep thread while nothing to process
-            pthread_mutex_lock(&(hive->m_sem_mutex));
-            while (hive->m_sem_val == 0)
-                pthread_cond_wait(&(hive->m_sem_cond), &(hive->m_sem_mutex));
-            if (hive->m_sem_val == 2) {
-                pthread_mutex_unlock(&(hive->m_sem_mutex));
-                break;
+void ThreadHive::push_task(const Task& task) {
+    if (task.m_priority == PRIORITY_BACKGROUND) {
+        lock_mutex(m_background_mutex);
+        m_background_tasks.enqueue(task);
+        m_num_background.fetch_add(1, std::memory_order_relaxed);
+        m_num_queued.fetch_add(1);
+        unlock_mutex(m_background_mutex);
+    }
+    else if (m_mode == MODE_WORK_STEALING) {
+        unsigned int i;
+        Bee* bee = get_current_bee();
+        // Tasks from outside the hive go round-robin to running bees; a task left on an exited bee's deque is stolen
+        if (bee == nullptr || bee->m_hive != this) {
+            for (i = 0; i < m_max_bees; ++i) {
+                bee = m_bees + m_next_bee.fetch_add(1, std::memory_order_relaxed) % m_max_bees;
+                if (bee->m_state.load(std::memory_order_relaxed) == BEE_RUNNING) break;
             }
-            else {
-                hive->m_sem_val = 0;
-                pthread_mutex_unlock(&(hive->m_sem_mutex));
+        }
+
+        lock_mutex(bee->m_tasks_mutex);
+        bee->m_tasks.enqueue(task);
+        bee->m_num_tasks.store(bee->m_tasks.size(), std::memory_order_relaxed);
+        m_num_queued.fetch_add(1);
+        unlock_mutex(bee->m_tasks_mutex);
+    }
+    else {
+        lock_mutex(m_queue_mutex);
+        m_tasks.enqueue(task);
+        m_num_queued.fetch_add(1);
+        unlock_mutex(m_queue_mutex);
+    }
+}
+
+bool ThreadHive::pop_task(Bee* bee, Task& task_out) {
+    bool found = false;
+
+    if (m_mode == MODE_WORK_STEALING) {
+        // Newest task first, as it is the most likely to be in cache
+        if (bee != nullptr && bee->m_num_tasks.load(std::memory_order_relaxed) != 0) {
+            lock_mutex(bee->m_tasks_mutex);
+            if (!bee->m_tasks.empty()) {
+                bee->m_tasks.dequeue_back(task_out);
+                bee->m_num_tasks.store(bee->m_tasks.size(), std::memory_order_relaxed);
+                m_num_queued.fetch_sub(1);
+                found = true;
             }
+            unlock_mutex(bee->m_tasks_mutex);
         }
-        else {
-            // Get task
-            Task task;
-            hive->m_tasks.dequeue(task);
+        if (!found && m_num_queued.load(std::memory_order_relaxed) != 0)
+            found = steal_task(bee, task_out);
+    }
+    else if (m_num_queued.load(std::memory_order_relaxed) != 0) {
+        lock_mutex(m_queue_mutex);
+        if (!m_tasks.empty()) {
+            m_tasks.dequeue(task_out);
+            m_num_queued.fetch_sub(1);
+            found = true;
+        }
+        unlock_mutex(m_queue_mutex);
+    }
+
+    // Background tasks only once no interactive task is left
+    if (!found && m_num_background.load(std::memory_order_relaxed) != 0) {
+        lock_mutex(m_background_mutex);
+        if (!m_background_tasks.empty()) {
+            m_background_tasks.dequeue(task_out);
+            m_num_background.fetch_sub(1, std::memory_order_relaxed);
+            m_num_queued.fetch_sub(1);
+            found = true;
+        }
+        unlock_mutex(m_background_mutex);
+    }
+
+    return found;
+}
+
+bool ThreadHive::steal_task(Bee* thief, Task& task_out) {
+    unsigned int i;
+    unsigned int first = thief != nullptr ? thief->m_index + 1 : 0;
+    Bee* victim;
+    bool found = false;
+
+    for (i = 0; i < m_max_bees && !found; ++i) {
+        victim = m_bees + (first + i) % m_max_bees;
+        if (victim == thief || victim->m_num_tasks.load(std::memory_order_relaxed) == 0) continue;
+
+        // Oldest task first, as it is likely to be the largest and the least likely to be in the victim's cache
+        lock_mutex(victim->m_tasks_mutex);
+        if (!victim->m_tasks.empty()) {
+            victim->m_tasks.dequeue(task_out);
+            victim->m_num_tasks.store(victim->m_tasks.size(), std::memory_order_relaxed);
+            m_num_queued.fetch_sub(1);
+            found = true;
+        }
+        unlock_mutex(victim->m_tasks_mutex);
+    }
 
-            // Increment working counter
-            ++(hive->m_num_working);
+    if (found)
+        get_counters().m_num_steals.fetch_add(1, std::memory_order_relaxed);
 
-            pthread_mutex_unlock(&(hive->m_queue_mutex));
+    return found;
+}
 
-            // Process task
-            task.m_task_callback(task.m_user_data, hive);
+void ThreadHive::complete_task(const Task& task) {
+    // Wake the threads waiting for the group; they sleep along with idle bees
+    if (task.m_group != nullptr && task.m_group->m_num_pending.fetch_sub(1) == 1 && m_num_sleeping.load() != 0) {
+        lock_mutex(m_sem_mutex);
+        broadcast_condition(m_sem_cond);
+        unlock_mutex(m_sem_mutex);
+    }
 
-            // Decrement working counter
-            pthread_mutex_lock(&(hive->m_queue_mutex));
+    // Signal completion
+    if (m_num_pending.fetch_sub(1) == 1) {
+        lock_mutex(m_queue_mutex);
+        broadcast_condition(m_all_idle_cond);
+        unlock_mutex(m_queue_mutex);
+    }
+}
 
-            --(hive->m_num_working);
+void ThreadHive::wake_bee() {
+    // Spinning bees notice the task on their own
+    if (m_num_sleeping.load() == 0) return;
 
-            // Signal completion
-            if (hive->m_num_working == 0 && hive->m_tasks.empty())
-                pthread_cond_signal(&(hive->m_all_idle_cond));
+    lock_mutex(m_sem_mutex);
+    if (m_num_wakeups < m_num_sleeping.load()) {
+        ++m_num_wakeups;
+        signal_condition(m_sem_cond);
+    }
+    unlock_mutex(m_sem_mutex);
+}
 
-            pthread_mutex_unlock(&(hive->m_queue_mutex));
+ThreadHive::Counters& ThreadHive::get_counters() {
+    Bee* bee = get_current_bee();
+    return m_counters[(bee != nullptr && bee->m_hive == this) ? bee->m_index : m_max_bees];
+}
+
+bool ThreadHive::idle_wait(const TaskGroup* group) {
+    long long start_time = get_time();
+    unsigned int timeout;
+    bool timed_out = false;
+    unsigned int i;
+
+    for (i = 0; i < m_spin_count && !is_idle_over(group); ++i)
+        pause_cpu();
+    for (i = 0; i < NUM_IDLE_YIELDS && !is_idle_over(group); ++i)
+        yield_thread();
+    if (is_idle_over(group)) {
+        get_counters().m_idle_time.fetch_add(get_time() - start_time, std::memory_order_relaxed);
+        return false;
+    }
+
+    lock_mutex(m_sem_mutex);
+    m_num_sleeping.fetch_add(1);
+    // Enqueuers skip the wake-up when nobody sleeps, so the queues must be rechecked after registering
+    while (m_num_wakeups == 0 && !is_idle_over(group)) {
+        timeout = group == nullptr ? m_idle_timeout.load(std::memory_order_relaxed) : 0;
+        if (timeout == 0)
+            wait_condition(m_sem_cond, m_sem_mutex);
+        else if (!wait_condition_timed(m_sem_cond, m_sem_mutex, timeout)) {
+            timed_out = true;
+            break;
         }
     }
+    m_num_sleeping.fetch_sub(1);
+    if (m_num_wakeups != 0) {
+        // Take the wake-up if about to look for tasks; otherwise pass it on to another sleeper
+        if (group == nullptr || group->m_num_pending.load() != 0)
+            --m_num_wakeups;
+        else
+            signal_condition(m_sem_cond);
+    }
+    unlock_mutex(m_sem_mutex);
 
-    return 0;
+    get_counters().m_idle_time.fetch_add(get_time() - start_time, std::memory_order_relaxed);
+    return timed_out;
 }
 
-#endif
+bool ThreadHive::run_pending_task() {
+    Task task;
+    Bee* bee = get_current_bee();
 
-unsigned int ThreadHive::get_num_tasks() {
-    unsigned int num_tasks;
-#ifdef _WIN32
-    EnterCriticalSection(&m_queue_mutex);
-    num_tasks = m_tasks.size();
-    LeaveCriticalSection(&m_queue_mutex);
-#else
-    pthread_mutex_lock(&m_queue_mutex);
-    num_tasks = m_tasks.size();
-    pthread_mutex_unlock(&m_queue_mutex);
-#endif
-    return num_tasks;
+    if (bee != nullptr && bee->m_hive != this)
+        bee = nullptr;
+
+    if (pop_task(bee, task)) {
+        run_task(task);
+        return true;
+    }
+    else
+        return false;
+}
+
+void ThreadHive::run_task(const Task& task) {
+    // A thread may run tasks from within a task while waiting, hence the restore
+    Priority orig_priority = get_current_priority();
+    Counters& counters = get_counters();
+    long long start_time = get_time();
+    long long task_time, max_task_time;
+
+    set_current_priority(task.m_priority);
+
+    // Tasks of a cancelled group are dropped, but still count as processed
+    if (task.m_group == nullptr || !task.m_group->is_cancelled())
+        task.m_task_callback(task.m_user_data, this);
+
+    set_current_priority(orig_priority);
+
+    // A nested task run while waiting counts towards the busy time of the outer one as well
+    task_time = get_time() - start_time;
+    counters.m_num_tasks.fetch_add(1, std::memory_order_relaxed);
+    counters.m_busy_time.fetch_add(task_time, std::memory_order_relaxed);
+    counters.m_queue_time.fetch_add(start_time - task.m_enqueue_time, std::memory_order_relaxed);
+    max_task_time = counters.m_max_task_time.load(std::memory_order_relaxed);
+    while (task_time > max_task_time && !counters.m_max_task_time.compare_exchange_weak(max_task_time, task_time, std::memory_order_relaxed)) {}
+
+    complete_task(task);
 }
 
-void ThreadHive::enqueue(TaskCallback task_callback, void* user_data) {
+void ThreadHive::submit(TaskGroup* group, TaskCallback task_callback, void* user_data, Priority priority) {
     Task task;
     task.m_task_callback = task_callback;
     task.m_user_data = user_data;
+    task.m_group = group;
+    task.m_priority = priority != PRIORITY_CURRENT ? priority : get_current_priority();
+    task.m_enqueue_time = get_time();
+
+    if (group != nullptr)
+        group->m_num_pending.fetch_add(1);
+    m_num_pending.fetch_add(1);
+    push_task(task);
+    wake_bee();
+
+    // Start a bee if some have exited and none is around to pick up the task
+    if (m_num_live.load() < m_num_bees.load() && m_num_idle.load() == 0)
+        grow();
+}
 
-#ifdef _WIN32
-    EnterCriticalSection(&m_queue_mutex);
-    m_tasks.enqueue(task);
-    LeaveCriticalSection(&m_queue_mutex);
-
-    EnterCriticalSection(&m_sem_mutex);
-    m_sem_val = 1;
-    WakeConditionVariable(&m_sem_cond);
-    LeaveCriticalSection(&m_sem_mutex);
-#else
-    pthread_mutex_lock(&m_queue_mutex);
-    m_tasks.enqueue(task);
-    pthread_mutex_unlock(&m_queue_mutex);
-
-    pthread_mutex_lock(&m_sem_mutex);
-    m_sem_val = 1;
-    pthread_cond_signal(&m_sem_cond);
-    pthread_mutex_unlock(&m_sem_mutex);
-#endif
+void ThreadHive::enqueue(TaskCallback task_callback, void* user_data, Priority priority) {
+    submit(nullptr, task_callback, user_data, priority);
+}
+
+void ThreadHive::enqueue(TaskGroup& group, TaskCallback task_callback, void* user_data, Priority priority) {
+    submit(&group, task_callback, user_data, priority);
+}
+
+void ThreadHive::get_stats(unsigned int index, Stats& stats_out) const {
+    counters_to_stats(m_counters[index < m_max_bees ? index : m_max_bees], stats_out);
+}
+
+void ThreadHive::get_total_stats(Stats& stats_out) const {
+    Stats stats;
+    unsigned int i;
+
+    get_stats(m_max_bees, stats_out);
+    for (i = 0; i < m_max_bees; ++i) {
+        get_stats(i, stats);
+        stats_out.m_num_tasks += stats.m_num_tasks;
+        stats_out.m_num_steals += stats.m_num_steals;
+        stats_out.m_busy_time += stats.m_busy_time;
+        stats_out.m_idle_time += stats.m_idle_time;
+        stats_out.m_queue_time += stats.m_queue_time;
+        if (stats.m_max_task_time > stats_out.m_max_task_time)
+            stats_out.m_max_task_time = stats.m_max_task_time;
+    }
+}
+
+void ThreadHive::reset_stats() {
+    for (unsigned int i = 0; i <= m_max_bees; ++i)
+        reset_counters(m_counters[i]);
+}
+
+void ThreadHive::set_num_bees(unsigned int num_bees) {
+    unsigned int i;
+
+    if (num_bees == 0) num_bees = 1;
+    if (num_bees > m_max_bees) num_bees = m_max_bees;
+
+    lock_mutex(m_bees_mutex);
+    m_num_bees.store(num_bees);
+    for (i = 0; i < m_max_bees && m_num_live.load() < num_bees && !m_terminate.load(); ++i) {
+        if (m_bees[i].m_state.load() != BEE_RUNNING)
+            start_bee(m_bees + i);
+    }
+    unlock_mutex(m_bees_mutex);
+
+    // Wake surplus bees, so that they exit
+    lock_mutex(m_sem_mutex);
+    broadcast_condition(m_sem_cond);
+    unlock_mutex(m_sem_mutex);
+}
+
+void ThreadHive::set_idle_timeout(unsigned int milliseconds) {
+    m_idle_timeout.store(milliseconds);
+
+    // Sleeping bees pick up the timeout once woken
+    lock_mutex(m_sem_mutex);
+    broadcast_condition(m_sem_cond);
+    unlock_mutex(m_sem_mutex);
+}
+
+void ThreadHive::set_affinity_enabled(bool state) {
+    unsigned int i;
+
+    lock_mutex(m_bees_mutex);
+    if (state != m_affinity_enabled.load()) {
+        m_affinity_enabled.store(state);
+        for (i = 0; i < m_max_bees; ++i) {
+            if (m_bees[i].m_state.load() == BEE_RUNNING)
+                set_thread_affinity(m_bees[i].m_thread, state ? static_cast<int>(i) : -1);
+        }
+    }
+    unlock_mutex(m_bees_mutex);
+}
+
+bool ThreadHive::get_affinity_enabled() const {
+    return m_affinity_enabled.load();
 }
 
 void ThreadHive::wait_until_finished() {
-#ifdef _WIN32
-    EnterCriticalSection(&m_queue_mutex);
-    while (!m_tasks.empty() || m_num_working != 0)
-        SleepConditionVariableCS(&m_all_idle_cond, &m_queue_mutex, INFINITE);
-    LeaveCriticalSection(&m_queue_mutex);
-#else
-    pthread_mutex_lock(&m_queue_mutex);
-    while (!m_tasks.empty() || m_num_working != 0)
-        pthread_cond_wait(&m_all_idle_cond, &m_queue_mutex);
-    pthread_mutex_unlock(&m_queue_mutex);
-#endif
+    lock_mutex(m_queue_mutex);
+    while (m_num_pending.load() != 0)
+        wait_condition(m_all_idle_cond, m_queue_mutex);
+    unlock_mutex(m_queue_mutex);
+}
+
+void ThreadHive::wait(TaskGroup& group) {
+    while (group.m_num_pending.load() != 0) {
+        // Nothing to help with, so idle until a task is queued or the group completes
+        if (!run_pending_task())
+            idle_wait(&group);
+    }
 }
 
 void ThreadHive::enter_critical_section() {
-#ifdef _WIN32
-    EnterCriticalSection(&m_user_mutex);
-#else
-    pthread_mutex_lock(&m_user_mutex);
-#endif
+    lock_mutex(m_user_mutex);
 }
 
 void ThreadHive::leave_critical_section() {
-#ifdef _WIN32
-    LeaveCriticalSection(&m_user_mutex);
-#else
-    pthread_mutex_unlock(&m_user_mutex);
-#endif
+    unlock_mutex(m_user_mutex);
 }
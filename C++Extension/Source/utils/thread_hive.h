@@ -10,51 +10,216 @@
 #define THREAD_HIVE_H
 
 #include "fast_queue.h"
+#include "thread_local_slot.h"
+
+#include <atomic>
+#include <chrono>
 
 #ifdef _WIN32
     #include "windows.h"
 #else
     #include <pthread.h>
+    #include <sched.h>
     #include <unistd.h>
+    #if defined(__i386__) || defined(__x86_64__)
+        #include <emmintrin.h>
+    #endif
 #endif
 
 class ThreadHive {
 public:
+    // Constants
+    static const unsigned int DEFAULT_SPIN_COUNT;
+
     // Type-defines
     typedef void(*TaskCallback)(void* user_data, ThreadHive* hive);
 
+    // Enumerators
+    enum Mode {
+        // All tasks pass through one shared queue.
+        MODE_SHARED_QUEUE,
+        // Every bee owns a deque. Tasks enqueued from within a task stay on the deque of the bee running it and
+        // are processed in LIFO order; idle bees steal the oldest tasks from the other bees.
+        MODE_WORK_STEALING
+    };
+
+    enum Priority {
+        // Latency-critical work; dequeued before any background task.
+        PRIORITY_INTERACTIVE,
+        // Work that waits while interactive tasks are queued. Background tasks share one FIFO queue in both modes.
+        PRIORITY_BACKGROUND,
+        // The priority of the task run by the calling thread, or interactive if called outside of a task.
+        PRIORITY_CURRENT
+    };
+
+    // Structures
+
+    // Counters of a bee, or of the threads outside the hive that helped while waiting. Times are in seconds.
+    struct Stats {
+        unsigned long long m_num_tasks; // tasks processed
+        unsigned long long m_num_steals; // tasks taken from the deques of other bees
+        double m_busy_time; // time spent processing tasks
+        double m_idle_time; // time spent spinning, yielding, and sleeping
+        double m_queue_time; // total time tasks spent queued, from enqueue to start
+        double m_max_task_time; // longest time spent processing a task
+    };
+
+    // Classes
+
+    // Counts the tasks enqueued through it, so that a caller can wait for its own tasks rather than for the whole hive.
+    // Cancelling a group drops its queued tasks; running tasks are expected to poll is_cancelled() and return early.
+    class TaskGroup {
+    private:
+        // Disable copy constructor and assignment operator
+        TaskGroup(const TaskGroup& other);
+        TaskGroup& operator=(const TaskGroup& other);
+
+        // Variables
+        std::atomic<unsigned int> m_num_pending;
+        std::atomic<bool> m_cancelled;
+
+        friend class ThreadHive;
+
+    public:
+        TaskGroup();
+
+        unsigned int get_num_pending() const;
+
+        // A cancelled group stays cancelled; tasks enqueued to it afterwards are dropped as well
+        void cancel();
+        bool is_cancelled() const;
+    };
+
 private:
     // Disable copy constructor and assignment operator
     ThreadHive(const ThreadHive& other);
     ThreadHive& operator=(const ThreadHive& other);
 
+    // Constants
+    static const unsigned int NUM_IDLE_YIELDS;
+    static const size_t CACHE_LINE_SIZE = 64; // in bytes
+
+    // Enumerators
+    enum BeeState {
+        BEE_STOPPED, // no thread
+        BEE_RUNNING,
+        BEE_EXITED // thread is about to exit and is yet to be joined
+    };
+
+    // Type-defines
+#ifdef _WIN32
+    typedef HANDLE Thread;
+    typedef CRITICAL_SECTION Mutex;
+    typedef CONDITION_VARIABLE Condition;
+#else
+    typedef pthread_t Thread;
+    typedef pthread_mutex_t Mutex;
+    typedef pthread_cond_t Condition;
+#endif
+
     // Structures
     struct Task {
         TaskCallback m_task_callback;
         void* m_user_data;
+        TaskGroup* m_group;
+        Priority m_priority;
+        long long m_enqueue_time;
+    };
+
+    // Written by the owning bee with relaxed atomics, so that snapshots and resets need no locking. Times are in
+    // nanoseconds. Padded to a whole cache line; the counters of all bees are allocated together, aligned to one.
+    struct Counters {
+        std::atomic<unsigned long long> m_num_tasks;
+        std::atomic<unsigned long long> m_num_steals;
+        std::atomic<long long> m_busy_time;
+        std::atomic<long long> m_idle_time;
+        std::atomic<long long> m_queue_time;
+        std::atomic<long long> m_max_task_time;
+        char m_padding[CACHE_LINE_SIZE - sizeof(long long) * 6];
+    };
+
+    struct Bee {
+        ThreadHive* m_hive;
+        unsigned int m_index;
+        Thread m_thread;
+        Mutex m_tasks_mutex;
+        FastQueue<Task> m_tasks;
+        std::atomic<unsigned int> m_num_tasks; // allows thieves to skip empty deques without locking
+        std::atomic<int> m_state; // changed under m_bees_mutex
+    };
+
+    template <class Function>
+    struct ParallelFor {
+        struct Range {
+            ParallelFor* m_job;
+            size_t m_begin;
+            size_t m_end;
+        };
+
+        const Function* m_function;
+        size_t m_grain;
+        Range* m_ranges;
+        std::atomic<size_t> m_num_ranges;
+        TaskGroup m_group;
+    };
+
+    template <class Value>
+    struct ReduceSlot {
+        Value m_value;
+        char m_padding[64]; // keeps accumulators of different bees on separate cache lines
+    };
+
+    template <class Value, class Body, class Join>
+    struct ReduceChunk {
+        ThreadHive* m_hive;
+        ReduceSlot<Value>* m_slots;
+        const Value* m_identity;
+        const Body* m_body;
+        const Join* m_join;
+        std::atomic_flag* m_guard;
+
+        void operator()(size_t begin, size_t end) const;
     };
 
     // Variables
     FastQueue<Task> m_tasks;
+    FastQueue<Task> m_background_tasks;
+    Bee* m_bees;
+    Counters* m_counters; // one per bee slot, then one shared by threads outside the hive
+    ThreadHive* m_next_hive;
 
-#ifdef _WIN32
-    HANDLE* m_bees;
-    CRITICAL_SECTION m_queue_mutex;
-    CRITICAL_SECTION m_user_mutex;
-    CRITICAL_SECTION m_sem_mutex;
-    CONDITION_VARIABLE m_all_idle_cond;
-    CONDITION_VARIABLE m_sem_cond;
-#else
-    pthread_t* m_bees;
-    pthread_mutex_t m_queue_mutex;
-    pthread_mutex_t m_user_mutex;
-    pthread_mutex_t m_sem_mutex;
-    pthread_cond_t m_all_idle_cond;
-    pthread_cond_t m_sem_cond;
-#endif
-    volatile unsigned int m_sem_val;
-    unsigned int m_num_bees;
-    unsigned int m_num_working;
+    Mutex m_bees_mutex;
+    Mutex m_queue_mutex;
+    Mutex m_background_mutex;
+    Mutex m_user_mutex;
+    Mutex m_sem_mutex;
+    Condition m_all_idle_cond;
+    Condition m_sem_cond;
+
+    unsigned int m_num_wakeups; // guarded by m_sem_mutex; each enqueue adds one, up to the number of sleepers
+    unsigned int m_max_bees; // number of bee slots
+    unsigned int m_spin_count;
+    Mode m_mode;
+    std::atomic<bool> m_terminate;
+    std::atomic<bool> m_affinity_enabled; // written under m_bees_mutex, along with the affinity of the bees
+    std::atomic<unsigned int> m_num_queued; // tasks awaiting a bee, including background ones
+    std::atomic<unsigned int> m_num_background; // background tasks awaiting a bee
+    std::atomic<unsigned int> m_num_pending; // tasks queued or being processed
+    std::atomic<unsigned int> m_num_sleeping;
+    std::atomic<unsigned int> m_next_bee;
+    std::atomic<unsigned int> m_num_bees; // bees to keep running while there is work
+    std::atomic<unsigned int> m_num_live; // bees running and not retiring
+    std::atomic<unsigned int> m_num_idle; // live bees looking for work
+    std::atomic<unsigned int> m_idle_timeout;
+
+    static ThreadLocalSlot s_current_bee; // the Bee run by the thread
+    static ThreadLocalSlot s_current_priority; // the Priority of the task run by the thread; unset is interactive
+    static ThreadHive* s_first_hive;
+    static std::atomic_flag s_hives_guard;
+
+    // BlockingQueue waits on the same mutex and condition wrappers
+    template <class T>
+    friend class BlockingQueue;
 
     // Helper Functions
 #ifdef _WIN32
@@ -63,25 +228,298 @@ private:
     static void* thread_task(void* arg);
 #endif
 
+    static void init_mutex(Mutex& mutex);
+    static void destroy_mutex(Mutex& mutex);
+    static void lock_mutex(Mutex& mutex);
+    static void unlock_mutex(Mutex& mutex);
+    static void init_condition(Condition& cond);
+    static void destroy_condition(Condition& cond);
+    static void wait_condition(Condition& cond, Mutex& mutex);
+    static bool wait_condition_timed(Condition& cond, Mutex& mutex, unsigned int milliseconds); // false on timeout
+    static void signal_condition(Condition& cond);
+    static void broadcast_condition(Condition& cond);
+    static void yield_thread();
+    static void pause_cpu();
+    static void join_thread(Thread& thread);
+    static void set_thread_affinity(Thread& thread, int processor); // a processor of -1 allows all processors
+    static long long get_time();
+    static Counters* allocate_counters(unsigned int count);
+    static void free_counters(Counters* counters);
+    static void reset_counters(Counters& counters);
+    static void counters_to_stats(const Counters& counters, Stats& stats_out);
+    static Bee* get_current_bee();
+    static Priority get_current_priority();
+    static void set_current_priority(Priority priority);
+
+    void start_bee(Bee* bee);
+    void grow();
+    bool try_retire(Bee* bee, bool surplus); // a surplus bee only retires while the hive has more live bees than wanted
+    void run_bee(Bee* bee);
+    void push_task(const Task& task);
+    bool pop_task(Bee* bee, Task& task_out);
+    bool steal_task(Bee* thief, Task& task_out);
+    void submit(TaskGroup* group, TaskCallback task_callback, void* user_data, Priority priority);
+    void run_task(const Task& task);
+    void complete_task(const Task& task);
+    void wake_bee();
+    Counters& get_counters();
+    bool run_pending_task();
+    bool is_idle_over(const TaskGroup* group) const;
+    bool idle_wait(const TaskGroup* group); // true if a bee timed out while asleep
+
+    template <class Function>
+    static void parallel_for_task(void* user_data, ThreadHive* hive);
+
+    template <class Function>
+    void split_and_run(ParallelFor<Function>* job, size_t begin, size_t end);
+
 public:
     static unsigned int get_num_processors();
 
-    ThreadHive(unsigned int num_bees);
+    // Calls callback for every existing hive. Hives must not be created or destroyed from within the callback.
+    static void for_each_hive(void (*callback)(ThreadHive* hive, void* user_data), void* user_data);
+
+    // A bee that runs out of tasks polls the queues spin_count times with a pause instruction, then NUM_IDLE_YIELDS
+    // times yielding its time slice, and only then goes to sleep. Spinning avoids the cost of waking a sleeping bee
+    // for bursts of tasks, at the expense of burning CPU time for a few microseconds after every burst. A spin count
+    // of zero sends idle bees to sleep right after yielding.
+    // The hive has room for the greater of num_bees and get_num_processors() bees, of which num_bees are started.
+    ThreadHive(unsigned int num_bees, Mode mode = MODE_SHARED_QUEUE, unsigned int spin_count = DEFAULT_SPIN_COUNT);
     virtual ~ThreadHive();
 
+    unsigned int get_max_bees() const;
     unsigned int get_num_bees() const;
-    unsigned int get_num_tasks();
-    void enqueue(TaskCallback task_callback, void* user_data);
+    unsigned int get_num_live_bees() const; // Returns the number of bee threads currently running
+
+    // Changes the number of bees, clamped to [1, get_max_bees()]. Missing bees are started right away; surplus ones
+    // exit once they run out of tasks.
+    void set_num_bees(unsigned int num_bees);
+
+    // Makes bees that sleep for longer than the given time exit; they are started again, up to get_num_bees(), as
+    // tasks are enqueued while no bee is idle. Zero, the default, keeps bees running for the lifetime of the hive.
+    void set_idle_timeout(unsigned int milliseconds);
+    unsigned int get_idle_timeout() const;
+
+    // Pins every bee to its own processor, by bee index, or lets it run on any. Pinning keeps cache-heavy tasks on
+    // a warm core, but hurts if other threads of the process compete for the same processors. Has no effect on
+    // Mac OS X, which does not support thread affinity.
+    void set_affinity_enabled(bool state);
+    bool get_affinity_enabled() const;
+
+    unsigned int get_bee_index() const; // Returns get_max_bees() if not called from a bee of this hive
+    Mode get_mode() const;
+    unsigned int get_spin_count() const;
+    unsigned int get_num_tasks() const;
+
+    // Returns the counters of a bee; an index of get_max_bees() returns those of the threads outside the hive
+    void get_stats(unsigned int index, Stats& stats_out) const;
+    // Returns the counters summed over all bees and outside threads; the maximum task time is the largest of them
+    void get_total_stats(Stats& stats_out) const;
+    void reset_stats();
+
+    void enqueue(TaskCallback task_callback, void* user_data, Priority priority = PRIORITY_CURRENT);
+    void enqueue(TaskGroup& group, TaskCallback task_callback, void* user_data, Priority priority = PRIORITY_CURRENT);
+
+    // Waits until all tasks of the hive are processed
     void wait_until_finished();
+
+    // Waits until all tasks of the group are processed. Meanwhile, the calling thread processes queued tasks of any
+    // group, so it is safe to call from within a task.
+    void wait(TaskGroup& group);
+
     void enter_critical_section();
     void leave_critical_section();
+
+    // Calls function(chunk_begin, chunk_end) for chunks covering [begin, end). Ranges are halved recursively until
+    // they are no larger than grain, with the halves being enqueued, so idle bees can pick up the larger ones. A grain
+    // of zero picks one based on the number of bees. Returns after all chunks are processed; the calling thread
+    // processes queued tasks meanwhile, so it is safe to call from within a task. The chunks take the priority of the
+    // calling task.
+    template <class Function>
+    void parallel_for(size_t begin, size_t end, size_t grain, const Function& function);
+
+    // Reduces [begin, end) by calling body(chunk_begin, chunk_end, accumulator) for chunks of the range. Every bee
+    // accumulates into its own copy of identity, so the body needs no locking, provided it adds to the accumulator
+    // directly rather than through a cached copy. The accumulators are merged with join(lhs, rhs) at the end.
+    template <class Value, class Body, class Join>
+    Value parallel_reduce(size_t begin, size_t end, size_t grain, const Value& identity, const Body& body, const Join& join);
 };
 
 
 // Define inline functions
 
+inline ThreadHive::TaskGroup::TaskGroup() :
+    m_num_pending(0),
+    m_cancelled(false)
+{
+}
+
+inline unsigned int ThreadHive::TaskGroup::get_num_pending() const {
+    return m_num_pending.load(std::memory_order_relaxed);
+}
+
+inline void ThreadHive::TaskGroup::cancel() {
+    m_cancelled.store(true, std::memory_order_relaxed);
+}
+
+inline bool ThreadHive::TaskGroup::is_cancelled() const {
+    return m_cancelled.load(std::memory_order_relaxed);
+}
+
+inline unsigned int ThreadHive::get_max_bees() const {
+    return m_max_bees;
+}
+
 inline unsigned int ThreadHive::get_num_bees() const {
-    return m_num_bees;
+    return m_num_bees.load(std::memory_order_relaxed);
+}
+
+inline unsigned int ThreadHive::get_num_live_bees() const {
+    return m_num_live.load(std::memory_order_relaxed);
+}
+
+inline unsigned int ThreadHive::get_idle_timeout() const {
+    return m_idle_timeout.load(std::memory_order_relaxed);
+}
+
+inline ThreadHive::Bee* ThreadHive::get_current_bee() {
+    return static_cast<Bee*>(s_current_bee.get());
+}
+
+inline ThreadHive::Priority ThreadHive::get_current_priority() {
+    return static_cast<Priority>(reinterpret_cast<size_t>(s_current_priority.get()));
+}
+
+inline void ThreadHive::set_current_priority(Priority priority) {
+    s_current_priority.set(reinterpret_cast<void*>(static_cast<size_t>(priority)));
+}
+
+inline unsigned int ThreadHive::get_bee_index() const {
+    Bee* bee = get_current_bee();
+    return (bee != nullptr && bee->m_hive == this) ? bee->m_index : m_max_bees;
+}
+
+inline ThreadHive::Mode ThreadHive::get_mode() const {
+    return m_mode;
+}
+
+inline unsigned int ThreadHive::get_spin_count() const {
+    return m_spin_count;
+}
+
+inline bool ThreadHive::is_idle_over(const TaskGroup* group) const {
+    if (m_num_queued.load() != 0 || m_terminate.load())
+        return true;
+    else if (group != nullptr)
+        return group->m_num_pending.load() == 0;
+    else
+        return m_num_live.load() > m_num_bees.load(); // surplus bees should exit
+}
+
+inline long long ThreadHive::get_time() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline unsigned int ThreadHive::get_num_tasks() const {
+    return m_num_queued.load(std::memory_order_relaxed);
+}
+
+
+// Define template functions
+
+template <class Function>
+void ThreadHive::parallel_for_task(void* user_data, ThreadHive* hive) {
+    typename ParallelFor<Function>::Range* range = reinterpret_cast<typename ParallelFor<Function>::Range*>(user_data);
+    hive->split_and_run(range->m_job, range->m_begin, range->m_end);
+}
+
+template <class Function>
+void ThreadHive::split_and_run(ParallelFor<Function>* job, size_t begin, size_t end) {
+    typename ParallelFor<Function>::Range* range;
+    size_t mid;
+
+    // Hand off the upper halves and keep the lowest chunk
+    while (end - begin > job->m_grain) {
+        mid = begin + ((end - begin) >> 1);
+        range = job->m_ranges + job->m_num_ranges.fetch_add(1, std::memory_order_relaxed);
+        range->m_job = job;
+        range->m_begin = mid;
+        range->m_end = end;
+        enqueue(job->m_group, &parallel_for_task<Function>, range);
+        end = mid;
+    }
+
+    (*job->m_function)(begin, end);
+}
+
+template <class Function>
+void ThreadHive::parallel_for(size_t begin, size_t end, size_t grain, const Function& function) {
+    if (begin >= end) return;
+
+    ParallelFor<Function> job;
+    size_t count = end - begin;
+
+    // Aim for several chunks per bee, so that the load evens out
+    if (grain == 0) {
+        grain = count / (get_num_bees() * 8);
+        if (grain == 0) grain = 1;
+    }
+
+    // Halving a range larger than grain yields ranges no smaller than (grain + 1) / 2
+    job.m_function = &function;
+    job.m_grain = grain;
+    job.m_ranges = new typename ParallelFor<Function>::Range[count / ((grain + 1) >> 1) + 1];
+    job.m_num_ranges.store(0);
+
+    split_and_run(&job, begin, end);
+    wait(job.m_group);
+
+    delete[] job.m_ranges;
+}
+
+template <class Value, class Body, class Join>
+void ThreadHive::ReduceChunk<Value, Body, Join>::operator()(size_t begin, size_t end) const {
+    unsigned int index = m_hive->get_bee_index();
+
+    if (index < m_hive->m_max_bees) {
+        (*m_body)(begin, end, m_slots[index].m_value);
+    }
+    else {
+        // Threads outside the hive share the last slot
+        Value value(*m_identity);
+        (*m_body)(begin, end, value);
+        while (m_guard->test_and_set(std::memory_order_acquire))
+            yield_thread();
+        (*m_join)(m_slots[index].m_value, value);
+        m_guard->clear(std::memory_order_release);
+    }
+}
+
+template <class Value, class Body, class Join>
+Value ThreadHive::parallel_reduce(size_t begin, size_t end, size_t grain, const Value& identity, const Body& body, const Join& join) {
+    ReduceSlot<Value>* slots = new ReduceSlot<Value>[m_max_bees + 1];
+    ReduceChunk<Value, Body, Join> chunk;
+    std::atomic_flag guard = ATOMIC_FLAG_INIT;
+    unsigned int i;
+
+    for (i = 0; i <= m_max_bees; ++i)
+        slots[i].m_value = identity;
+
+    chunk.m_hive = this;
+    chunk.m_slots = slots;
+    chunk.m_identity = &identity;
+    chunk.m_body = &body;
+    chunk.m_join = &join;
+    chunk.m_guard = &guard;
+
+    parallel_for(begin, end, grain, chunk);
+
+    Value result(identity);
+    for (i = 0; i <= m_max_bees; ++i)
+        join(result, slots[i].m_value);
+
+    delete[] slots;
+    return result;
 }
 
 #endif  /* THREAD_HIVE_H */
@@ -0,0 +1,108 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#include "thread_local_slot.h"
+
+#ifdef _WIN32
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Fiber-Local Storage
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+// Resolved at runtime, as Windows XP lacks them
+typedef DWORD (WINAPI *FlsAllocFunc)(ThreadLocalSlot::Cleanup cleanup);
+typedef BOOL (WINAPI *FlsFreeFunc)(DWORD index);
+typedef PVOID (WINAPI *FlsGetValueFunc)(DWORD index);
+typedef BOOL (WINAPI *FlsSetValueFunc)(DWORD index, PVOID value);
+
+struct FiberLocalApi {
+    FlsAllocFunc m_alloc;
+    FlsFreeFunc m_free;
+    FlsGetValueFunc m_get_value;
+    FlsSetValueFunc m_set_value;
+
+    FiberLocalApi() {
+        HMODULE kernel = GetModuleHandleA("kernel32.dll");
+        m_alloc = reinterpret_cast<FlsAllocFunc>(GetProcAddress(kernel, "FlsAlloc"));
+        m_free = reinterpret_cast<FlsFreeFunc>(GetProcAddress(kernel, "FlsFree"));
+        m_get_value = reinterpret_cast<FlsGetValueFunc>(GetProcAddress(kernel, "FlsGetValue"));
+        m_set_value = reinterpret_cast<FlsSetValueFunc>(GetProcAddress(kernel, "FlsSetValue"));
+        if (m_alloc == nullptr || m_free == nullptr || m_get_value == nullptr || m_set_value == nullptr)
+            m_alloc = nullptr;
+    }
+};
+
+// Also needed by slots that are constructed before the static variables of this file
+static const FiberLocalApi& get_fiber_local_api() {
+    static const FiberLocalApi api;
+    return api;
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Constructors
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+ThreadLocalSlot::ThreadLocalSlot(Cleanup cleanup) {
+    const FiberLocalApi& api = get_fiber_local_api();
+    m_fiber_local = api.m_alloc != nullptr;
+    m_index = m_fiber_local ? api.m_alloc(cleanup) : TlsAlloc();
+}
+
+ThreadLocalSlot::~ThreadLocalSlot() {
+    // Freeing a fiber-local slot runs the cleanup for the values of all threads, so none is left to a thread that
+    // exits after the module is unloaded
+    if (m_fiber_local)
+        get_fiber_local_api().m_free(m_index);
+    else
+        TlsFree(m_index);
+}
+
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Functions
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+void* ThreadLocalSlot::get() const {
+    // Reading a slot resets the last error, which the caller may yet have to check
+    DWORD error = GetLastError();
+    void* value = m_fiber_local ? get_fiber_local_api().m_get_value(m_index) : TlsGetValue(m_index);
+    SetLastError(error);
+    return value;
+}
+
+void ThreadLocalSlot::set(void* value) {
+    if (m_fiber_local)
+        get_fiber_local_api().m_set_value(m_index, value);
+    else
+        TlsSetValue(m_index, value);
+}
+
+#else
+
+/*
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  Constructors
+ ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+*/
+
+ThreadLocalSlot::ThreadLocalSlot(Cleanup cleanup) {
+    pthread_key_create(&m_key, cleanup);
+}
+
+ThreadLocalSlot::~ThreadLocalSlot() {
+    pthread_key_delete(m_key);
+}
+
+#endif
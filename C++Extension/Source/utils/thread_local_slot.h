@@ -0,0 +1,66 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef THREAD_LOCAL_SLOT_H
+#define THREAD_LOCAL_SLOT_H
+
+#include "common.h"
+
+#ifdef _WIN32
+    #include "windows.h"
+    #define M_TLS_CLEANUP __stdcall
+#else
+    #include <pthread.h>
+    #define M_TLS_CLEANUP
+#endif
+
+// One pointer per thread. Implicit TLS (thread_local and __declspec(thread)) faults on Windows XP in a DLL loaded with
+// LoadLibrary, as the extension is, so Windows uses explicit slots: fiber-local ones where the system has them, whose
+// cleanup runs when a thread exits, and TlsAlloc ones on XP, where the cleanup never runs. Other systems use pthread
+// keys. The cleanup is only called for values that are not null.
+// Slots are meant to be static; a slot must outlive the threads that set it.
+class ThreadLocalSlot {
+public:
+    // Type-defines
+    typedef void (M_TLS_CLEANUP *Cleanup)(void* value);
+
+private:
+    // Variables
+#ifdef _WIN32
+    DWORD m_index;
+    bool m_fiber_local;
+#else
+    pthread_key_t m_key;
+#endif
+
+public:
+    // Constructors
+    ThreadLocalSlot(Cleanup cleanup = nullptr);
+    ~ThreadLocalSlot();
+
+    // Functions
+    void* get() const;
+    void set(void* value);
+};
+
+
+// Define inline functions
+
+#ifndef _WIN32
+
+inline void* ThreadLocalSlot::get() const {
+    return pthread_getspecific(m_key);
+}
+
+inline void ThreadLocalSlot::set(void* value) {
+    pthread_setspecific(m_key, value);
+}
+
+#endif
+
+#endif  /* THREAD_LOCAL_SLOT_H */
@@ -741,7 +741,7 @@ bool AMS::Sketchup::c_call_observer_event(ID method_id, int param_count, VALUE*
     if (!c_observers_contain(method_id)) return true;
     EventData event_data;
     event_data.id = method_id;
-    event_data.params = new VALUE[param_count];
+    event_data.params = ObjectPool::create_array<VALUE>(param_count);
     for (int x = 0; x < param_count; ++x)
         event_data.params[x] = TYPE(params[x]) == T_STRING ? rb_str_dup(params[x]) : params[x];
     event_data.size = param_count;
@@ -759,7 +759,7 @@ bool AMS::Sketchup::c_call_observer_event(ID method_id, int param_count, VALUE*
         if (v_res == Qfalse && block_allowed == true) process_message = false;
     }
     rb_ary_clear(t_su_observers);
-    delete[] event_data.params;
+    ObjectPool::destroy_array(event_data.params, param_count);
     return process_message;
 }
 
@@ -768,13 +768,13 @@ bool AMS::Sketchup::c_call_single_observer_event(VALUE v_observer, ID method_id,
     EventData event_data;
     event_data.observer = v_observer;
     event_data.id = method_id;
-    event_data.params = new VALUE[param_count];
+    event_data.params = ObjectPool::create_array<VALUE>(param_count);
     for (int x = 0; x < param_count; ++x)
         event_data.params[x] = TYPE(params[x]) == T_STRING ? rb_str_dup(params[x]) : params[x];
     event_data.size = param_count;
     VALUE v_res = rb_rescue2(RUBY_METHOD_FUNC(c_observer_call_proc), reinterpret_cast<VALUE>(&event_data), RUBY_METHOD_FUNC(c_observer_rescue_proc), reinterpret_cast<VALUE>(&event_data), rb_eException, 0);
     bool process_message = (v_res == Qfalse && block_allowed == true) ? true : false;
-    delete[] event_data.params;
+    ObjectPool::destroy_array(event_data.params, param_count);
     return process_message;
 }
 
@@ -1481,10 +1481,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                     c_call_observer_event(ID_SWO_ON_MENU_BAR_CHANGED, 1, params);
                     UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                     if (timer_id != 0) {
-                        PostEventData* data = new PostEventData;
+                        PostEventData* data = ObjectPool::create<PostEventData>();
                         data->id = ID_SWO_ON_POST_MENU_BAR_CHANGED;
                         data->size = 1;
-                        data->params = new VALUE[1];
+                        data->params = ObjectPool::create_array<VALUE>(1);
                         data->params[0] = params[0];
                         su_post_event_data[timer_id] = data;
                     }
@@ -1497,10 +1497,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                     c_call_observer_event(ID_SWO_ON_MENU_BAR_CHANGED, 1, params);
                     UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                     if (timer_id != 0) {
-                        PostEventData* data = new PostEventData;
+                        PostEventData* data = ObjectPool::create<PostEventData>();
                         data->id = ID_SWO_ON_POST_MENU_BAR_CHANGED;
                         data->size = 1;
-                        data->params = new VALUE[1];
+                        data->params = ObjectPool::create_array<VALUE>(1);
                         data->params[0] = params[0];
                         su_post_event_data[timer_id] = data;
                     }
@@ -1515,7 +1515,7 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                     c_call_observer_event(ID_SWO_ON_RESTORE, 0, nullptr);
                     UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                     if (timer_id != 0) {
-                        PostEventData* data = new PostEventData;
+                        PostEventData* data = ObjectPool::create<PostEventData>();
                         data->id = ID_SWO_ON_POST_RESTORE;
                         data->size = 0;
                         su_post_event_data[timer_id] = data;
@@ -1528,7 +1528,7 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                     c_call_observer_event(ID_SWO_ON_MINIMIZE, 0, nullptr);
                     UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                     if (timer_id != 0) {
-                        PostEventData* data = new PostEventData;
+                        PostEventData* data = ObjectPool::create<PostEventData>();
                         data->id = ID_SWO_ON_POST_MINIMIZE;
                         data->size = 0;
                         su_post_event_data[timer_id] = data;
@@ -1541,7 +1541,7 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                     c_call_observer_event(ID_SWO_ON_MAXIMIZE, 0, nullptr);
                     UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                     if (timer_id != 0) {
-                        PostEventData* data = new PostEventData;
+                        PostEventData* data = ObjectPool::create<PostEventData>();
                         data->id = ID_SWO_ON_POST_MAXIMIZE;
                         data->size = 0;
                         su_post_event_data[timer_id] = data;
@@ -1560,10 +1560,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                         c_call_observer_event(ID_SWO_ON_SWITCH_FULL_SCREEN, 1, params);
                         UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                         if (timer_id != 0) {
-                            PostEventData* data = new PostEventData;
+                            PostEventData* data = ObjectPool::create<PostEventData>();
                             data->id = ID_SWO_ON_POST_SWITCH_FULL_SCREEN;
                             data->size = 1;
-                            data->params = new VALUE[1];
+                            data->params = ObjectPool::create_array<VALUE>(1);
                             data->params[0] = params[0];
                             su_post_event_data[timer_id] = data;
                         }
@@ -1575,10 +1575,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                         c_call_observer_event(ID_SWO_ON_SWITCH_FULL_SCREEN, 1, params);
                         UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                         if (timer_id != 0) {
-                            PostEventData* data = new PostEventData;
+                            PostEventData* data = ObjectPool::create<PostEventData>();
                             data->id = ID_SWO_ON_POST_SWITCH_FULL_SCREEN;
                             data->size = 1;
-                            data->params = new VALUE[1];
+                            data->params = ObjectPool::create_array<VALUE>(1);
                             data->params[0] = params[0];
                             su_post_event_data[timer_id] = data;
                         }
@@ -1600,7 +1600,7 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                 c_call_observer_event(ID_SWO_ON_ENTER_MENU, 0, nullptr);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_ENTER_MENU;
                     data->size = 0;
                     su_post_event_data[timer_id] = data;
@@ -1613,7 +1613,7 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                 c_call_observer_event(ID_SWO_ON_EXIT_MENU, 0, nullptr);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_EXIT_MENU;
                     data->size = 0;
                     su_post_event_data[timer_id] = data;
@@ -1627,10 +1627,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                 c_call_observer_event(ID_SWO_ON_CAPTION_CHANGED, 1, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_CAPTION_CHANGED;
                     data->size = 1;
-                    data->params = new VALUE[1];
+                    data->params = ObjectPool::create_array<VALUE>(1);
                     data->params[0] = params[0];
                     su_post_event_data[timer_id] = data;
                 }
@@ -1642,7 +1642,7 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                 c_call_observer_event(wParam == WA_INACTIVE ? ID_SWO_ON_BLUR : ID_SWO_ON_FOCUS, 0, nullptr);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = wParam == WA_INACTIVE ? ID_SWO_ON_POST_BLUR : ID_SWO_ON_POST_FOCUS;
                     data->size = 0;
                     su_post_event_data[timer_id] = data;
@@ -1662,10 +1662,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                 c_call_observer_event(ID_SWO_ON_ENTER_SIZE_MOVE, 4, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_ENTER_SIZE_MOVE;
                     data->size = 4;
-                    data->params = new VALUE[data->size];
+                    data->params = ObjectPool::create_array<VALUE>(data->size);
                     for (unsigned int i = 0; i < data->size; ++i)
                         data->params[i] = params[i];
                     su_post_event_data[timer_id] = data;
@@ -1685,10 +1685,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                 c_call_observer_event(ID_SWO_ON_EXIT_SIZE_MOVE, 4, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_EXIT_SIZE_MOVE;
                     data->size = 4;
-                    data->params = new VALUE[data->size];
+                    data->params = ObjectPool::create_array<VALUE>(data->size);
                     for (unsigned int i = 0; i < data->size; ++i)
                         data->params[i] = params[i];
                     su_post_event_data[timer_id] = data;
@@ -1708,10 +1708,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomMainWindowProc(HWND handle, UINT msg, WPAR
                 c_call_observer_event(ID_SWO_ON_SIZE_MOVE, 4, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_SIZE_MOVE;
                     data->size = 4;
-                    data->params = new VALUE[data->size];
+                    data->params = ObjectPool::create_array<VALUE>(data->size);
                     for (unsigned int i = 0; i < data->size; ++i)
                         data->params[i] = params[i];
                     su_post_event_data[timer_id] = data;
@@ -1834,10 +1834,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomViewportWindowProc(HWND handle, UINT msg,
                     c_call_observer_event(ID_SWO_ON_VIEWPORT_BORDER_CHANGED, 1, params);
                     UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                     if (timer_id != 0) {
-                        PostEventData* data = new PostEventData;
+                        PostEventData* data = ObjectPool::create<PostEventData>();
                         data->id = ID_SWO_ON_POST_VIEWPORT_BORDER_CHANGED;
                         data->size = 1;
-                        data->params = new VALUE[1];
+                        data->params = ObjectPool::create_array<VALUE>(1);
                         data->params[0] = params[0];
                         su_post_event_data[timer_id] = data;
                     }
@@ -1847,10 +1847,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomViewportWindowProc(HWND handle, UINT msg,
                     c_call_observer_event(ID_SWO_ON_VIEWPORT_BORDER_CHANGED, 1, params);
                     UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                     if (timer_id != 0) {
-                        PostEventData* data = new PostEventData;
+                        PostEventData* data = ObjectPool::create<PostEventData>();
                         data->id = ID_SWO_ON_POST_VIEWPORT_BORDER_CHANGED;
                         data->size = 1;
-                        data->params = new VALUE[1];
+                        data->params = ObjectPool::create_array<VALUE>(1);
                         data->params[0] = params[0];
                         su_post_event_data[timer_id] = data;
                     }
@@ -1868,10 +1868,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomViewportWindowProc(HWND handle, UINT msg,
                 c_call_observer_event(ID_SWO_ON_VIEWPORT_SIZE, 2, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_VIEWPORT_SIZE;
                     data->size = 2;
-                    data->params = new VALUE[data->size];
+                    data->params = ObjectPool::create_array<VALUE>(data->size);
                     for (unsigned int i = 0; i < data->size; ++i)
                         data->params[i] = params[i];
                     su_post_event_data[timer_id] = data;
@@ -2021,7 +2021,7 @@ LRESULT CALLBACK AMS::Sketchup::CustomTabProc(HWND handle, UINT msg, WPARAM wPar
                 c_call_observer_event(ID_SWO_ON_SCENES_BAR_FILLED, 0, nullptr);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_SCENES_BAR_FILLED;
                     data->size = 0;
                     su_post_event_data[timer_id] = data;
@@ -2034,7 +2034,7 @@ LRESULT CALLBACK AMS::Sketchup::CustomTabProc(HWND handle, UINT msg, WPARAM wPar
                 c_call_observer_event(ID_SWO_ON_SCENES_BAR_EMPTIED, 0, nullptr);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_SCENES_BAR_EMPTIED;
                     data->size = 0;
                     su_post_event_data[timer_id] = data;
@@ -2047,7 +2047,7 @@ LRESULT CALLBACK AMS::Sketchup::CustomTabProc(HWND handle, UINT msg, WPARAM wPar
                 c_call_observer_event(ID_SWO_ON_SCENES_BAR_EMPTIED, 0, nullptr);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_SCENES_BAR_EMPTIED;
                     data->size = 0;
                     su_post_event_data[timer_id] = data;
@@ -2110,10 +2110,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomStatusBarProc(HWND handle, UINT msg, WPARA
                 c_call_observer_event(ID_SWO_ON_STATUS_BAR_VISIBILITY_CHANGED, 1, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_STATUS_BAR_VISIBILITY_CHANGED;
                     data->size = 1;
-                    data->params = new VALUE[1];
+                    data->params = ObjectPool::create_array<VALUE>(1);
                     data->params[0] = params[0];
                     su_post_event_data[timer_id] = data;
                 }
@@ -2123,10 +2123,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomStatusBarProc(HWND handle, UINT msg, WPARA
                 c_call_observer_event(ID_SWO_ON_STATUS_BAR_VISIBILITY_CHANGED, 1, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_STATUS_BAR_VISIBILITY_CHANGED;
                     data->size = 1;
-                    data->params = new VALUE[1];
+                    data->params = ObjectPool::create_array<VALUE>(1);
                     data->params[0] = params[0];
                     su_post_event_data[timer_id] = data;
                 }
@@ -2141,10 +2141,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomStatusBarProc(HWND handle, UINT msg, WPARA
                     c_call_observer_event(ID_SWO_ON_STATUS_BAR_VISIBILITY_CHANGED, 1, params);
                     UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                     if (timer_id != 0) {
-                        PostEventData* data = new PostEventData;
+                        PostEventData* data = ObjectPool::create<PostEventData>();
                         data->id = ID_SWO_ON_POST_STATUS_BAR_VISIBILITY_CHANGED;
                         data->size = 1;
-                        data->params = new VALUE[1];
+                        data->params = ObjectPool::create_array<VALUE>(1);
                         data->params[0] = params[0];
                         su_post_event_data[timer_id] = data;
                     }
@@ -2154,10 +2154,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomStatusBarProc(HWND handle, UINT msg, WPARA
                     c_call_observer_event(ID_SWO_ON_STATUS_BAR_VISIBILITY_CHANGED, 1, params);
                     UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                     if (timer_id != 0) {
-                        PostEventData* data = new PostEventData;
+                        PostEventData* data = ObjectPool::create<PostEventData>();
                         data->id = ID_SWO_ON_POST_STATUS_BAR_VISIBILITY_CHANGED;
                         data->size = 1;
-                        data->params = new VALUE[1];
+                        data->params = ObjectPool::create_array<VALUE>(1);
                         data->params[0] = params[0];
                         su_post_event_data[timer_id] = data;
                     }
@@ -2182,10 +2182,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomScenesBarProc(HWND handle, UINT msg, WPARA
                 c_call_observer_event(ID_SWO_ON_SCENES_BAR_VISIBILITY_CHANGED, 1, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_SCENES_BAR_VISIBILITY_CHANGED;
                     data->size = 1;
-                    data->params = new VALUE[1];
+                    data->params = ObjectPool::create_array<VALUE>(1);
                     data->params[0] = params[0];
                     su_post_event_data[timer_id] = data;
                 }
@@ -2195,10 +2195,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomScenesBarProc(HWND handle, UINT msg, WPARA
                 c_call_observer_event(ID_SWO_ON_SCENES_BAR_VISIBILITY_CHANGED, 1, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_SCENES_BAR_VISIBILITY_CHANGED;
                     data->size = 1;
-                    data->params = new VALUE[1];
+                    data->params = ObjectPool::create_array<VALUE>(1);
                     data->params[0] = params[0];
                     su_post_event_data[timer_id] = data;
                 }
@@ -2233,10 +2233,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomControlBarProc(HWND handle, UINT msg, WPAR
                 c_call_observer_event(ID_SWO_ON_TOOLBAR_CONTAINERS_VISIBILITY_CHANGED, 2, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_TOOLBAR_CONTAINERS_VISIBILITY_CHANGED;
                     data->size = 2;
-                    data->params = new VALUE[data->size];
+                    data->params = ObjectPool::create_array<VALUE>(data->size);
                     for (unsigned int i = 0; i < data->size; ++i)
                         data->params[i] = params[i];
                     su_post_event_data[timer_id] = data;
@@ -2250,10 +2250,10 @@ LRESULT CALLBACK AMS::Sketchup::CustomControlBarProc(HWND handle, UINT msg, WPAR
                 c_call_observer_event(ID_SWO_ON_TOOLBAR_CONTAINERS_VISIBILITY_CHANGED, 2, params);
                 UINT_PTR timer_id = SetTimer(NULL, 0, POST_EVENT_DELAY, PostEventTimerProc);
                 if (timer_id != 0) {
-                    PostEventData* data = new PostEventData;
+                    PostEventData* data = ObjectPool::create<PostEventData>();
                     data->id = ID_SWO_ON_POST_TOOLBAR_CONTAINERS_VISIBILITY_CHANGED;
                     data->size = 2;
-                    data->params = new VALUE[data->size];
+                    data->params = ObjectPool::create_array<VALUE>(data->size);
                     for (unsigned int i = 0; i < data->size; ++i)
                         data->params[i] = params[i];
                     su_post_event_data[timer_id] = data;
@@ -2512,8 +2512,8 @@ VOID CALLBACK AMS::Sketchup::PostEventTimerProc(HWND hwnd, UINT uMsg, UINT_PTR i
     c_call_observer_event(data->id, data->size, data->params);
     su_post_event_data.erase(it);
     if (data->size != 0 && data->params != nullptr)
-        delete[] data->params;
-    delete data;
+        ObjectPool::destroy_array(data->params, data->size);
+    ObjectPool::destroy(data);
 }
 
 
@@ -2608,13 +2608,13 @@ LRESULT CALLBACK AMS::Sketchup::KeyboardProc(int nCode, WPARAM wParam, LPARAM lP
 
     // Process accelerators when menu bar is removed.
     if ((HIWORD(lParam) & KF_UP) != KF_UP && GetMenu(su_main_window) != su_menu_bar) {
-        KeyboardShortcut* accelerator = new KeyboardShortcut();
-        accelerator->control_down = (GetKeyState(VK_CONTROL) >> 15) != 0;
-        accelerator->menu_down = (GetKeyState(VK_MENU) >> 15) != 0;
-        accelerator->shift_down = (GetKeyState(VK_SHIFT) >> 15) != 0;
-        accelerator->virtual_key = (int)wParam;
-        c_call_accelerator(accelerator);
-        delete accelerator;
+        // The shortcut only serves as a lookup key, so it lives on the stack
+        KeyboardShortcut accelerator;
+        accelerator.control_down = (GetKeyState(VK_CONTROL) >> 15) != 0;
+        accelerator.menu_down = (GetKeyState(VK_MENU) >> 15) != 0;
+        accelerator.shift_down = (GetKeyState(VK_SHIFT) >> 15) != 0;
+        accelerator.virtual_key = (int)wParam;
+        c_call_accelerator(&accelerator);
     }
     return CallNextHookEx(su_hooks[1], nCode, wParam, lParam);
 }
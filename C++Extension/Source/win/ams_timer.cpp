@@ -16,7 +16,7 @@
  ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 */
 
-std::map<unsigned long long, AMS::Timer::TimerData*> AMS::Timer::su_timers;
+FlatHashMap<unsigned long long, AMS::Timer::TimerData*> AMS::Timer::su_timers;
 VALUE AMS::Timer::su_timer_procedures;
 
 
@@ -50,21 +50,25 @@ VALUE AMS::Timer::c_rescue_proc(VALUE v_args, VALUE v_exception) {
 
 VOID CALLBACK AMS::Timer::TimerProc(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTime) {
     unsigned long long id = static_cast<unsigned long long>(idEvent);
-    std::map<unsigned long long, TimerData*>::iterator it = su_timers.find(id);
-    if (it == su_timers.end()) {
+    TimerData** pdata = su_timers.find(id);
+    if (pdata == nullptr) {
         KillTimer(hwnd, idEvent);
         return;
     }
-    TimerData* data = it->second;
+    TimerData* data = *pdata;
+    bool repeat = data->repeat;
     ++data->count;
     data->time = dwTime;
-    if (data->repeat == false)
+    // A one-shot timer is removed before its procedure runs, as the system may give its id to a timer the procedure
+    // starts; the procedure stays in the list until it returns, so it is not collected while running
+    if (repeat == false) {
         KillTimer(hwnd, idEvent);
+        su_timers.erase(id);
+    }
     rb_rescue2(RUBY_METHOD_FUNC(c_call_proc), reinterpret_cast<VALUE>(data), RUBY_METHOD_FUNC(c_rescue_proc), Qnil, rb_eException, VALUE(0));
-    if (data->repeat == false && su_timers.find(id) != su_timers.end()) {
+    if (repeat == false) {
         RU::array_delete_first(su_timer_procedures, data->proc);
         delete data;
-        su_timers.erase(it);
     }
 }
 
@@ -100,14 +104,15 @@ VALUE AMS::Timer::rbf_start(VALUE self, VALUE v_time_out, VALUE v_repeat) {
 
 VALUE AMS::Timer::rbf_stop(VALUE self, VALUE v_id) {
     unsigned long long id = RU::value_to_ull(v_id);
-    std::map<unsigned long long, TimerData*>::iterator it = su_timers.find(id);
-    if (it == su_timers.end())
+    TimerData** pdata = su_timers.find(id);
+    if (pdata == nullptr)
         return Qfalse;
     else {
+        TimerData* data = *pdata;
         KillTimer(AMS::Sketchup::su_main_window, static_cast<UINT_PTR>(id));
-        RU::array_delete_first(su_timer_procedures, it->second->proc);
-        delete it->second;
-        su_timers.erase(it);
+        su_timers.erase(id);
+        RU::array_delete_first(su_timer_procedures, data->proc);
+        delete data;
         return Qtrue;
     }
 }
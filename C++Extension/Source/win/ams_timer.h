@@ -23,7 +23,7 @@ public:
 
 private:
     // Variables
-    static std::map<unsigned long long, TimerData*> su_timers;
+    static FlatHashMap<unsigned long long, TimerData*> su_timers;
     static VALUE su_timer_procedures;
 
     // Helper Functions
@@ -118,5 +118,21 @@ module AMS
     def get_top_entity_by_id(id)
     end
 
+    # Get the counters of every thread hive created by the C++ extensions.
+    # @param [Boolean] reset Whether to zero the counters after reading them.
+    # @return [Array<Hash>] A Hash per hive, with the following keys:
+    #   - <tt>"mode"</tt> - <tt>"shared_queue"</tt> or <tt>"work_stealing"</tt>.
+    #   - <tt>"num_bees"</tt> - number of worker threads to run while there is work.
+    #   - <tt>"num_live_bees"</tt> - number of worker threads currently running.
+    #   - <tt>"num_queued"</tt> - number of tasks awaiting a thread.
+    #   - <tt>"bees"</tt> - an Array with the counters of each worker thread slot.
+    #   - <tt>"outside"</tt> - counters of the threads that processed tasks while waiting for them.
+    #   Counters are a Hash with <tt>"num_tasks"</tt>, <tt>"num_steals"</tt>, <tt>"busy_time"</tt>,
+    #   <tt>"idle_time"</tt>, <tt>"queue_time"</tt>, and <tt>"max_task_time"</tt> keys. Times are in seconds;
+    #   <tt>"queue_time"</tt> is the total time the processed tasks spent waiting in the queue.
+    # @since 3.7.0
+    def get_thread_hive_stats(reset = false)
+    end
+
   end # class << self
 end # module AMS
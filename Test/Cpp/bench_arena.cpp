@@ -0,0 +1,158 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Measures the share of runtime spent in the C allocator by a call shaped like Group.get_triangular_meshes: a walk
+// over a tree of nested groups that collects the faces of each group in a DynamicArray, builds a point list for every
+// face, and queues the child groups in a FastQueue. The call runs with its containers on the heap, as before the arena
+// was added, then with an arena made for each call, as the extension does, and with one arena kept across calls. Each
+// mode runs once untimed for its total time, then again with every allocator call timed. What a timed call records
+// includes the cost of reading the clock, which is measured on its own and taken off before the time in the allocator
+// is set against the untimed total to give its share. Needs glibc for the counts.
+
+#include "malloc_counter.h"
+
+#include "arena.h"
+#include "dynamic_array.h"
+#include "fast_queue.h"
+#include "geom_vector3d.h"
+
+#include <stdio.h>
+
+static const unsigned int NUM_CALLS = 500;
+static const unsigned int NUM_LEVELS = 4; // groups nested this deep
+static const unsigned int NUM_CHILDREN = 4; // groups within each group above the last level
+static const unsigned int NUM_ROUNDS = 3;
+
+enum Mode {
+    HEAP,
+    ARENA_PER_CALL,
+    ARENA_KEPT
+};
+
+struct Result {
+    double m_num_calls; // to the allocator, per call
+    double m_time; // per call in nanoseconds, untimed
+    double m_alloc_time; // per call in nanoseconds, less the cost of reading the clock
+};
+
+static double s_checksum = 0.0;
+static double s_clock_cost = 0.0; // recorded for an empty timed region, in nanoseconds
+
+// Times empty regions the way MallocCounter times allocator calls
+static void measure_clock_cost() {
+    static const unsigned int NUM_SAMPLES = 1000000;
+    long long start, total = 0;
+    unsigned int i;
+
+    for (i = 0; i < NUM_SAMPLES; ++i) {
+        start = MallocCounter::get_time();
+        total += MallocCounter::get_time() - start;
+    }
+    s_clock_cost = static_cast<double>(total) / NUM_SAMPLES;
+}
+
+static void walk_group(Arena* arena, unsigned int group, unsigned int level);
+
+// Collects the faces of one group, then descends into its children
+static void collect_group(Arena* arena, unsigned int group, unsigned int level) {
+    DynamicArray<size_t> faces = arena != nullptr ? DynamicArray<size_t>(*arena) : DynamicArray<size_t>();
+    FastQueue<unsigned int> children = arena != nullptr ? FastQueue<unsigned int>(*arena) : FastQueue<unsigned int>();
+    unsigned int num_faces = 20 + (group * 37) % 80;
+    unsigned int i, j, num_vertices;
+
+    for (i = 0; i < num_faces; ++i)
+        faces.append(0x7F0000000000ULL + (group * 1000 + i) * 40);
+
+    // A point list per face, as when triangulating it
+    for (i = 0; i < faces.size(); ++i) {
+        DynamicArray<Geom::Vector3d> points = arena != nullptr ? DynamicArray<Geom::Vector3d>(*arena) : DynamicArray<Geom::Vector3d>();
+        num_vertices = 3 + (i & 3);
+        for (j = 0; j < num_vertices; ++j)
+            points.append(Geom::Vector3d(static_cast<double>(faces[i] & 0xFFFF), static_cast<double>(j), 0.0));
+        s_checksum += points.last().m_x;
+    }
+
+    if (level + 1 < NUM_LEVELS) {
+        for (i = 0; i < NUM_CHILDREN; ++i)
+            children.enqueue(group * NUM_CHILDREN + i + 1);
+        while (!children.empty())
+            walk_group(arena, children.dequeue2(), level + 1);
+    }
+}
+
+// Each nesting level opens a scope of its own, which rewinds once the level's containers are gone
+static void walk_group(Arena* arena, unsigned int group, unsigned int level) {
+    if (arena != nullptr) {
+        Arena::Scope scope(*arena);
+        collect_group(arena, group, level);
+    }
+    else
+        collect_group(nullptr, group, level);
+}
+
+static void run_calls(Mode mode) {
+    Arena kept_arena;
+    unsigned int call;
+
+    for (call = 0; call < NUM_CALLS; ++call) {
+        if (mode == HEAP)
+            walk_group(nullptr, 0, 0);
+        else if (mode == ARENA_PER_CALL) {
+            Arena arena;
+            walk_group(&arena, 0, 0);
+        }
+        else
+            walk_group(&kept_arena, 0, 0);
+    }
+}
+
+static Result run(Mode mode) {
+    Result best = { 0.0, 0.0, 0.0 };
+    long long start, elapsed;
+    double alloc_time;
+    unsigned int round;
+
+    for (round = 0; round < NUM_ROUNDS; ++round) {
+        MallocCounter::reset(false);
+        start = MallocCounter::get_time();
+        run_calls(mode);
+        elapsed = MallocCounter::get_time() - start;
+        if (round == 0 || elapsed < best.m_time * NUM_CALLS)
+            best.m_time = static_cast<double>(elapsed) / NUM_CALLS;
+
+        MallocCounter::reset(true);
+        run_calls(mode);
+        MallocCounter::s_timing = false;
+        best.m_num_calls = static_cast<double>(MallocCounter::s_counts.get_num_calls()) / NUM_CALLS;
+        alloc_time = (static_cast<double>(MallocCounter::s_counts.m_time) - s_clock_cost * MallocCounter::s_counts.get_num_calls()) / NUM_CALLS;
+        if (alloc_time < 0.0)
+            alloc_time = 0.0;
+        if (round == 0 || alloc_time < best.m_alloc_time)
+            best.m_alloc_time = alloc_time;
+    }
+    return best;
+}
+
+static void print_row(const char* name, const Result& result) {
+    if (MallocCounter::is_available())
+        printf("%-22s %12.1f %12.0f %12.0f %10.1f%%\n", name, result.m_num_calls, result.m_time, result.m_alloc_time,
+            result.m_alloc_time * 100.0 / result.m_time);
+    else
+        printf("%-22s %12s %12.0f %12s %11s\n", name, "-", result.m_time, "-", "-");
+    fflush(stdout);
+}
+
+int main() {
+    measure_clock_cost();
+    printf("%u calls over %u levels of %u nested groups; per call, best of %u rounds\n", NUM_CALLS, NUM_LEVELS, NUM_CHILDREN, NUM_ROUNDS);
+    printf("%-22s %12s %12s %12s %11s\n", "containers", "alloc calls", "ns", "alloc ns", "share");
+    print_row("heap", run(HEAP));
+    print_row("arena per call", run(ARENA_PER_CALL));
+    print_row("arena across calls", run(ARENA_KEPT));
+    return s_checksum == 0.0 ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Times a breadth-first search over the vertex adjacency of a synthetic triangle mesh, serially with a BitBuffer of
+// visited flags and in parallel on a ThreadHive with an AtomicBitBuffer, where the bees expanding a level claim the
+// vertices of the next one with test_and_set. The mesh is a triangulated grid with a hole, so part of it is
+// unreachable from the seed. Each parallel search must visit the same vertices as the serial one, with the same number
+// of vertices on every level.
+
+#include "atomic_bit_buffer.h"
+#include "thread_hive.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+static const unsigned int GRID_SIZE = 1000; // vertices along each side
+static const unsigned int HOLE_SIZE = 200; // isolated vertices along each side of the central hole
+static const unsigned int NUM_ROUNDS = 5;
+static const size_t GRAIN = 1024;
+
+static unsigned int s_num_failures = 0;
+
+// The adjacency in compressed rows: the neighbours of vertex v are m_neighbours[m_offsets[v]] to
+// m_neighbours[m_offsets[v + 1] - 1]
+struct Mesh {
+    std::vector<unsigned int> m_offsets;
+    std::vector<unsigned int> m_neighbours;
+
+    size_t num_vertices() const {
+        return m_offsets.size() - 1;
+    }
+};
+
+static bool is_in_hole(unsigned int x, unsigned int y) {
+    unsigned int begin = (GRID_SIZE - HOLE_SIZE) / 2;
+    return x >= begin && x < begin + HOLE_SIZE && y >= begin && y < begin + HOLE_SIZE;
+}
+
+// Each grid cell is split into two triangles along its rising diagonal, so a vertex has up to six neighbours
+static void build_mesh(Mesh& mesh) {
+    static const int OFFSETS[6][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 }, { -1, -1 }, { 1, 1 } };
+    unsigned int x, y, k;
+    int nx, ny;
+
+    mesh.m_offsets.clear();
+    mesh.m_neighbours.clear();
+    for (y = 0; y < GRID_SIZE; ++y) {
+        for (x = 0; x < GRID_SIZE; ++x) {
+            mesh.m_offsets.push_back(static_cast<unsigned int>(mesh.m_neighbours.size()));
+            if (is_in_hole(x, y)) continue;
+            for (k = 0; k < 6; ++k) {
+                nx = static_cast<int>(x) + OFFSETS[k][0];
+                ny = static_cast<int>(y) + OFFSETS[k][1];
+                if (nx < 0 || ny < 0 || nx >= static_cast<int>(GRID_SIZE) || ny >= static_cast<int>(GRID_SIZE)) continue;
+                if (is_in_hole(nx, ny)) continue;
+                mesh.m_neighbours.push_back(ny * GRID_SIZE + nx);
+            }
+        }
+    }
+    mesh.m_offsets.push_back(static_cast<unsigned int>(mesh.m_neighbours.size()));
+}
+
+// Fills the number of vertices on each level and returns the time, in milliseconds
+static double search_serial(const Mesh& mesh, BitBuffer& visited, std::vector<size_t>& level_sizes) {
+    std::vector<unsigned int> frontier, next;
+    size_t i, j;
+    unsigned int v, n;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    visited.resize(mesh.num_vertices());
+    visited.clear();
+    level_sizes.clear();
+    visited.set_at(0);
+    frontier.push_back(0);
+    while (!frontier.empty()) {
+        level_sizes.push_back(frontier.size());
+        next.clear();
+        for (i = 0; i < frontier.size(); ++i) {
+            v = frontier[i];
+            for (j = mesh.m_offsets[v]; j < mesh.m_offsets[v + 1]; ++j) {
+                n = mesh.m_neighbours[j];
+                if (!visited.get_at(n)) {
+                    visited.set_at(n);
+                    next.push_back(n);
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Expands each level with parallel_for; a vertex goes to whichever bee sets its bit first, which appends it to the
+// next level through a shared counter
+static double search_parallel(ThreadHive& hive, const Mesh& mesh, AtomicBitBuffer& visited, std::vector<size_t>& level_sizes) {
+    std::vector<unsigned int> frontier(mesh.num_vertices());
+    std::vector<unsigned int> next(mesh.num_vertices());
+    std::atomic<size_t> next_size(0);
+    size_t frontier_size = 1;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    visited.clear();
+    level_sizes.clear();
+    visited.set_at(0);
+    frontier[0] = 0;
+    while (frontier_size != 0) {
+        level_sizes.push_back(frontier_size);
+        next_size.store(0, std::memory_order_relaxed);
+        hive.parallel_for(0, frontier_size, GRAIN, [&mesh, &visited, &frontier, &next, &next_size](size_t begin, size_t end) {
+            size_t i, j;
+            unsigned int v, n;
+            for (i = begin; i < end; ++i) {
+                v = frontier[i];
+                for (j = mesh.m_offsets[v]; j < mesh.m_offsets[v + 1]; ++j) {
+                    n = mesh.m_neighbours[j];
+                    if (!visited.test_and_set(n))
+                        next[next_size.fetch_add(1, std::memory_order_relaxed)] = n;
+                }
+            }
+        });
+        frontier.swap(next);
+        frontier_size = next_size.load(std::memory_order_relaxed);
+    }
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void check(const BitBuffer& expected_visited, const std::vector<size_t>& expected_levels,
+    const AtomicBitBuffer& visited, const std::vector<size_t>& level_sizes, unsigned int num_bees)
+{
+    BitBuffer difference;
+    size_t i;
+
+    visited.copy_to(difference);
+    difference.xor_with(expected_visited);
+    if (difference.popcount() != 0) {
+        printf("FAILED %u bees: %zu vertices visited differently\n", num_bees, difference.popcount());
+        ++s_num_failures;
+    }
+    if (level_sizes.size() != expected_levels.size()) {
+        printf("FAILED %u bees: %zu levels instead of %zu\n", num_bees, level_sizes.size(), expected_levels.size());
+        ++s_num_failures;
+        return;
+    }
+    for (i = 0; i < level_sizes.size(); ++i) {
+        if (level_sizes[i] != expected_levels[i]) {
+            printf("FAILED %u bees: %zu vertices on level %zu instead of %zu\n", num_bees, level_sizes[i], i, expected_levels[i]);
+            ++s_num_failures;
+            return;
+        }
+    }
+}
+
+int main() {
+    static const unsigned int BEE_COUNTS[] = { 1, 2, 4, 8 };
+    Mesh mesh;
+    BitBuffer expected_visited;
+    std::vector<size_t> expected_levels, level_sizes;
+    unsigned int i, round;
+    double time, best;
+
+    build_mesh(mesh);
+    AtomicBitBuffer visited(mesh.num_vertices());
+
+    best = 0.0;
+    for (round = 0; round < NUM_ROUNDS; ++round) {
+        time = search_serial(mesh, expected_visited, expected_levels);
+        if (round == 0 || time < best) best = time;
+    }
+    printf("%u hardware threads; %zu vertices, %zu reachable on %zu levels; best of %u rounds\n",
+        std::thread::hardware_concurrency(), mesh.num_vertices(), expected_visited.popcount(), expected_levels.size(), NUM_ROUNDS);
+    printf("%24s %10.2f ms\n", "serial, BitBuffer", best);
+
+    for (i = 0; i < sizeof(BEE_COUNTS) / sizeof(BEE_COUNTS[0]); ++i) {
+        ThreadHive hive(BEE_COUNTS[i]);
+        best = 0.0;
+        for (round = 0; round < NUM_ROUNDS; ++round) {
+            time = search_parallel(hive, mesh, visited, level_sizes);
+            if (round == 0 || time < best) best = time;
+            check(expected_visited, expected_levels, visited, level_sizes, BEE_COUNTS[i]);
+        }
+        printf("%2u bees, AtomicBitBuffer %10.2f ms\n", BEE_COUNTS[i], best);
+        fflush(stdout);
+    }
+
+    if (s_num_failures != 0) {
+        printf("%u failures\n", s_num_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Measures BlockingQueue over a sweep of capacities: the throughput of producer threads passing timestamped items to
+// consumer threads, the latency from push to pop, and how often producers had to wait for room. It then closes a queue
+// in the middle of a stream and checks that the consumers drain every item that was accepted, timing the drain.
+
+#include "blocking_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+static const unsigned int NUM_PRODUCERS = 2;
+static const unsigned int NUM_CONSUMERS = 2;
+static const unsigned int NUM_ITEMS = 200000; // per producer
+static const size_t BATCH_SIZE = 16;
+static const unsigned int DRAIN_CAPACITY = 4096;
+static const unsigned int DRAIN_TIME = 50; // in milliseconds; how long producers run before the queue is closed
+
+static long long get_time() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Passes the push times of NUM_ITEMS items per producer. Returns the time per item and fills the latencies, both in
+// nanoseconds.
+static double run(BlockingQueue<long long>& queue, std::vector<long long>& latencies_out) {
+    std::vector<std::thread> producers;
+    std::vector<std::thread> consumers;
+    std::vector<std::vector<long long> > latencies(NUM_CONSUMERS);
+    unsigned int i;
+    long long start = get_time();
+
+    for (i = 0; i < NUM_CONSUMERS; ++i) {
+        consumers.push_back(std::thread([&queue, &latencies, i]() {
+            long long items[BATCH_SIZE];
+            long long now;
+            size_t j, count;
+            while ((count = queue.pop_batch(items, BATCH_SIZE)) != 0) {
+                now = get_time();
+                for (j = 0; j < count; ++j)
+                    latencies[i].push_back(now - items[j]);
+            }
+        }));
+    }
+    for (i = 0; i < NUM_PRODUCERS; ++i) {
+        producers.push_back(std::thread([&queue]() {
+            for (unsigned int j = 0; j < NUM_ITEMS; ++j)
+                queue.push(get_time());
+        }));
+    }
+    for (i = 0; i < NUM_PRODUCERS; ++i)
+        producers[i].join();
+    queue.close();
+    for (i = 0; i < NUM_CONSUMERS; ++i)
+        consumers[i].join();
+
+    latencies_out.clear();
+    for (i = 0; i < NUM_CONSUMERS; ++i)
+        latencies_out.insert(latencies_out.end(), latencies[i].begin(), latencies[i].end());
+    if (latencies_out.size() != static_cast<size_t>(NUM_PRODUCERS) * NUM_ITEMS) {
+        printf("lost items\n");
+        exit(1);
+    }
+    return static_cast<double>(get_time() - start) / latencies_out.size();
+}
+
+static double get_percentile(std::vector<long long>& values, double fraction) {
+    size_t index = static_cast<size_t>(fraction * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return static_cast<double>(values[index]);
+}
+
+// Producers push until the queue rejects their items; whatever was accepted must come out
+static bool run_close_and_drain() {
+    BlockingQueue<unsigned int> queue(DRAIN_CAPACITY);
+    std::vector<std::thread> threads;
+    std::atomic<unsigned long long> num_pushed(0);
+    std::atomic<unsigned long long> num_popped(0);
+    unsigned int i;
+    long long close_time, drain_time;
+
+    for (i = 0; i < NUM_CONSUMERS; ++i) {
+        threads.push_back(std::thread([&queue, &num_popped]() {
+            unsigned int item;
+            while (queue.pop(item)) {
+                num_popped.fetch_add(1, std::memory_order_relaxed);
+                // Slower than the producers, so the queue is full when it closes
+                std::this_thread::sleep_for(std::chrono::microseconds(1));
+            }
+        }));
+    }
+    for (i = 0; i < NUM_PRODUCERS; ++i) {
+        threads.push_back(std::thread([&queue, &num_pushed]() {
+            unsigned int item = 0;
+            while (queue.push(item++))
+                num_pushed.fetch_add(1, std::memory_order_relaxed);
+        }));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_TIME));
+    close_time = get_time();
+    queue.close();
+    for (i = 0; i < threads.size(); ++i)
+        threads[i].join();
+    drain_time = get_time() - close_time;
+
+    printf("\nclose and drain, capacity %u: %llu items accepted, %llu popped, drained in %.2f ms\n",
+        DRAIN_CAPACITY, num_pushed.load(), num_popped.load(), drain_time * 1.0e-6);
+    return num_pushed.load() == num_popped.load() && queue.empty();
+}
+
+int main() {
+    static const size_t CAPACITIES[] = { 1, 4, 16, 64, 256, 1024, 4096 };
+    std::vector<long long> latencies;
+    unsigned int i;
+    double time_per_item;
+
+    printf("%u hardware threads; %u producers, %u consumers popping up to %zu items at a time\n",
+        std::thread::hardware_concurrency(), NUM_PRODUCERS, NUM_CONSUMERS, BATCH_SIZE);
+    printf("%10s %14s %16s %16s %12s\n", "capacity", "Mitems/s", "median latency", "99% latency", "full waits");
+    for (i = 0; i < sizeof(CAPACITIES) / sizeof(CAPACITIES[0]); ++i) {
+        BlockingQueue<long long> queue(CAPACITIES[i]);
+        time_per_item = run(queue, latencies);
+        printf("%10zu %14.2f %13.1f us %13.1f us %12llu\n", CAPACITIES[i], 1.0e3 / time_per_item,
+            get_percentile(latencies, 0.5) * 1.0e-3, get_percentile(latencies, 0.99) * 1.0e-3, queue.get_num_full_waits());
+        fflush(stdout);
+    }
+
+    if (!run_close_and_drain()) {
+        printf("accepted items were lost\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Times BoxSpace::overlap_self on scenes of randomly placed boxes, whose density stays the same as the scenes grow.
+// The traversal pushes every pair of overlapping nodes through a FastQueue, so the queue operations are a large part
+// of the time. Each scene is queried with a queue that is reused across calls, as the extension does, and with a new
+// queue per call, which also counts the growth of the queue.
+
+#include "geom_box_space.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace Geom;
+
+static const unsigned int NUM_ITEMS[] = { 1000, 10000, 100000 };
+static const double BOX_SIZE = 1.0;
+static const double ITEMS_PER_VOLUME = 0.5; // about two overlaps per box
+static const double MIN_TIME = 1.0; // in seconds, per measurement
+
+static std::vector<BoundingBox> s_boxes;
+
+static double random_unit() {
+    return static_cast<double>(rand()) / static_cast<double>(RAND_MAX);
+}
+
+static void update_box(unsigned int item, BoundingBox& bb, void* user_data) {
+    bb = s_boxes[item];
+}
+
+static bool count_pair(unsigned int item1, unsigned int item2, void* user_data) {
+    ++*reinterpret_cast<unsigned long long*>(user_data);
+    return true;
+}
+
+// Returns the time per call, in microseconds
+static double time_overlap_self(const BoxSpace<unsigned int>& space, bool reuse_queue, unsigned long long& num_pairs_out) {
+    FastQueue<Pair> queue;
+    unsigned long long num_pairs = 0;
+    unsigned int num_calls = 0;
+    double elapsed = 0.0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    while (elapsed < MIN_TIME) {
+        if (reuse_queue)
+            space.overlap_self(count_pair, queue, &num_pairs);
+        else {
+            FastQueue<Pair> new_queue;
+            space.overlap_self(count_pair, new_queue, &num_pairs);
+        }
+        ++num_calls;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    num_pairs_out = num_pairs / num_calls;
+    return elapsed * 1.0e6 / num_calls;
+}
+
+int main() {
+    unsigned int i, j, n;
+    unsigned long long num_pairs;
+    double side, reused_time, new_time;
+
+    srand(1);
+    printf("%10s %10s %10s %18s %18s\n", "items", "nodes", "pairs", "reused queue (us)", "new queue (us)");
+    for (i = 0; i < sizeof(NUM_ITEMS) / sizeof(NUM_ITEMS[0]); ++i) {
+        n = NUM_ITEMS[i];
+        side = pow(n / ITEMS_PER_VOLUME, 1.0 / 3.0);
+        s_boxes.clear();
+        for (j = 0; j < n; ++j) {
+            Vector3d min(random_unit() * side, random_unit() * side, random_unit() * side);
+            s_boxes.push_back(BoundingBox(min, min + Vector3d(BOX_SIZE)));
+        }
+
+        BoxSpace<unsigned int> space(4);
+        for (j = 0; j < n; ++j)
+            space.add_item(j);
+        space.update(update_box, 0.0, nullptr);
+
+        reused_time = time_overlap_self(space, true, num_pairs);
+        new_time = time_overlap_self(space, false, num_pairs);
+        printf("%10u %10u %10llu %18.1f %18.1f\n", n, space.m_num_nodes, num_pairs, reused_time, new_time);
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Appends 50M points to a DynamicArray, first growing it from empty, then into reserved space. Geom::Vector3d has a
+// user-defined copy constructor, so the array moves it item by item when growing; a plain struct of the same size
+// is also timed, as it is trivially copyable and so grows by reallocating. The peak memory of the process is read
+// after the first pass, which dominates it.
+
+#include "dynamic_array.h"
+#include "geom_vector3d.h"
+
+#include <chrono>
+#include <stdio.h>
+
+#ifdef _WIN32
+    #include "windows.h"
+    #include "psapi.h"
+    #pragma comment(lib, "psapi.lib")
+#else
+    #include <sys/resource.h>
+#endif
+
+static const size_t NUM_ITEMS = 50000000;
+static const unsigned int NUM_RUNS = 3;
+
+struct PlainPoint {
+    double m_x;
+    double m_y;
+    double m_z;
+};
+
+static inline Geom::Vector3d make_point(double x, Geom::Vector3d* type) {
+    return Geom::Vector3d(x, 1.0, 2.0);
+}
+
+static inline PlainPoint make_point(double x, PlainPoint* type) {
+    PlainPoint point = { x, 1.0, 2.0 };
+    return point;
+}
+
+static double get_peak_memory_mb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#elif defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / (1024.0 * 1024.0); // in bytes
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0; // in kilobytes
+#endif
+}
+
+// Returns the time of the fastest run, in milliseconds
+template <class T>
+static double time_append(bool reserve, double& checksum_out) {
+    double best = 0.0;
+    double elapsed;
+    size_t i;
+    unsigned int r;
+
+    for (r = 0; r < NUM_RUNS; ++r) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        DynamicArray<T> points;
+        if (reserve)
+            points.reserve(NUM_ITEMS);
+        for (i = 0; i < NUM_ITEMS; ++i)
+            points.append(make_point(static_cast<double>(i), static_cast<T*>(nullptr)));
+        elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        // Keep the items alive until after they are read, so they cannot be optimized away
+        checksum_out += points[NUM_ITEMS - 1].m_x + points[NUM_ITEMS / 2].m_x;
+        if (r == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+int main() {
+    double checksum = 0.0;
+    double grown_time, peak_memory, reserved_time, plain_grown_time, plain_reserved_time;
+
+    grown_time = time_append<Geom::Vector3d>(false, checksum);
+    peak_memory = get_peak_memory_mb();
+    reserved_time = time_append<Geom::Vector3d>(true, checksum);
+    plain_grown_time = time_append<PlainPoint>(false, checksum);
+    plain_reserved_time = time_append<PlainPoint>(true, checksum);
+
+    printf("%zu items of %zu bytes (checksum %.0f); ms per pass\n", NUM_ITEMS, sizeof(Geom::Vector3d), checksum);
+    printf("%12s %18s %15s\n", "", "grown from empty", "into reserved");
+    printf("%12s %18.1f %15.1f\n", "Vector3d", grown_time, reserved_time);
+    printf("%12s %18.1f %15.1f\n", "PlainPoint", plain_grown_time, plain_reserved_time);
+    printf("peak memory after growing Vector3d: %.0f MB\n", peak_memory);
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Compares FlatHashMap with std::map and std::unordered_map on one million entities, keyed the way the extension keys
+// its caches: by Ruby VALUEs, which are object addresses spaced by the size of a Ruby object. It times inserting all
+// entities, with and without reserving space first, then looking up every one of them, and then looking up as many
+// keys that are absent. Each time is the best of a few rounds.
+
+#include "flat_hash_map.h"
+
+#include <chrono>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unordered_map>
+#include <vector>
+
+static const size_t NUM_ENTITIES = 1000000;
+static const unsigned int NUM_ROUNDS = 3;
+static const size_t OBJECT_SIZE = 40; // bytes between Ruby objects on a 64-bit system
+
+struct Times {
+    double m_insert;
+    double m_lookup;
+    double m_miss;
+};
+
+static size_t s_checksum = 0;
+
+static double get_elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void keep_best(Times& best, const Times& times, unsigned int round) {
+    if (round == 0 || times.m_insert < best.m_insert) best.m_insert = times.m_insert;
+    if (round == 0 || times.m_lookup < best.m_lookup) best.m_lookup = times.m_lookup;
+    if (round == 0 || times.m_miss < best.m_miss) best.m_miss = times.m_miss;
+}
+
+static void insert(std::map<size_t, unsigned int>& map, size_t key, unsigned int value) {
+    map[key] = value;
+}
+
+static void insert(std::unordered_map<size_t, unsigned int>& map, size_t key, unsigned int value) {
+    map[key] = value;
+}
+
+static void insert(FlatHashMap<size_t, unsigned int>& map, size_t key, unsigned int value) {
+    map[key] = value;
+}
+
+static const unsigned int* find(const std::map<size_t, unsigned int>& map, size_t key) {
+    std::map<size_t, unsigned int>::const_iterator it = map.find(key);
+    return it != map.end() ? &it->second : nullptr;
+}
+
+static const unsigned int* find(const std::unordered_map<size_t, unsigned int>& map, size_t key) {
+    std::unordered_map<size_t, unsigned int>::const_iterator it = map.find(key);
+    return it != map.end() ? &it->second : nullptr;
+}
+
+static const unsigned int* find(const FlatHashMap<size_t, unsigned int>& map, size_t key) {
+    return map.find(key);
+}
+
+static void reserve(std::map<size_t, unsigned int>& map, size_t count) {
+}
+
+static void reserve(std::unordered_map<size_t, unsigned int>& map, size_t count) {
+    map.reserve(count);
+}
+
+static void reserve(FlatHashMap<size_t, unsigned int>& map, size_t count) {
+    map.reserve(count);
+}
+
+template <class Map>
+static Times run(const std::vector<size_t>& keys, const std::vector<size_t>& absent_keys, bool reserved) {
+    Times best = { 0.0, 0.0, 0.0 };
+    Times times;
+    std::chrono::steady_clock::time_point start;
+    const unsigned int* value;
+    unsigned int round;
+    size_t i, num_found;
+
+    for (round = 0; round < NUM_ROUNDS; ++round) {
+        Map map;
+
+        start = std::chrono::steady_clock::now();
+        if (reserved)
+            reserve(map, keys.size());
+        for (i = 0; i < keys.size(); ++i)
+            insert(map, keys[i], static_cast<unsigned int>(i));
+        times.m_insert = get_elapsed(start);
+
+        start = std::chrono::steady_clock::now();
+        num_found = 0;
+        for (i = 0; i < keys.size(); ++i) {
+            value = find(map, keys[i]);
+            if (value != nullptr)
+                num_found += *value == i ? 1 : 0;
+        }
+        times.m_lookup = get_elapsed(start);
+        if (num_found != keys.size()) {
+            printf("lookups found %zu of %zu entities\n", num_found, keys.size());
+            exit(1);
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (i = 0; i < absent_keys.size(); ++i)
+            num_found += find(map, absent_keys[i]) != nullptr ? 1 : 0;
+        times.m_miss = get_elapsed(start);
+        s_checksum += num_found;
+
+        keep_best(best, times, round);
+    }
+    return best;
+}
+
+static void print_row(const char* name, const Times& times) {
+    printf("%-32s %10.1f %10.1f %10.1f\n", name, times.m_insert, times.m_lookup, times.m_miss);
+    fflush(stdout);
+}
+
+int main() {
+    std::vector<size_t> keys(NUM_ENTITIES);
+    std::vector<size_t> absent_keys(NUM_ENTITIES);
+    std::vector<size_t> slots(NUM_ENTITIES * 2);
+    size_t i, j, temp;
+
+    // Entities sit in a heap twice their number, in random order; the free slots serve as absent keys
+    for (i = 0; i < slots.size(); ++i)
+        slots[i] = 0x7F0000000000ULL + i * OBJECT_SIZE;
+    srand(1);
+    for (i = slots.size() - 1; i > 0; --i) {
+        j = (static_cast<size_t>(rand()) * (static_cast<size_t>(RAND_MAX) + 1) + static_cast<size_t>(rand())) % (i + 1);
+        temp = slots[i];
+        slots[i] = slots[j];
+        slots[j] = temp;
+    }
+    for (i = 0; i < NUM_ENTITIES; ++i) {
+        keys[i] = slots[i];
+        absent_keys[i] = slots[NUM_ENTITIES + i];
+    }
+
+    printf("%zu entities; milliseconds, best of %u rounds\n", NUM_ENTITIES, NUM_ROUNDS);
+    printf("%-32s %10s %10s %10s\n", "map", "insert", "lookup", "miss");
+    print_row("std::map", run<std::map<size_t, unsigned int> >(keys, absent_keys, false));
+    print_row("std::unordered_map", run<std::unordered_map<size_t, unsigned int> >(keys, absent_keys, false));
+    print_row("std::unordered_map, reserved", run<std::unordered_map<size_t, unsigned int> >(keys, absent_keys, true));
+    print_row("FlatHashMap", run<FlatHashMap<size_t, unsigned int> >(keys, absent_keys, false));
+    print_row("FlatHashMap, reserved", run<FlatHashMap<size_t, unsigned int> >(keys, absent_keys, true));
+
+    return s_checksum == 0 ? 1 : 0;
+}
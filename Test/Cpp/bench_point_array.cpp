@@ -0,0 +1,145 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Compares the batch operations of Geom::PointArray, which keeps separate x, y, and z lanes, with plain loops over an
+// array of Vector3d, on ten million points: transforming, bounding, averaging, and finding the point nearest to
+// another. The transform is also timed with Transformation::transform_points, which works on the array of Vector3d
+// directly. Each time is the best of a few rounds, so the arrays are in their final place in memory.
+
+#include "geom_point_array.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Geom;
+
+static const size_t NUM_POINTS = 10000000;
+static const unsigned int NUM_ROUNDS = 3;
+
+static volatile double s_sink;
+
+static double random_coord() {
+    return static_cast<double>(rand()) / static_cast<double>(RAND_MAX) * 200.0 - 100.0;
+}
+
+static double get_elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void print_row(const char* operation, double aos_time, double soa_time) {
+    printf("%-22s %12.2f %12.2f %10.2fx\n", operation, aos_time, soa_time, aos_time / soa_time);
+}
+
+int main() {
+    DynamicArray<Vector3d> aos(NUM_POINTS);
+    DynamicArray<Vector3d> aos_out;
+    PointArray soa_out;
+    BoundingBox bb;
+    Vector3d centroid, query(3.3, -7.1, 12.0);
+    size_t i, nearest;
+    unsigned int round;
+    double time, dist_sq, best_dist_sq;
+    double loop_times[4], batch_time = 0.0, soa_times[4];
+    std::chrono::steady_clock::time_point start;
+
+    srand(1);
+    for (i = 0; i < NUM_POINTS; ++i)
+        aos.append(Vector3d(random_coord(), random_coord(), random_coord()));
+    PointArray soa(aos);
+    aos_out.resize(NUM_POINTS);
+
+    Transformation tra(Transformation::rotate(Vector3d(0.0, 0.6, 0.8), 0.3));
+    tra.m_origin = Vector4d(1.0, 2.0, 3.0, 1.0);
+
+    for (i = 0; i < 4; ++i)
+        loop_times[i] = soa_times[i] = 0.0;
+
+    for (round = 0; round < NUM_ROUNDS; ++round) {
+        // Transform
+        start = std::chrono::steady_clock::now();
+        for (i = 0; i < NUM_POINTS; ++i)
+            aos_out[i] = tra.transform_vector(aos[i]);
+        time = get_elapsed(start);
+        if (round == 0 || time < loop_times[0]) loop_times[0] = time;
+
+        start = std::chrono::steady_clock::now();
+        tra.transform_points(aos.pat(0), aos_out.pat(0), NUM_POINTS);
+        time = get_elapsed(start);
+        if (round == 0 || time < batch_time) batch_time = time;
+
+        start = std::chrono::steady_clock::now();
+        soa.transform(tra, soa_out);
+        time = get_elapsed(start);
+        if (round == 0 || time < soa_times[0]) soa_times[0] = time;
+
+        // Bounding box
+        start = std::chrono::steady_clock::now();
+        bb.clear();
+        for (i = 0; i < NUM_POINTS; ++i)
+            bb.add(aos[i]);
+        time = get_elapsed(start);
+        if (round == 0 || time < loop_times[1]) loop_times[1] = time;
+        s_sink = bb.m_max.m_x;
+
+        start = std::chrono::steady_clock::now();
+        soa.get_bounding_box(bb);
+        time = get_elapsed(start);
+        if (round == 0 || time < soa_times[1]) soa_times[1] = time;
+        s_sink = bb.m_max.m_x;
+
+        // Centroid
+        start = std::chrono::steady_clock::now();
+        centroid = Vector3d(0.0);
+        for (i = 0; i < NUM_POINTS; ++i)
+            centroid += aos[i];
+        centroid.scale_self(1.0 / static_cast<double>(NUM_POINTS));
+        time = get_elapsed(start);
+        if (round == 0 || time < loop_times[2]) loop_times[2] = time;
+        s_sink = centroid.m_x;
+
+        start = std::chrono::steady_clock::now();
+        soa.get_centroid(centroid);
+        time = get_elapsed(start);
+        if (round == 0 || time < soa_times[2]) soa_times[2] = time;
+        s_sink = centroid.m_x;
+
+        // Nearest point
+        start = std::chrono::steady_clock::now();
+        nearest = 0;
+        best_dist_sq = 1.0e300;
+        for (i = 0; i < NUM_POINTS; ++i) {
+            Vector3d d(aos[i] - query);
+            dist_sq = d.dot(d);
+            if (dist_sq < best_dist_sq) {
+                best_dist_sq = dist_sq;
+                nearest = i;
+            }
+        }
+        time = get_elapsed(start);
+        if (round == 0 || time < loop_times[3]) loop_times[3] = time;
+
+        start = std::chrono::steady_clock::now();
+        i = soa.find_nearest(query);
+        time = get_elapsed(start);
+        if (round == 0 || time < soa_times[3]) soa_times[3] = time;
+        if (i != nearest) {
+            printf("find_nearest returned point %zu instead of %zu\n", i, nearest);
+            return 1;
+        }
+    }
+
+    printf("%zu points; milliseconds, best of %u rounds\n", NUM_POINTS, NUM_ROUNDS);
+    printf("%-22s %12s %12s %11s\n", "operation", "Vector3d", "PointArray", "speedup");
+    print_row("transform", loop_times[0], soa_times[0]);
+    print_row("transform_points", batch_time, soa_times[0]);
+    print_row("bounding box", loop_times[1], soa_times[1]);
+    print_row("centroid", loop_times[2], soa_times[2]);
+    print_row("nearest point", loop_times[3], soa_times[3]);
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Compares MpmcQueue and SpscQueue with a FastQueue guarded by a mutex, passing integers from producer threads to
+// consumer threads. All queues hold the same number of items, and every side retries by yielding when the queue is
+// full or empty, so only the queues differ.
+
+#include "fast_queue.h"
+#include "mpmc_queue.h"
+#include "spsc_queue.h"
+
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+static const unsigned int CAPACITY = 1024;
+static const unsigned int NUM_ITEMS = 1000000; // per producer
+
+class LockedQueue {
+private:
+    std::mutex m_mutex;
+    FastQueue<unsigned int> m_queue;
+
+public:
+    LockedQueue() : m_queue(CAPACITY) {}
+
+    bool try_enqueue(const unsigned int& item) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.size() == CAPACITY) return false;
+        m_queue.enqueue(item);
+        return true;
+    }
+
+    bool try_dequeue(unsigned int& item_out) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.empty()) return false;
+        m_queue.dequeue(item_out);
+        return true;
+    }
+};
+
+// Returns the time per item, in nanoseconds
+template <class Queue>
+static double run(Queue& queue, unsigned int num_producers, unsigned int num_consumers) {
+    std::vector<std::thread> threads;
+    std::atomic<unsigned long long> sum(0);
+    std::atomic<unsigned int> num_left(num_producers * NUM_ITEMS);
+    unsigned int i;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (i = 0; i < num_producers; ++i) {
+        threads.push_back(std::thread([&queue]() {
+            for (unsigned int item = 1; item <= NUM_ITEMS; ++item)
+                while (!queue.try_enqueue(item))
+                    std::this_thread::yield();
+        }));
+    }
+    for (i = 0; i < num_consumers; ++i) {
+        threads.push_back(std::thread([&queue, &sum, &num_left]() {
+            unsigned long long local_sum = 0;
+            unsigned int item;
+            while (num_left.load(std::memory_order_relaxed) != 0) {
+                if (queue.try_dequeue(item)) {
+                    local_sum += item;
+                    num_left.fetch_sub(1, std::memory_order_relaxed);
+                }
+                else
+                    std::this_thread::yield();
+            }
+            sum.fetch_add(local_sum);
+        }));
+    }
+    for (i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    if (sum.load() != static_cast<unsigned long long>(num_producers) * NUM_ITEMS * (NUM_ITEMS + 1) / 2) {
+        printf("lost items\n");
+        exit(1);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (num_producers * NUM_ITEMS);
+}
+
+int main() {
+    static const unsigned int THREAD_COUNTS[] = { 1, 2, 4 };
+    unsigned int i, n;
+    double spsc_time, mpmc_time, locked_time;
+
+    printf("%u hardware threads; ns per item\n", std::thread::hardware_concurrency());
+    printf("%10s %10s %10s %10s %18s\n", "producers", "consumers", "SpscQueue", "MpmcQueue", "mutex + FastQueue");
+    for (i = 0; i < sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]); ++i) {
+        n = THREAD_COUNTS[i];
+        SpscQueue<unsigned int> spsc(CAPACITY);
+        MpmcQueue<unsigned int> mpmc(CAPACITY);
+        LockedQueue locked;
+
+        spsc_time = n == 1 ? run(spsc, 1, 1) : 0.0; // one of each side only
+        mpmc_time = run(mpmc, n, n);
+        locked_time = run(locked, n, n);
+        if (n == 1)
+            printf("%10u %10u %10.1f %10.1f %18.1f\n", n, n, spsc_time, mpmc_time, locked_time);
+        else
+            printf("%10u %10u %10s %10.1f %18.1f\n", n, n, "-", mpmc_time, locked_time);
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Builds the vertex lists of ten million faces, alternately triangles and quads, in SmallVector, DynamicArray, and
+// std::vector, counting the calls to the C allocator per list along with the time. A SmallVector with room for two
+// items shows the cost of spilling to the heap. The counts need glibc; elsewhere only the times are printed.
+
+#include "malloc_counter.h"
+
+#include "dynamic_array.h"
+#include "geom_vector3d.h"
+#include "small_vector.h"
+
+#include <stdio.h>
+#include <vector>
+
+static const unsigned int NUM_FACES = 10000000;
+
+static double s_checksum = 0.0;
+
+template <class List>
+static inline void add_vertex(List& vertices, const Geom::Vector3d& vertex) {
+    vertices.append(vertex);
+}
+
+static inline void add_vertex(std::vector<Geom::Vector3d>& vertices, const Geom::Vector3d& vertex) {
+    vertices.push_back(vertex);
+}
+
+template <class List>
+static inline double get_last_x(const List& vertices) {
+    return vertices.last().m_x;
+}
+
+static inline double get_last_x(const std::vector<Geom::Vector3d>& vertices) {
+    return vertices.back().m_x;
+}
+
+// A new list per face, as in a loop over the faces of an entity
+template <class List>
+static void run(const char* name) {
+    unsigned int face, i, num_vertices;
+    long long start, elapsed;
+
+    MallocCounter::reset();
+    start = MallocCounter::get_time();
+    for (face = 0; face < NUM_FACES; ++face) {
+        List vertices;
+        num_vertices = 3 + (face & 1);
+        for (i = 0; i < num_vertices; ++i)
+            add_vertex(vertices, Geom::Vector3d(static_cast<double>(face), static_cast<double>(i), 0.0));
+        s_checksum += get_last_x(vertices);
+    }
+    elapsed = MallocCounter::get_time() - start;
+
+    if (MallocCounter::is_available())
+        printf("%-28s %10.2f %10.2f %10.2f %10.1f\n", name,
+            static_cast<double>(MallocCounter::s_counts.m_num_mallocs) / NUM_FACES,
+            static_cast<double>(MallocCounter::s_counts.m_num_reallocs) / NUM_FACES,
+            static_cast<double>(MallocCounter::s_counts.m_num_frees) / NUM_FACES,
+            static_cast<double>(elapsed) / NUM_FACES);
+    else
+        printf("%-28s %10s %10s %10s %10.1f\n", name, "-", "-", "-", static_cast<double>(elapsed) / NUM_FACES);
+    fflush(stdout);
+}
+
+int main() {
+    printf("%u faces with 3 or 4 vertices; calls per face\n", NUM_FACES);
+    printf("%-28s %10s %10s %10s %10s\n", "list", "malloc", "realloc", "free", "ns");
+    run<SmallVector<Geom::Vector3d, 4> >("SmallVector<Vector3d, 4>");
+    run<SmallVector<Geom::Vector3d, 2> >("SmallVector<Vector3d, 2>");
+    run<DynamicArray<Geom::Vector3d> >("DynamicArray<Vector3d>");
+    run<std::vector<Geom::Vector3d> >("std::vector<Vector3d>");
+    return s_checksum == 0.0 ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Measures the latency from enqueue to the start of a task, for several spin counts of idle bees. A task is enqueued
+// after the hive has been idle for a gap; short gaps find the bees still spinning, long ones find them asleep. The
+// processor time of the process per task shows the cost of spinning.
+
+#include "thread_hive.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+static const unsigned int NUM_SAMPLES = 500;
+
+struct Sample {
+    std::chrono::steady_clock::time_point m_enqueue_time;
+    double m_latency; // in microseconds
+};
+
+static void record_task(void* user_data, ThreadHive* hive) {
+    Sample* sample = reinterpret_cast<Sample*>(user_data);
+    sample->m_latency = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sample->m_enqueue_time).count();
+}
+
+static void run(unsigned int spin_count, unsigned int gap) {
+    ThreadHive hive(2, ThreadHive::MODE_SHARED_QUEUE, spin_count);
+    std::vector<Sample> samples(NUM_SAMPLES);
+    std::vector<double> latencies(NUM_SAMPLES);
+    std::clock_t start_clock = std::clock();
+    unsigned int i;
+
+    for (i = 0; i < NUM_SAMPLES; ++i) {
+        if (gap != 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(gap));
+        samples[i].m_enqueue_time = std::chrono::steady_clock::now();
+        hive.enqueue(record_task, &samples[i]);
+        hive.wait_until_finished();
+        latencies[i] = samples[i].m_latency;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    printf("%8u %8u us %10.2f us %10.2f us %10.1f us\n", spin_count, gap, latencies[NUM_SAMPLES / 2],
+        latencies[NUM_SAMPLES * 99 / 100], (std::clock() - start_clock) * 1.0e6 / CLOCKS_PER_SEC / NUM_SAMPLES);
+    fflush(stdout);
+}
+
+int main() {
+    static const unsigned int SPIN_COUNTS[] = { 0, 100, 1000, 10000, 100000 };
+    static const unsigned int GAPS[] = { 0, 20, 200, 2000 }; // in microseconds
+    unsigned int i, j;
+
+    printf("%u processors, default spin count %u\n", ThreadHive::get_num_processors(), ThreadHive::DEFAULT_SPIN_COUNT);
+    printf("%8s %11s %13s %13s %13s\n", "spins", "gap", "median", "99th", "cpu/task");
+    for (i = 0; i < sizeof(SPIN_COUNTS) / sizeof(SPIN_COUNTS[0]); ++i)
+        for (j = 0; j < sizeof(GAPS) / sizeof(GAPS[0]); ++j)
+            run(SPIN_COUNTS[i], GAPS[j]);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Compares the shared-queue and work-stealing modes of ThreadHive with 1 to 64 bees, on two workloads:
+//  - flat: tiny tasks enqueued from outside the hive, which both modes distribute from one thread;
+//  - nested: tasks that enqueue their own subtasks, which work stealing keeps on the spawning bee.
+
+#include "thread_hive.h"
+
+#include <chrono>
+#include <stdio.h>
+
+static const unsigned int NUM_ROUNDS = 20;
+static const unsigned int NUM_FLAT_TASKS = 20000;
+static const unsigned int NUM_SPAWNERS = 200;
+static const unsigned int NUM_SUBTASKS = 100;
+
+static std::atomic<unsigned long long> s_sum(0);
+
+static void leaf_task(void* user_data, ThreadHive* hive) {
+    unsigned long long value = reinterpret_cast<size_t>(user_data);
+    for (unsigned int i = 0; i < 64; ++i)
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+    s_sum.fetch_add(value & 1, std::memory_order_relaxed);
+}
+
+static void spawner_task(void* user_data, ThreadHive* hive) {
+    for (unsigned int i = 0; i < NUM_SUBTASKS; ++i)
+        hive->enqueue(leaf_task, reinterpret_cast<void*>(static_cast<size_t>(i)));
+}
+
+// Returns the time per task, in nanoseconds
+static double run(ThreadHive::Mode mode, unsigned int num_bees, bool nested) {
+    ThreadHive hive(num_bees, mode);
+    unsigned int round, i;
+    unsigned long long num_tasks = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (round = 0; round < NUM_ROUNDS; ++round) {
+        if (nested) {
+            for (i = 0; i < NUM_SPAWNERS; ++i)
+                hive.enqueue(spawner_task, nullptr);
+            num_tasks += NUM_SPAWNERS * (NUM_SUBTASKS + 1);
+        }
+        else {
+            for (i = 0; i < NUM_FLAT_TASKS; ++i)
+                hive.enqueue(leaf_task, reinterpret_cast<void*>(static_cast<size_t>(i)));
+            num_tasks += NUM_FLAT_TASKS;
+        }
+        hive.wait_until_finished();
+    }
+
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / num_tasks;
+}
+
+int main() {
+    static const unsigned int BEE_COUNTS[] = { 1, 2, 4, 8, 16, 32, 64 };
+    unsigned int i;
+
+    printf("%u processors\n", ThreadHive::get_num_processors());
+    printf("%6s  %14s %14s  %14s %15s\n", "bees", "flat shared", "flat stealing", "nested shared", "nested stealing");
+    for (i = 0; i < sizeof(BEE_COUNTS) / sizeof(BEE_COUNTS[0]); ++i) {
+        printf("%6u  %11.1f ns %11.1f ns  %11.1f ns %12.1f ns\n", BEE_COUNTS[i],
+            run(ThreadHive::MODE_SHARED_QUEUE, BEE_COUNTS[i], false),
+            run(ThreadHive::MODE_WORK_STEALING, BEE_COUNTS[i], false),
+            run(ThreadHive::MODE_SHARED_QUEUE, BEE_COUNTS[i], true),
+            run(ThreadHive::MODE_WORK_STEALING, BEE_COUNTS[i], true));
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+#ifndef MALLOC_COUNTER_H
+#define MALLOC_COUNTER_H
+
+// Counts the calls to malloc, calloc, realloc, and free made anywhere in the program, including through operator new,
+// and optionally the time spent in them. It replaces those functions with ones that forward to the C library, which
+// only glibc exports under other names; elsewhere MallocCounter::is_available returns false and the counts stay at
+// zero. Include it from the one source file of a benchmark. The counters are plain, so only count single-threaded
+// code.
+
+#include <chrono>
+#include <stddef.h>
+
+class MallocCounter {
+public:
+    // Structures
+    struct Counts {
+        unsigned long long m_num_mallocs; // calloc included
+        unsigned long long m_num_reallocs; // of existing blocks; a realloc of nullptr counts as a malloc
+        unsigned long long m_num_frees; // of existing blocks
+        long long m_time; // in nanoseconds, while timing is on
+
+        unsigned long long get_num_calls() const {
+            return m_num_mallocs + m_num_reallocs + m_num_frees;
+        }
+    };
+
+    // Variables
+    static Counts s_counts;
+    static bool s_timing; // timing each call adds the cost of reading the clock twice
+
+    // Functions
+    static bool is_available() {
+#ifdef __GLIBC__
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static void reset(bool timing = false) {
+        s_counts.m_num_mallocs = 0;
+        s_counts.m_num_reallocs = 0;
+        s_counts.m_num_frees = 0;
+        s_counts.m_time = 0;
+        s_timing = timing;
+    }
+
+    static long long get_time() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+MallocCounter::Counts MallocCounter::s_counts = { 0, 0, 0, 0 };
+bool MallocCounter::s_timing = false;
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+    void* ptr;
+    long long start;
+    ++MallocCounter::s_counts.m_num_mallocs;
+    if (!MallocCounter::s_timing)
+        return __libc_malloc(size);
+    start = MallocCounter::get_time();
+    ptr = __libc_malloc(size);
+    MallocCounter::s_counts.m_time += MallocCounter::get_time() - start;
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size) {
+    void* ptr;
+    long long start;
+    ++MallocCounter::s_counts.m_num_mallocs;
+    if (!MallocCounter::s_timing)
+        return __libc_calloc(count, size);
+    start = MallocCounter::get_time();
+    ptr = __libc_calloc(count, size);
+    MallocCounter::s_counts.m_time += MallocCounter::get_time() - start;
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) {
+    void* new_ptr;
+    long long start;
+    if (ptr != nullptr)
+        ++MallocCounter::s_counts.m_num_reallocs;
+    else
+        ++MallocCounter::s_counts.m_num_mallocs;
+    if (!MallocCounter::s_timing)
+        return __libc_realloc(ptr, size);
+    start = MallocCounter::get_time();
+    new_ptr = __libc_realloc(ptr, size);
+    MallocCounter::s_counts.m_time += MallocCounter::get_time() - start;
+    return new_ptr;
+}
+
+void free(void* ptr) {
+    long long start;
+    if (ptr == nullptr) return;
+    ++MallocCounter::s_counts.m_num_frees;
+    if (!MallocCounter::s_timing) {
+        __libc_free(ptr);
+        return;
+    }
+    start = MallocCounter::get_time();
+    __libc_free(ptr);
+    MallocCounter::s_counts.m_time += MallocCounter::get_time() - start;
+}
+
+}
+
+#endif
+
+#endif  /* MALLOC_COUNTER_H */
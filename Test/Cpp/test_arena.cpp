@@ -0,0 +1,235 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Checks Arena: allocations are aligned and do not overlap, a Scope rewinds to where it began, also across blocks and
+// when nested, and the blocks it hands back are reused rather than allocated again. Reallocating the most recent block
+// extends or shrinks it in place while it fits, and anything else moves it with its contents. DynamicArray and
+// FastQueue are checked on an arena as well, as they reallocate through it. Build it with -fsanitize=address too.
+
+#include "arena.h"
+#include "dynamic_array.h"
+#include "fast_queue.h"
+
+#include <stdio.h>
+
+static const size_t BLOCK_SIZE = 1024;
+
+static unsigned int s_num_failures = 0;
+
+static void fail(const char* what) {
+    if (s_num_failures < 20)
+        printf("FAILED %s\n", what);
+    ++s_num_failures;
+}
+
+static bool is_filled(const void* ptr, size_t size, unsigned char pattern) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(ptr);
+    size_t i;
+    for (i = 0; i < size; ++i)
+        if (bytes[i] != pattern)
+            return false;
+    return true;
+}
+
+// Every allocation holds its own pattern, so overlapping allocations would overwrite each other
+static void test_allocate() {
+    Arena arena(BLOCK_SIZE);
+    unsigned char* ptrs[200];
+    size_t sizes[200];
+    size_t i, alignment;
+
+    for (i = 0; i < 200; ++i) {
+        alignment = static_cast<size_t>(1) << (i % 7);
+        sizes[i] = 1 + (i * 13) % 100;
+        if (i == 100)
+            sizes[i] = BLOCK_SIZE * 3; // an oversized request gets a block of its own
+        ptrs[i] = reinterpret_cast<unsigned char*>(arena.allocate(sizes[i], alignment));
+        if (reinterpret_cast<uintptr_t>(ptrs[i]) % alignment != 0)
+            fail("allocation alignment");
+        memset(ptrs[i], static_cast<int>(i), sizes[i]);
+    }
+    for (i = 0; i < 200; ++i)
+        if (!is_filled(ptrs[i], sizes[i], static_cast<unsigned char>(i)))
+            fail("allocation overwritten");
+    if (arena.get_num_allocations() != 200)
+        fail("allocation count");
+}
+
+// A scope gives back everything allocated within it, and the next allocation lands where the scope began
+static void test_scope() {
+    Arena arena(BLOCK_SIZE);
+    void* outer;
+    void* inner;
+    void* first;
+    size_t i, j, num_blocks;
+
+    outer = arena.allocate(100);
+    memset(outer, 0xAA, 100);
+    {
+        Arena::Scope scope(arena);
+        first = arena.allocate(64);
+        {
+            Arena::Scope inner_scope(arena);
+            inner = arena.allocate(64);
+        }
+        if (arena.allocate(64) != inner)
+            fail("nested scope did not rewind to where it began");
+    }
+    if (arena.allocate(64) != first)
+        fail("scope did not rewind to where it began");
+    if (!is_filled(outer, 100, 0xAA))
+        fail("allocation from before the scope overwritten");
+
+    // Spill over several blocks within a scope; rewinding keeps them as spares
+    arena.reset();
+    {
+        Arena::Scope scope(arena);
+        for (i = 0; i < 10; ++i)
+            arena.allocate(BLOCK_SIZE / 2);
+    }
+    num_blocks = arena.get_num_blocks();
+    if (num_blocks < 5)
+        fail("allocations spanning blocks did not add blocks");
+
+    // Doing the same again reuses the spare blocks
+    for (i = 0; i < 3; ++i) {
+        Arena::Scope scope(arena);
+        for (j = 0; j < 10; ++j)
+            memset(arena.allocate(BLOCK_SIZE / 2), 0x55, BLOCK_SIZE / 2);
+    }
+    if (arena.get_num_blocks() != num_blocks)
+        fail("rewound blocks were not reused");
+
+    // Releasing frees them all, and the arena stays usable
+    arena.release();
+    if (arena.get_num_blocks() != 0)
+        fail("release kept blocks");
+    memset(arena.allocate(16), 0, 16);
+    if (arena.get_num_blocks() != 1)
+        fail("allocation after release");
+}
+
+// The most recent allocation grows and shrinks in place while it fits its block; otherwise it moves with its contents
+static void test_reallocate() {
+    Arena arena(BLOCK_SIZE);
+    unsigned char* ptr;
+    unsigned char* other;
+    unsigned char* moved;
+
+    ptr = reinterpret_cast<unsigned char*>(arena.allocate(32));
+    memset(ptr, 0x11, 32);
+    if (arena.reallocate(ptr, 32, 256) != ptr)
+        fail("growing the most recent allocation moved it");
+    if (!is_filled(ptr, 32, 0x11))
+        fail("growing in place lost the contents");
+    memset(ptr, 0x22, 256);
+
+    // The arena's position follows, so the next allocation starts past the grown block
+    other = reinterpret_cast<unsigned char*>(arena.allocate(16, 1));
+    if (other < ptr + 256)
+        fail("allocation after growing in place overlaps the grown block");
+    arena.deallocate(other, 16);
+
+    if (arena.reallocate(ptr, 256, 64) != ptr)
+        fail("shrinking the most recent allocation moved it");
+    other = reinterpret_cast<unsigned char*>(arena.allocate(16, 1));
+    if (other != ptr + 64)
+        fail("shrinking in place did not give back the space");
+    memset(other, 0x33, 16);
+
+    // No longer the most recent, so it moves
+    moved = reinterpret_cast<unsigned char*>(arena.reallocate(ptr, 64, 128));
+    if (moved == ptr)
+        fail("reallocating an earlier allocation did not move it");
+    if (!is_filled(moved, 64, 0x22) || !is_filled(other, 16, 0x33))
+        fail("moving an earlier allocation lost contents");
+
+    // The most recent allocation moves to a new block when it outgrows its own
+    ptr = reinterpret_cast<unsigned char*>(arena.reallocate(moved, 128, BLOCK_SIZE * 2));
+    if (ptr == moved)
+        fail("growing past the block kept the allocation in place");
+    if (!is_filled(ptr, 64, 0x22))
+        fail("growing past the block lost the contents");
+
+    // Deallocating the most recent allocation gives back its space; others are left alone
+    other = reinterpret_cast<unsigned char*>(arena.allocate(48));
+    arena.deallocate(other, 48);
+    if (arena.allocate(48) != other)
+        fail("deallocating the most recent allocation did not give back its space");
+    arena.deallocate(ptr, BLOCK_SIZE * 2);
+    if (arena.allocate(8, 1) != other + 48)
+        fail("deallocating an earlier allocation moved the position");
+
+    // Reallocating nullptr allocates
+    if (arena.reallocate(nullptr, 0, 32) == nullptr)
+        fail("reallocating nullptr");
+}
+
+// Containers on an arena grow in place while they are its most recent allocation
+static void test_containers() {
+    Arena arena(BLOCK_SIZE * 16);
+    unsigned int i, item;
+    unsigned int* data;
+
+    {
+        Arena::Scope scope(arena);
+        DynamicArray<unsigned int> items(arena);
+        items.append(0);
+        data = &items[0];
+        for (i = 1; i < 1000; ++i)
+            items.append(i);
+        if (&items[0] != data)
+            fail("DynamicArray on an arena did not grow in place");
+        for (i = 0; i < 1000; ++i)
+            if (items[i] != i)
+                fail("DynamicArray on an arena lost items");
+
+        // Once another array follows it, it moves when it grows
+        DynamicArray<unsigned int> others(arena);
+        others.append(7);
+        for (i = 1000; i < 1100; ++i)
+            items.append(i);
+        if (&items[0] == data)
+            fail("DynamicArray on an arena grew over the one following it");
+        for (i = 0; i < 1100; ++i)
+            if (items[i] != i)
+                fail("DynamicArray on an arena lost items when moved");
+        if (others[0] != 7)
+            fail("moved DynamicArray overwrote another");
+
+        FastQueue<unsigned int> queue(arena);
+        for (i = 0; i < 100; ++i)
+            queue.enqueue(i);
+        for (i = 0; i < 50; ++i) {
+            queue.dequeue(item);
+            if (item != i)
+                fail("FastQueue on an arena lost order");
+            queue.enqueue(i + 100);
+        }
+        for (i = 50; i < 150; ++i) {
+            queue.dequeue(item);
+            if (item != i)
+                fail("FastQueue on an arena lost items when wrapped");
+        }
+    }
+    if (arena.get_num_blocks() != 1)
+        fail("containers on an arena took more than one block");
+}
+
+int main() {
+    test_allocate();
+    test_scope();
+    test_reallocate();
+    test_containers();
+
+    if (s_num_failures == 0)
+        printf("passed\n");
+    else
+        printf("%u failures\n", s_num_failures);
+    return s_num_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Checks BitBuffer against a std::vector<bool>: setting and clearing ranges that start, end, or lie within any word,
+// including on word boundaries; find_next_set from every index; and combining with buffers of smaller and larger
+// capacity, where the other's missing bits count as cleared. It also checks that ensure_capacity makes the given index
+// valid, that growing clears the new bits, and that AtomicBitBuffer::copy_to fits the target to the source. Build it
+// with -fsanitize=address too, which catches writes past the words.
+
+#include "bit_buffer.h"
+#include "atomic_bit_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const size_t NUM_BITS = 64 * 5;
+static const unsigned int NUM_RANGE_OPS = 20000;
+
+static unsigned int s_num_failures = 0;
+
+static void fail(const char* what, size_t arg) {
+    if (s_num_failures < 20)
+        printf("FAILED %s, at %zu\n", what, arg);
+    ++s_num_failures;
+}
+
+static bool matches(const BitBuffer& buffer, const std::vector<bool>& reference) {
+    size_t i;
+    if (buffer.capacity() != reference.size()) return false;
+    for (i = 0; i < reference.size(); ++i)
+        if (buffer.get_at(i) != reference[i])
+            return false;
+    return true;
+}
+
+static size_t count_bits(const std::vector<bool>& reference) {
+    size_t i, count = 0;
+    for (i = 0; i < reference.size(); ++i)
+        if (reference[i])
+            ++count;
+    return count;
+}
+
+// Picks an index near a word boundary more often than not, as that is where the masks change
+static size_t pick_index(size_t limit) {
+    size_t index;
+    if (rand() % 2 == 0)
+        index = static_cast<size_t>(rand()) % (limit + 1);
+    else {
+        // One before, on, or one past the boundary
+        index = (static_cast<size_t>(rand()) % (limit / BitBuffer::WORD_BITS + 1)) * BitBuffer::WORD_BITS;
+        index += static_cast<size_t>(rand() % 3);
+        index = index > 0 ? index - 1 : 0;
+    }
+    if (index > limit)
+        index = limit;
+    return index;
+}
+
+static void fill_random(BitBuffer& buffer, std::vector<bool>& reference, size_t num_bits, unsigned int density) {
+    size_t i;
+    buffer.resize(num_bits);
+    buffer.clear();
+    reference.assign(num_bits, false);
+    for (i = 0; i < num_bits; ++i) {
+        if (static_cast<unsigned int>(rand()) % 100 < density) {
+            buffer.set_at(i);
+            reference[i] = true;
+        }
+    }
+}
+
+static void test_ranges() {
+    BitBuffer buffer(NUM_BITS);
+    std::vector<bool> reference(NUM_BITS, false);
+    size_t begin, end, i;
+    unsigned int op;
+
+    srand(1);
+    for (op = 0; op < NUM_RANGE_OPS; ++op) {
+        begin = pick_index(NUM_BITS);
+        end = pick_index(NUM_BITS);
+        if (begin > end && rand() % 4 != 0) {
+            i = begin;
+            begin = end;
+            end = i;
+        }
+        if (op % 2 == 0) {
+            buffer.set_range(begin, end);
+            for (i = begin; i < end; ++i)
+                reference[i] = true;
+        }
+        else {
+            buffer.unset_range(begin, end);
+            for (i = begin; i < end; ++i)
+                reference[i] = false;
+        }
+        if (!matches(buffer, reference)) {
+            fail(op % 2 == 0 ? "set_range" : "unset_range", begin);
+            return;
+        }
+        if (buffer.popcount() != count_bits(reference))
+            fail("popcount after a range operation", op);
+    }
+
+    // Clearing the first bits stops at the given count
+    buffer.set_range(0, NUM_BITS);
+    buffer.partial_clear(BitBuffer::WORD_BITS + 1);
+    if (buffer.find_first_set() != BitBuffer::WORD_BITS + 1 || buffer.popcount() != NUM_BITS - BitBuffer::WORD_BITS - 1)
+        fail("partial_clear", BitBuffer::WORD_BITS + 1);
+}
+
+static void test_find_next_set() {
+    static const unsigned int DENSITIES[] = { 0, 1, 10, 50, 99, 100 };
+    BitBuffer buffer;
+    std::vector<bool> reference;
+    size_t i, expected;
+    unsigned int d;
+
+    for (d = 0; d < sizeof(DENSITIES) / sizeof(DENSITIES[0]); ++d) {
+        fill_random(buffer, reference, NUM_BITS, DENSITIES[d]);
+
+        // Scan from every index, and from beyond the end
+        expected = NUM_BITS;
+        for (i = NUM_BITS + BitBuffer::WORD_BITS; i-- > 0;) {
+            if (i < NUM_BITS && reference[i])
+                expected = i;
+            if (buffer.find_next_set(i) != expected) {
+                fail("find_next_set", i);
+                break;
+            }
+        }
+        if (buffer.find_first_set() != expected)
+            fail("find_first_set", DENSITIES[d]);
+    }
+
+    // Only the last bit, and only the first bit of a word
+    buffer.clear();
+    buffer.set_at(NUM_BITS - 1);
+    if (buffer.find_next_set(0) != NUM_BITS - 1 || buffer.find_next_set(NUM_BITS - 1) != NUM_BITS - 1)
+        fail("find_next_set of the last bit", NUM_BITS - 1);
+    buffer.clear();
+    buffer.set_at(BitBuffer::WORD_BITS * 2);
+    if (buffer.find_next_set(BitBuffer::WORD_BITS * 2 - 1) != BitBuffer::WORD_BITS * 2 ||
+        buffer.find_next_set(BitBuffer::WORD_BITS * 2 + 1) != NUM_BITS)
+        fail("find_next_set around the first bit of a word", BitBuffer::WORD_BITS * 2);
+}
+
+// Combines buffers of every pair of sizes; this buffer keeps its capacity, except that or and xor grow it to the other's
+static void test_combine() {
+    static const size_t SIZES[] = { 64, 128, 320 };
+    static const char* NAMES[] = { "and_with", "or_with", "xor_with", "and_not_with" };
+    BitBuffer buffer, other;
+    std::vector<bool> reference, other_reference;
+    size_t s, t, i, result_size;
+    unsigned int op;
+    bool a, b;
+
+    srand(2);
+    for (s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); ++s) {
+        for (t = 0; t < sizeof(SIZES) / sizeof(SIZES[0]); ++t) {
+            for (op = 0; op < 4; ++op) {
+                fill_random(buffer, reference, SIZES[s], 50);
+                fill_random(other, other_reference, SIZES[t], 50);
+
+                if (op == 0) buffer.and_with(other);
+                else if (op == 1) buffer.or_with(other);
+                else if (op == 2) buffer.xor_with(other);
+                else buffer.and_not_with(other);
+
+                result_size = (op == 1 || op == 2) && SIZES[t] > SIZES[s] ? SIZES[t] : SIZES[s];
+                reference.resize(result_size, false);
+                for (i = 0; i < result_size; ++i) {
+                    a = reference[i];
+                    b = i < SIZES[t] ? other_reference[i] : false;
+                    if (op == 0) reference[i] = a && b;
+                    else if (op == 1) reference[i] = a || b;
+                    else if (op == 2) reference[i] = a != b;
+                    else reference[i] = a && !b;
+                }
+                if (!matches(buffer, reference))
+                    fail(NAMES[op], SIZES[s] * 1000 + SIZES[t]);
+                if (!matches(other, other_reference))
+                    fail("combining changed the other buffer", SIZES[s] * 1000 + SIZES[t]);
+            }
+        }
+    }
+}
+
+static void test_capacity() {
+    static const size_t INDICES[] = { 0, 1, 63, 64, 65, 127, 128, 1000 };
+    size_t i, capacity;
+
+    for (i = 0; i < sizeof(INDICES) / sizeof(INDICES[0]); ++i) {
+        BitBuffer buffer;
+        buffer.set_at(0);
+        buffer.ensure_capacity(INDICES[i]);
+        if (buffer.capacity() <= INDICES[i] || buffer.capacity() % BitBuffer::WORD_BITS != 0)
+            fail("ensure_capacity did not make the index valid", INDICES[i]);
+        capacity = buffer.capacity();
+        buffer.set_at(INDICES[i]);
+        if (!buffer.get_at(0) || buffer.popcount() != (INDICES[i] == 0 ? 1 : 2))
+            fail("ensure_capacity lost or added bits", INDICES[i]);
+        buffer.ensure_capacity(INDICES[i]);
+        if (buffer.capacity() != capacity)
+            fail("ensure_capacity grew a buffer that was large enough", INDICES[i]);
+
+        BitBuffer pow2_buffer;
+        pow2_buffer.ensure_capacity_pow2(INDICES[i]);
+        capacity = pow2_buffer.capacity() / BitBuffer::WORD_BITS;
+        if (pow2_buffer.capacity() <= INDICES[i] || (capacity & (capacity - 1)) != 0)
+            fail("ensure_capacity_pow2", INDICES[i]);
+        pow2_buffer.set_at(INDICES[i]);
+    }
+
+    // Growing clears the new bits; shrinking clears the bits past the new end within its last word
+    BitBuffer buffer(BitBuffer::WORD_BITS);
+    buffer.set_range(0, BitBuffer::WORD_BITS);
+    buffer.resize(BitBuffer::WORD_BITS * 3);
+    if (buffer.popcount() != BitBuffer::WORD_BITS || buffer.find_next_set(BitBuffer::WORD_BITS) != buffer.capacity())
+        fail("growing did not clear the new bits", BitBuffer::WORD_BITS * 3);
+    buffer.set_range(0, buffer.capacity());
+    buffer.resize(BitBuffer::WORD_BITS + 10);
+    if (buffer.capacity() != BitBuffer::WORD_BITS * 2 || buffer.popcount() != BitBuffer::WORD_BITS + 10)
+        fail("shrinking", BitBuffer::WORD_BITS + 10);
+    buffer.resize(BitBuffer::WORD_BITS * 4);
+    if (buffer.popcount() != BitBuffer::WORD_BITS + 10)
+        fail("growing after shrinking revived cleared bits", BitBuffer::WORD_BITS * 4);
+}
+
+// Copying an atomic buffer grows a smaller target to its capacity and clears the bits of a larger one past it
+static void test_copy_to() {
+    AtomicBitBuffer source(BitBuffer::WORD_BITS * 2);
+    BitBuffer small_target;
+    BitBuffer large_target(BitBuffer::WORD_BITS * 4);
+
+    source.set_at(3);
+    source.set_at(BitBuffer::WORD_BITS * 2 - 1);
+
+    source.copy_to(small_target);
+    if (small_target.capacity() != source.capacity() || small_target.popcount() != 2 ||
+        !small_target.get_at(BitBuffer::WORD_BITS * 2 - 1))
+        fail("copy_to a smaller buffer", small_target.capacity());
+
+    large_target.set_range(0, large_target.capacity());
+    source.copy_to(large_target);
+    if (large_target.capacity() != BitBuffer::WORD_BITS * 4 || large_target.popcount() != 2 || !large_target.get_at(3))
+        fail("copy_to a larger buffer", large_target.capacity());
+}
+
+int main() {
+    test_ranges();
+    test_find_next_set();
+    test_combine();
+    test_capacity();
+    test_copy_to();
+
+    if (s_num_failures == 0)
+        printf("passed\n");
+    else
+        printf("%u failures\n", s_num_failures);
+    return s_num_failures == 0 ? 0 : 1;
+}
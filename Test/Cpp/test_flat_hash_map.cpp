@@ -0,0 +1,300 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Checks FlatHashMap against std::map over random inserts, lookups and erases, with a good hash and with hashes that
+// pile every key onto a few home slots, one of them the last slot so that clusters wrap around. After every operation
+// the table must keep the Robin Hood layout: each entry sits at its recorded distance from its home, no entry is
+// further from home than the one before it plus one, and no entry past its home follows an empty slot, which is what
+// erasing with backward shifts has to preserve. It also checks that reserving space holds off growth while the keys
+// collide, and that iteration, copies and moves see every entry. The values are strings, so that entries shifted or
+// moved without being constructed properly show up under -fsanitize=address.
+
+#include "flat_hash_map.h"
+
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+static const unsigned int NUM_OPERATIONS = 20000;
+static const size_t KEY_RANGE = 300;
+static const size_t NUM_RESERVED = 500;
+
+static unsigned int s_num_failures = 0;
+
+// Sends every key to one of four home slots
+struct ClusterHash {
+    size_t operator()(size_t key) const {
+        return key & 3;
+    }
+};
+
+// Sends every key to the last slot, so the cluster wraps around to the first
+struct LastSlotHash {
+    size_t operator()(size_t key) const {
+        return ~static_cast<size_t>(0);
+    }
+};
+
+static void fail(const char* what, const char* hash_name) {
+    if (s_num_failures < 20)
+        printf("FAILED %s, %s\n", what, hash_name);
+    ++s_num_failures;
+}
+
+// Opens the table up to check its layout
+template <class Hash>
+class CheckedMap : public FlatHashMap<size_t, std::string, Hash> {
+public:
+    // Returns nullptr if the layout is sound, or else what is wrong with it
+    const char* check_layout() const {
+        size_t i, home, num_occupied = 0;
+        unsigned short distance, prev_distance;
+
+        for (i = 0; i <= this->m_mask; ++i) {
+            distance = this->m_distances[i];
+            if (distance == 0) continue;
+            ++num_occupied;
+            home = (i - (distance - 1)) & this->m_mask;
+            if (home != (this->m_hash(this->m_entries[i].m_key) & this->m_mask))
+                return "entry not at its recorded distance from home";
+            prev_distance = this->m_distances[(i - 1) & this->m_mask];
+            if (distance > 1 && prev_distance == 0)
+                return "entry past its home follows an empty slot";
+            if (distance > prev_distance + 1)
+                return "entry further from home than the one before it plus one";
+        }
+        if (num_occupied != this->m_size)
+            return "size does not match the occupied slots";
+        return nullptr;
+    }
+
+    unsigned short get_distance(size_t index) const {
+        return this->m_distances[index];
+    }
+
+    const size_t& get_key(size_t index) const {
+        return this->m_entries[index].m_key;
+    }
+};
+
+static std::string to_value(size_t key, unsigned int version) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "value of entity %zu, version %u", key, version);
+    return std::string(buffer);
+}
+
+template <class Hash>
+static void check_layout(const CheckedMap<Hash>& map, const char* hash_name) {
+    const char* error = map.check_layout();
+    if (error != nullptr)
+        fail(error, hash_name);
+}
+
+// Lookups find every reference entry, and iteration visits each of them once
+template <class Hash>
+static void check_contents(const CheckedMap<Hash>& map, const std::map<size_t, std::string>& reference, const char* hash_name) {
+    std::map<size_t, std::string>::const_iterator it;
+    typename CheckedMap<Hash>::ConstIterator entry_it = map.begin();
+    std::map<size_t, unsigned int> visits;
+    const std::string* value;
+
+    if (map.size() != reference.size())
+        fail("size", hash_name);
+    for (it = reference.begin(); it != reference.end(); ++it) {
+        value = map.find(it->first);
+        if (value == nullptr || *value != it->second)
+            fail("lookup of a present key", hash_name);
+    }
+    for (; entry_it != map.end(); ++entry_it) {
+        it = reference.find(entry_it->m_key);
+        if (it == reference.end() || entry_it->m_value != it->second)
+            fail("iteration visited an entry that is not present", hash_name);
+        ++visits[entry_it->m_key];
+    }
+    if (visits.size() != reference.size())
+        fail("iteration missed an entry", hash_name);
+    for (std::map<size_t, unsigned int>::const_iterator visit_it = visits.begin(); visit_it != visits.end(); ++visit_it)
+        if (visit_it->second != 1)
+            fail("iteration visited an entry twice", hash_name);
+}
+
+template <class Hash>
+static void test_random(const char* hash_name) {
+    CheckedMap<Hash> map;
+    std::map<size_t, std::string> reference;
+    std::string value;
+    unsigned int i, operation;
+    size_t key;
+    bool present;
+
+    srand(1);
+    for (i = 0; i < NUM_OPERATIONS; ++i) {
+        key = static_cast<size_t>(rand()) % KEY_RANGE;
+        present = reference.count(key) != 0;
+        operation = static_cast<unsigned int>(rand()) % 8;
+        if (operation < 3) {
+            value = to_value(key, i);
+            if (map.insert(key, value) == present)
+                fail("insert result", hash_name);
+            reference.insert(std::make_pair(key, value));
+        }
+        else if (operation < 5) {
+            value = to_value(key, i);
+            map[key] = value;
+            reference[key] = value;
+        }
+        else if (operation < 7) {
+            if (map.erase(key) != present)
+                fail("erase result", hash_name);
+            reference.erase(key);
+        }
+        else {
+            if (map.contains(key) != present || (map.find(key) != nullptr) != present)
+                fail("lookup", hash_name);
+        }
+        check_layout(map, hash_name);
+        if (i % 1000 == 0)
+            check_contents(map, reference, hash_name);
+    }
+    check_contents(map, reference, hash_name);
+
+    // Erasing everything leaves no entry behind
+    for (key = 0; key < KEY_RANGE; ++key)
+        map.erase(key);
+    check_layout(map, hash_name);
+    if (!map.empty() || map.begin() != map.end())
+        fail("erasing every key", hash_name);
+}
+
+// Erasing the head of a cluster shifts the rest of it one slot back, each entry one step closer to home
+static void test_backward_shift() {
+    CheckedMap<ClusterHash> map;
+    size_t key;
+
+    // Keys 0, 4 and 8 share home slot 0, keys 1 and 5 share slot 1, so the cluster spans slots 0 to 4
+    map.insert(0, to_value(0, 0));
+    map.insert(4, to_value(4, 0));
+    map.insert(8, to_value(8, 0));
+    map.insert(1, to_value(1, 0));
+    map.insert(5, to_value(5, 0));
+    check_layout(map, "ClusterHash");
+    if (map.get_distance(0) != 1 || map.get_distance(2) != 3 || map.get_distance(3) != 3 || map.get_distance(4) != 4 ||
+        map.get_distance(5) != 0)
+        fail("cluster layout before erasing", "ClusterHash");
+
+    map.erase(0);
+    check_layout(map, "ClusterHash");
+    if (map.get_key(0) != 4 || map.get_distance(0) != 1 || map.get_key(1) != 8 || map.get_distance(1) != 2 ||
+        map.get_distance(2) != 2 || map.get_distance(3) != 3 || map.get_distance(4) != 0)
+        fail("cluster layout after erasing its head", "ClusterHash");
+
+    // Erasing the middle of the cluster shifts only what follows it
+    map.erase(8);
+    check_layout(map, "ClusterHash");
+    if (map.get_key(0) != 4 || map.get_distance(1) != 1 || map.get_distance(2) != 2 || map.get_distance(3) != 0)
+        fail("cluster layout after erasing its middle", "ClusterHash");
+
+    for (key = 1; key <= 5; key += 4)
+        if (map.find(key) == nullptr || *map.find(key) != to_value(key, 0))
+            fail("value shifted by erasing", "ClusterHash");
+}
+
+// Reserving makes room for the reserved number of entries, however they collide
+template <class Hash>
+static void test_reserve(const char* hash_name) {
+    CheckedMap<Hash> map;
+    size_t key, capacity;
+
+    map.reserve(NUM_RESERVED);
+    capacity = map.capacity();
+    for (key = 0; key < NUM_RESERVED; ++key) {
+        map[key] = to_value(key, 1);
+        if (map.capacity() != capacity) {
+            fail("growth while inserting the reserved number of entries", hash_name);
+            break;
+        }
+    }
+    check_layout(map, hash_name);
+    for (key = 0; key < NUM_RESERVED; ++key)
+        if (map.find(key) == nullptr || *map.find(key) != to_value(key, 1))
+            fail("lookup after reserving", hash_name);
+
+    // Reserving less than there is room for keeps the table
+    map.reserve(1);
+    if (map.capacity() != capacity)
+        fail("reserving less shrank the table", hash_name);
+
+    // Growing past the reserved space rehashes every entry
+    map[NUM_RESERVED * 2] = to_value(NUM_RESERVED * 2, 1);
+    while (map.capacity() == capacity)
+        map[map.size() + NUM_RESERVED * 2] = to_value(map.size(), 1);
+    check_layout(map, hash_name);
+    for (key = 0; key < NUM_RESERVED; ++key)
+        if (map.find(key) == nullptr || *map.find(key) != to_value(key, 1))
+            fail("lookup after growing past the reserved space", hash_name);
+}
+
+// Copies are deep and keep the layout; moving leaves the source empty but usable
+template <class Hash>
+static void test_copy_and_move(const char* hash_name) {
+    CheckedMap<Hash> map;
+    std::map<size_t, std::string> reference;
+    size_t key;
+
+    for (key = 0; key < KEY_RANGE; key += 3) {
+        map[key] = to_value(key, 2);
+        reference[key] = to_value(key, 2);
+    }
+
+    CheckedMap<Hash> copy(map);
+    check_layout(copy, hash_name);
+    check_contents(copy, reference, hash_name);
+    copy.erase(0);
+    copy[1] = to_value(1, 2);
+    check_contents(map, reference, hash_name);
+
+    copy = map;
+    check_layout(copy, hash_name);
+    check_contents(copy, reference, hash_name);
+
+    CheckedMap<Hash> moved(std::move(copy));
+    check_layout(moved, hash_name);
+    check_contents(moved, reference, hash_name);
+    if (!copy.empty() || copy.contains(3))
+        fail("source not empty after move construction", hash_name);
+    copy[7] = to_value(7, 2);
+    if (copy.size() != 1 || copy.find(7) == nullptr)
+        fail("source not usable after move construction", hash_name);
+
+    copy = std::move(moved);
+    check_layout(copy, hash_name);
+    check_contents(copy, reference, hash_name);
+    if (moved.contains(3))
+        fail("source holds entries after move assignment", hash_name);
+}
+
+template <class Hash>
+static void test_all(const char* hash_name) {
+    test_random<Hash>(hash_name);
+    test_reserve<Hash>(hash_name);
+    test_copy_and_move<Hash>(hash_name);
+}
+
+int main() {
+    test_all<FlatHash<size_t> >("FlatHash");
+    test_all<ClusterHash>("ClusterHash");
+    test_all<LastSlotHash>("LastSlotHash");
+    test_backward_shift();
+
+    if (s_num_failures == 0)
+        printf("passed\n");
+    else
+        printf("%u failures\n", s_num_failures);
+    return s_num_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Pins the behaviour of the ray and box slab tests: boxes are closed, so rays grazing a face, edge, or corner hit
+// them; a ray starting inside a box or with a zero vector containing its point hits it; flat boxes can be hit; and
+// cleared boxes never are. Every case is also checked with BoxPacket and RayPacket at every SIMD level, and with
+// single-precision boxes where the box converts exactly. Random rays and boxes, away from the boundaries, are compared
+// with the face-crossing test that the slab test replaced.
+
+#include "geom_ray.h"
+#include "geom_bounding_box.h"
+#include "geom_float.h"
+#include "cpu_features.h"
+
+#include <stdio.h>
+#include <random>
+
+using namespace Geom;
+
+static const unsigned int NUM_RANDOM_TRIALS = 200000;
+static const unsigned int NUM_PACKET_TRIALS = 20000;
+
+static unsigned int s_num_failures = 0;
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAILED line %d: %s\n", __LINE__, #condition); \
+            ++s_num_failures; \
+        } \
+    } while (0)
+
+// The test replaced by the slab test: crossings of the open faces, with near-zero components skipped. It differs on
+// the boundaries only.
+static bool intersects_ray_by_faces(const BoundingBox& box, const Vector3d& ray_point, const Vector3d& ray_vector) {
+    Vector3d v1(box.m_min - ray_point);
+    Vector3d v2(box.m_max - ray_point);
+    Vector3d point;
+    treal scale;
+    int i, j, k, side;
+
+    if (box.is_point_inside(ray_point)) return true;
+    for (i = 0; i < 3; ++i) {
+        j = (i + 1) % 3;
+        k = (i + 2) % 3;
+        if (fabs(ray_vector[i]) <= M_EPSILON) continue;
+        for (side = 0; side < 2; ++side) {
+            scale = (side == 0 ? v1[i] : v2[i]) / ray_vector[i];
+            if (scale <= 0.0) continue;
+            point = ray_point + ray_vector.scale(scale);
+            if (point[j] > box.m_min[j] && point[j] < box.m_max[j] && point[k] > box.m_min[k] && point[k] < box.m_max[k])
+                return true;
+        }
+    }
+    return false;
+}
+
+static bool is_exact_in_float(const BoundingBox& box) {
+    BoundingBox converted(BoundingBoxf(box).to_double());
+    return memcmp(&converted, &box, sizeof(BoundingBox)) == 0;
+}
+
+// Returns the result of the scalar test, after checking that all other paths agree with it
+static bool hits(const BoundingBox& box, const Vector3d& point, const Vector3d& vector) {
+    Ray ray(point, vector);
+    bool result = box.intersects_ray(ray);
+    unsigned int i, n, all_lanes;
+    int level;
+
+    for (level = CpuFeatures::SIMD_NONE; level <= CpuFeatures::SIMD_AVX512; ++level) {
+        CpuFeatures::set_simd_limit(static_cast<CpuFeatures::SimdLevel>(level));
+        for (n = 1; n <= BoxPacket::WIDTH; ++n) {
+            BoxPacket boxes;
+            RayPacket rays;
+            for (i = 0; i < n; ++i) {
+                boxes.add(box);
+                rays.add(ray);
+            }
+            all_lanes = (1u << n) - 1;
+            if (boxes.intersects(ray) != (result ? all_lanes : 0u) || rays.intersects(box) != (result ? all_lanes : 0u)) {
+                printf("FAILED packets of %u at SIMD level %d disagree with the scalar test\n", n, level);
+                ++s_num_failures;
+            }
+        }
+    }
+    CpuFeatures::set_simd_limit(CpuFeatures::SIMD_AVX512);
+
+    if (is_exact_in_float(box) && BoundingBoxf(box).intersects_ray(ray) != result) {
+        printf("FAILED BoundingBoxf disagrees with BoundingBox\n");
+        ++s_num_failures;
+    }
+    return result;
+}
+
+static void test_boundaries() {
+    BoundingBox box(Vector3d(0.0), Vector3d(1.0));
+    BoundingBox flat(Vector3d(0.0, 0.0, 0.5), Vector3d(1.0, 1.0, 0.5));
+    BoundingBox point(Vector3d(1.0, 2.0, 3.0), Vector3d(1.0, 2.0, 3.0));
+    BoundingBox cleared;
+
+    // Plain hits and misses
+    EXPECT(hits(box, Vector3d(-1.0, 0.5, 0.5), Vector3d(1.0, 0.0, 0.0)));
+    EXPECT(!hits(box, Vector3d(-1.0, 0.5, 0.5), Vector3d(-1.0, 0.0, 0.0)));
+    EXPECT(!hits(box, Vector3d(2.0, 0.5, 0.5), Vector3d(1.0, 0.0, 0.0)));
+    EXPECT(hits(box, Vector3d(0.5, 0.5, 0.5), Vector3d(1.0, 0.0, 0.0)));
+    EXPECT(hits(box, Vector3d(1.0, 0.5, 0.5), Vector3d(1.0, 0.0, 0.0))); // starting on a face, pointing away
+
+    // Zero vectors
+    EXPECT(hits(box, Vector3d(0.5, 0.5, 0.5), Vector3d(0.0)));
+    EXPECT(hits(box, Vector3d(1.0, 0.5, 0.5), Vector3d(0.0)));
+    EXPECT(hits(box, Vector3d(1.0, 1.0, 1.0), Vector3d(0.0)));
+    EXPECT(!hits(box, Vector3d(1.5, 0.5, 0.5), Vector3d(0.0)));
+    EXPECT(!hits(box, Vector3d(0.5, 0.5, 1.0000001), Vector3d(0.0)));
+
+    // Axis-parallel rays along faces and edges
+    EXPECT(hits(box, Vector3d(-1.0, 0.0, 0.5), Vector3d(1.0, 0.0, 0.0)));
+    EXPECT(hits(box, Vector3d(-1.0, 1.0, 0.5), Vector3d(1.0, 0.0, 0.0)));
+    EXPECT(hits(box, Vector3d(-1.0, 1.0, 1.0), Vector3d(1.0, 0.0, 0.0)));
+    EXPECT(hits(box, Vector3d(-1.0, 0.0, 0.0), Vector3d(1.0, 0.0, 0.0)));
+    EXPECT(hits(box, Vector3d(1.0, 1.0, -3.0), Vector3d(0.0, 0.0, 2.0)));
+    EXPECT(!hits(box, Vector3d(-1.0, 1.0000001, 0.5), Vector3d(1.0, 0.0, 0.0)));
+    EXPECT(!hits(box, Vector3d(-1.0, -1.0e-12, 0.5), Vector3d(1.0, 0.0, 0.0)));
+
+    // Negative zeros have reciprocals of negative infinity
+    EXPECT(hits(box, Vector3d(-1.0, 0.5, 0.5), Vector3d(1.0, -0.0, 0.0)));
+    EXPECT(hits(box, Vector3d(2.0, 0.0, 0.0), Vector3d(-1.0, -0.0, -0.0)));
+
+    // Diagonals grazing a corner and an edge
+    EXPECT(hits(box, Vector3d(-1.0, -1.0, -1.0), Vector3d(1.0, 1.0, 1.0)));
+    EXPECT(hits(box, Vector3d(2.0, -1.0, 0.5), Vector3d(-1.0, 1.0, 0.0)));
+    EXPECT(hits(box, Vector3d(2.0, 0.0, 0.5), Vector3d(-1.0, 1.0, 0.0)));
+    EXPECT(!hits(box, Vector3d(3.001, -1.0, 0.5), Vector3d(-1.0, 1.0, 0.0)));
+
+    // Tiny and denormal components
+    EXPECT(hits(box, Vector3d(-1.0, 0.5, 0.5), Vector3d(1.0, 1.0e-300, -1.0e-310)));
+    EXPECT(!hits(box, Vector3d(-1.0, 1.5, 0.5), Vector3d(1.0, 1.0e-300, 0.0)));
+    EXPECT(!hits(box, Vector3d(0.5, 1.5, 0.5), Vector3d(1.0e-300)));
+
+    // Flat boxes, including a single point
+    EXPECT(hits(flat, Vector3d(0.5, 0.5, 2.0), Vector3d(0.0, 0.0, -1.0)));
+    EXPECT(hits(flat, Vector3d(-1.0, 0.5, 0.5), Vector3d(1.0, 0.0, 0.0)));
+    EXPECT(!hits(flat, Vector3d(-1.0, 0.5, 0.6), Vector3d(1.0, 0.0, 0.0)));
+    EXPECT(hits(point, Vector3d(0.0), Vector3d(1.0, 2.0, 3.0)));
+    EXPECT(hits(point, Vector3d(1.0, 2.0, 3.0), Vector3d(0.0)));
+
+    // Cleared boxes
+    EXPECT(!hits(cleared, Vector3d(0.0), Vector3d(1.0, 1.0, 1.0)));
+    EXPECT(!hits(cleared, Vector3d(0.0), Vector3d(0.0)));
+}
+
+static void test_random(std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> coord(-3.0, 3.0);
+    unsigned int i, num_differ = 0;
+
+    for (i = 0; i < NUM_RANDOM_TRIALS; ++i) {
+        BoundingBox box;
+        box.add(Vector3d(coord(rng), coord(rng), coord(rng)));
+        box.add(Vector3d(coord(rng), coord(rng), coord(rng)));
+        Vector3d point(coord(rng), coord(rng), coord(rng));
+        Vector3d vector(coord(rng), coord(rng), coord(rng));
+        if (i % 4 == 0)
+            vector[i % 3] = 0.0; // axis-parallel in one plane
+        if (hits(box, point, vector) != intersects_ray_by_faces(box, point, vector))
+            ++num_differ;
+    }
+
+    if (num_differ != 0) {
+        printf("FAILED %u of %u random rays differ from the face-crossing test\n", num_differ, NUM_RANDOM_TRIALS);
+        ++s_num_failures;
+    }
+}
+
+// Packets whose lanes hold different boxes or rays, against the scalar test of each lane
+static void test_packet_lanes(std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> coord(-3.0, 3.0);
+    unsigned int i, j, size, expected_boxes, expected_rays;
+    int level;
+
+    for (i = 0; i < NUM_PACKET_TRIALS; ++i) {
+        BoxPacket boxes;
+        RayPacket rays;
+        BoundingBox box;
+        BoundingBox lane_box;
+        Ray lane_ray;
+        Ray ray(Vector3d(coord(rng), coord(rng), coord(rng)), Vector3d(coord(rng), coord(rng), coord(rng)));
+        box.add(Vector3d(coord(rng), coord(rng), coord(rng)));
+        box.add(Vector3d(coord(rng), coord(rng), coord(rng)));
+        size = 1 + i % BoxPacket::WIDTH;
+        expected_boxes = 0;
+        expected_rays = 0;
+
+        for (j = 0; j < size; ++j) {
+            lane_box.clear();
+            lane_box.add(Vector3d(coord(rng), coord(rng), coord(rng)));
+            lane_box.add(Vector3d(coord(rng), coord(rng), coord(rng)));
+            boxes.add(lane_box);
+            if (lane_box.intersects_ray(ray))
+                expected_boxes |= 1u << j;
+
+            lane_ray.set(Vector3d(coord(rng), coord(rng), coord(rng)), Vector3d(coord(rng), coord(rng), coord(rng)));
+            rays.add(lane_ray);
+            if (box.intersects_ray(lane_ray))
+                expected_rays |= 1u << j;
+        }
+        if (size == BoxPacket::WIDTH) {
+            BoxPacket full_boxes(boxes);
+            RayPacket full_rays(rays);
+            EXPECT(!full_boxes.add(box));
+            EXPECT(!full_rays.add(ray));
+        }
+
+        for (level = CpuFeatures::SIMD_NONE; level <= CpuFeatures::SIMD_AVX512; ++level) {
+            CpuFeatures::set_simd_limit(static_cast<CpuFeatures::SimdLevel>(level));
+            if (boxes.intersects(ray) != expected_boxes || rays.intersects(box) != expected_rays) {
+                printf("FAILED packet of %u distinct lanes at SIMD level %d\n", size, level);
+                ++s_num_failures;
+            }
+        }
+        CpuFeatures::set_simd_limit(CpuFeatures::SIMD_AVX512);
+    }
+}
+
+int main() {
+    std::mt19937_64 rng(7);
+
+    test_boundaries();
+    test_random(rng);
+    test_packet_lanes(rng);
+
+    if (s_num_failures == 0)
+        printf("passed\n");
+    else
+        printf("%u failures\n", s_num_failures);
+    return s_num_failures == 0 ? 0 : 1;
+}
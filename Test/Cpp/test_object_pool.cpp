@@ -0,0 +1,212 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Checks ObjectPool: blocks of every size class are aligned and do not overlap, blocks freed on another thread than the
+// one that allocated them are recycled intact, a thread that exits hands its cached blocks back to the shared lists,
+// and the statistics count every request, including those of threads that have exited. Build it with
+// -fsanitize=thread and with -fsanitize=address as well; the pool itself has no race or overflow checks.
+
+#include "object_pool.h"
+#include "mpmc_queue.h"
+
+#include <set>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+static const size_t NUM_BLOCKS_PER_SIZE = 100;
+static const unsigned int NUM_PRODUCERS = 2;
+static const unsigned int NUM_CONSUMERS = 2;
+static const unsigned int NUM_RECORDS = 100000; // per producer
+static const size_t EXIT_BLOCK_SIZE = 200; // a size class no other check uses
+static const size_t NUM_EXIT_BLOCKS = 20; // few enough that the exiting thread keeps them all in its cache
+
+static unsigned int s_num_failures = 0;
+
+struct Record {
+    unsigned int m_producer;
+    unsigned int m_index;
+    unsigned int m_check; // derived from the other two
+};
+
+static void fail(const char* what) {
+    if (s_num_failures < 20)
+        printf("FAILED %s\n", what);
+    ++s_num_failures;
+}
+
+static unsigned long long get_num_requests(const ObjectPool::Stats& stats) {
+    return stats.m_num_hits + stats.m_num_misses + stats.m_num_large;
+}
+
+// Every block holds its own pattern until it is freed, so overlapping blocks would overwrite each other
+static void test_sizes() {
+    std::vector<unsigned char*> blocks;
+    size_t size, i, j;
+    unsigned char pattern;
+
+    for (size = 1; size <= ObjectPool::MAX_SIZE + 64; ++size) {
+        for (i = 0; i < NUM_BLOCKS_PER_SIZE; ++i) {
+            unsigned char* block = reinterpret_cast<unsigned char*>(ObjectPool::allocate(size));
+            if (reinterpret_cast<size_t>(block) % ObjectPool::SIZE_CLASS_STEP != 0)
+                fail("block alignment");
+            memset(block, static_cast<int>(blocks.size() & 0xFF), size);
+            blocks.push_back(block);
+        }
+    }
+
+    j = 0;
+    for (size = 1; size <= ObjectPool::MAX_SIZE + 64; ++size) {
+        for (i = 0; i < NUM_BLOCKS_PER_SIZE; ++i, ++j) {
+            pattern = static_cast<unsigned char>(j & 0xFF);
+            if (blocks[j][0] != pattern || blocks[j][size - 1] != pattern)
+                fail("block contents overwritten");
+            ObjectPool::deallocate(blocks[j], size);
+        }
+    }
+}
+
+// Producers create records and pass them to consumers, which check and destroy them, so nearly every block is freed
+// on another thread than the one that allocated it
+static void test_cross_thread_free() {
+    MpmcQueue<Record*> queue(1024);
+    std::vector<std::thread> threads;
+    std::atomic<unsigned int> num_left(NUM_PRODUCERS * NUM_RECORDS);
+    std::atomic<unsigned int> num_corrupt(0);
+    unsigned int i;
+
+    for (i = 0; i < NUM_PRODUCERS; ++i) {
+        threads.push_back(std::thread([&queue, i]() {
+            for (unsigned int index = 0; index < NUM_RECORDS; ++index) {
+                Record* record = ObjectPool::create<Record>();
+                record->m_producer = i;
+                record->m_index = index;
+                record->m_check = i * 0x9E3779B9U ^ index;
+                queue.enqueue(record);
+            }
+        }));
+    }
+    for (i = 0; i < NUM_CONSUMERS; ++i) {
+        threads.push_back(std::thread([&queue, &num_left, &num_corrupt]() {
+            Record* record;
+            while (num_left.load(std::memory_order_relaxed) != 0) {
+                if (!queue.try_dequeue(record)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (record->m_check != (record->m_producer * 0x9E3779B9U ^ record->m_index))
+                    num_corrupt.fetch_add(1, std::memory_order_relaxed);
+                ObjectPool::destroy(record);
+                num_left.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }));
+    }
+    for (i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    if (num_corrupt.load() != 0)
+        fail("records corrupted while passed between threads");
+}
+
+// The blocks freed by a thread that exits without flushing must be the next ones handed out for their size class;
+// the shared lists are last in, first out
+static void test_thread_exit_flush() {
+    std::set<void*> freed;
+    ObjectPool::Stats before, after;
+    size_t i, num_found = 0;
+
+    ObjectPool::flush_thread_cache();
+
+    std::thread thread([&freed]() {
+        void* blocks[NUM_EXIT_BLOCKS];
+        size_t j;
+        for (j = 0; j < NUM_EXIT_BLOCKS; ++j)
+            blocks[j] = ObjectPool::allocate(EXIT_BLOCK_SIZE);
+        for (j = 0; j < NUM_EXIT_BLOCKS; ++j) {
+            freed.insert(blocks[j]);
+            ObjectPool::deallocate(blocks[j], EXIT_BLOCK_SIZE);
+        }
+    });
+    thread.join();
+
+    ObjectPool::get_stats(before);
+    std::vector<void*> blocks;
+    for (i = 0; i < ObjectPool::BATCH_SIZE + 1; ++i) {
+        blocks.push_back(ObjectPool::allocate(EXIT_BLOCK_SIZE));
+        if (freed.count(blocks.back()) != 0)
+            ++num_found;
+    }
+    ObjectPool::get_stats(after);
+
+    if (num_found != NUM_EXIT_BLOCKS)
+        fail("blocks cached by an exited thread were not handed back");
+    if (after.m_resident_bytes != before.m_resident_bytes)
+        fail("a new slab was carved although an exited thread left free blocks");
+
+    for (i = 0; i < blocks.size(); ++i)
+        ObjectPool::deallocate(blocks[i], EXIT_BLOCK_SIZE);
+}
+
+// Counts are exact once the threads that made the requests have exited
+static void test_stats() {
+    ObjectPool::Stats before, after;
+    unsigned long long num_requests;
+
+    ObjectPool::get_stats(before);
+    std::thread thread([]() {
+        void* small = ObjectPool::allocate(16);
+        void* large = ObjectPool::allocate(ObjectPool::MAX_SIZE + 1);
+        ObjectPool::deallocate(small, 16);
+        ObjectPool::deallocate(large, ObjectPool::MAX_SIZE + 1);
+
+        // The second request for the size class comes from the thread's own list
+        ObjectPool::Stats own_before, own_after;
+        ObjectPool::get_stats(own_before);
+        small = ObjectPool::allocate(16);
+        ObjectPool::get_stats(own_after);
+        ObjectPool::deallocate(small, 16);
+        if (own_after.m_num_hits != own_before.m_num_hits + 1 || own_after.m_num_misses != own_before.m_num_misses)
+            fail("a request served from the thread's own list was not counted as a hit");
+
+        // Only published when the thread exits
+        ObjectPool::deallocate(ObjectPool::allocate(16), 16);
+    });
+    thread.join();
+    ObjectPool::get_stats(after);
+
+    num_requests = get_num_requests(after) - get_num_requests(before);
+    if (num_requests != 4)
+        fail("requests of an exited thread not counted");
+    if (after.m_num_large != before.m_num_large + 1)
+        fail("large request not counted");
+    if (after.m_num_misses <= before.m_num_misses)
+        fail("the first request of a thread was not counted as a miss");
+    if (after.m_resident_bytes == 0 || after.m_resident_bytes % ObjectPool::SLAB_SIZE != 0)
+        fail("resident bytes are not a whole number of slabs");
+}
+
+int main() {
+    ObjectPool::Stats before, after;
+
+    ObjectPool::get_stats(before);
+    test_sizes();
+    test_cross_thread_free();
+    test_thread_exit_flush();
+    test_stats();
+    ObjectPool::get_stats(after);
+
+    printf("%llu requests: %llu hits, %llu misses, %llu large; %zu bytes resident\n",
+        get_num_requests(after) - get_num_requests(before), after.m_num_hits - before.m_num_hits,
+        after.m_num_misses - before.m_num_misses, after.m_num_large - before.m_num_large, after.m_resident_bytes);
+
+    if (s_num_failures == 0)
+        printf("passed\n");
+    else
+        printf("%u failures\n", s_num_failures);
+    return s_num_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Checks the batch operations of Geom::PointArray against plain loops over an array of Vector3d, for every size up to
+// several SIMD vectors past a lane padding and for larger odd sizes, so that every remainder after the vector loops is
+// covered. All points lie away from the origin, so the zero padding past the size would show up in the bounds and in
+// a nearest search from the origin if it were included. The padding must also stay zero after each operation.
+
+#include "geom_point_array.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Geom;
+
+static const size_t MAX_SIZE = 100;
+static const size_t LARGE_SIZES[] = { 1001, 4099, 65537 };
+static const double MAX_RELATIVE_DIFF = 1.0e-12;
+
+static unsigned int s_num_failures = 0;
+
+static double random_coord() {
+    return 10.0 + static_cast<double>(rand()) / static_cast<double>(RAND_MAX) * 90.0;
+}
+
+static Vector3d random_point() {
+    return Vector3d(random_coord(), random_coord(), random_coord());
+}
+
+static void fail(const char* what, size_t size) {
+    if (s_num_failures < 20)
+        printf("FAILED %s, size %zu\n", what, size);
+    ++s_num_failures;
+}
+
+static bool is_close(const Vector3d& a, const Vector3d& b) {
+    double scale = b.get_length() > 1.0 ? b.get_length() : 1.0;
+    return (a - b).get_length() <= MAX_RELATIVE_DIFF * scale;
+}
+
+static bool is_padding_zero(const PointArray& points) {
+    for (size_t i = points.size(); i < points.capacity(); ++i) {
+        if (points.get_xs()[i] != 0.0 || points.get_ys()[i] != 0.0 || points.get_zs()[i] != 0.0)
+            return false;
+    }
+    return true;
+}
+
+static size_t find_nearest_aos(const DynamicArray<Vector3d>& points, const Vector3d& point, double& dist_sq_out) {
+    size_t i, best_index = points.size();
+    double dist_sq;
+    dist_sq_out = 0.0;
+    for (i = 0; i < points.size(); ++i) {
+        Vector3d d(points[i] - point);
+        dist_sq = d.dot(d);
+        if (best_index == points.size() || dist_sq < dist_sq_out) {
+            dist_sq_out = dist_sq;
+            best_index = i;
+        }
+    }
+    return best_index;
+}
+
+static void test_nearest(const PointArray& soa, const DynamicArray<Vector3d>& aos, const Vector3d& point, const char* what) {
+    size_t expected_index, index;
+    double expected_dist_sq;
+    treal dist_sq = -1.0;
+
+    expected_index = find_nearest_aos(aos, point, expected_dist_sq);
+    index = soa.find_nearest(point, &dist_sq);
+    if (index != expected_index || (index != aos.size() && dist_sq != expected_dist_sq))
+        fail(what, aos.size());
+}
+
+static void test_size(size_t size, const Transformation& tra, PointArray& reused_out) {
+    DynamicArray<Vector3d> aos;
+    DynamicArray<Vector3d> copied;
+    BoundingBox expected_bb, bb;
+    Vector3d expected_centroid(0.0), centroid;
+    size_t i;
+
+    for (i = 0; i < size; ++i)
+        aos.append(random_point());
+    // A duplicate of an earlier point, so the nearest search from it must return the first of a tie
+    if (size > 3)
+        aos[size - 1] = aos[size / 2];
+
+    PointArray soa(aos);
+    if (soa.size() != size || soa.capacity() % PointArray::LANE_PADDING != 0 || !is_padding_zero(soa))
+        fail("construction", size);
+    for (i = 0; i < size; ++i) {
+        if (soa.get_at(i) != aos[i]) {
+            fail("get_at", size);
+            break;
+        }
+    }
+    soa.copy_to(copied);
+    if (copied.size() != size || (size != 0 && memcmp(copied.pat(0), aos.pat(0), sizeof(Vector3d) * size) != 0))
+        fail("copy_to", size);
+
+    // Transform into a fresh array, into one that held more points before, and in place
+    PointArray out;
+    soa.transform(tra, out);
+    soa.transform(tra, reused_out);
+    PointArray in_place(soa);
+    in_place.transform_self(tra);
+    if (out.size() != size || reused_out.size() != size || in_place.size() != size)
+        fail("transform size", size);
+    for (i = 0; i < size; ++i) {
+        Vector3d expected(tra.transform_vector(aos[i]));
+        if (!is_close(out.get_at(i), expected) || reused_out.get_at(i) != out.get_at(i) || in_place.get_at(i) != out.get_at(i)) {
+            fail("transform", size);
+            break;
+        }
+    }
+    if (!is_padding_zero(out) || !is_padding_zero(reused_out) || !is_padding_zero(in_place))
+        fail("transform padding", size);
+
+    // The SIMD minimum and maximum are exact, so the bounds must match bit for bit
+    for (i = 0; i < size; ++i)
+        expected_bb.add(aos[i]);
+    soa.get_bounding_box(bb);
+    if (size == 0 ? !bb.is_invalid() : (bb.m_min != expected_bb.m_min || bb.m_max != expected_bb.m_max))
+        fail("get_bounding_box", size);
+
+    for (i = 0; i < size; ++i)
+        expected_centroid += aos[i];
+    if (size != 0)
+        expected_centroid.scale_self(1.0 / static_cast<double>(size));
+    soa.get_centroid(centroid);
+    if (!is_close(centroid, expected_centroid))
+        fail("get_centroid", size);
+
+    test_nearest(soa, aos, Vector3d::ORIGIN, "find_nearest from the origin");
+    test_nearest(soa, aos, random_point(), "find_nearest from a random point");
+    if (size != 0)
+        test_nearest(soa, aos, aos[size - 1], "find_nearest from a duplicate point");
+
+    // Shrinking restores the padding
+    soa.resize(size / 2);
+    if (!is_padding_zero(soa))
+        fail("resize padding", size);
+}
+
+// Appending past the capacity and moving keep the lanes aligned and the contents intact
+static void test_growth() {
+    PointArray points;
+    size_t i;
+
+    for (i = 0; i < 1000; ++i)
+        points.append(Vector3d(static_cast<double>(i), 1.0, 2.0));
+    if (reinterpret_cast<size_t>(points.get_ys()) % PointArray::ALIGNMENT != 0 ||
+        reinterpret_cast<size_t>(points.get_zs()) % PointArray::ALIGNMENT != 0)
+        fail("lane alignment after growth", points.size());
+    for (i = 0; i < 1000; ++i) {
+        if (points.get_at(i) != Vector3d(static_cast<double>(i), 1.0, 2.0)) {
+            fail("contents after growth", points.size());
+            break;
+        }
+    }
+    if (!is_padding_zero(points))
+        fail("padding after growth", points.size());
+
+    PointArray moved(std::move(points));
+    if (moved.size() != 1000 || points.size() != 0 || !is_padding_zero(points))
+        fail("move construction", moved.size());
+    points = std::move(moved);
+    if (points.size() != 1000 || moved.size() != 0 || !is_padding_zero(moved))
+        fail("move assignment", points.size());
+}
+
+int main() {
+    size_t size, i;
+
+    srand(1);
+    // A rotation with a scale, a translation, and a w factor on the origin
+    Vector3d axis(0.3, -0.5, 0.8);
+    axis.normalize_self();
+    Transformation tra(Transformation::rotate(axis, 0.7));
+    tra.m_xaxis.m_x *= 3.0;
+    tra.m_origin = Vector4d(12.0, -7.0, 3.5, 2.0);
+
+    PointArray reused_out;
+    for (i = 0; i < MAX_SIZE * 4; ++i)
+        reused_out.append(random_point());
+
+    for (size = 0; size <= MAX_SIZE; ++size)
+        test_size(size, tra, reused_out);
+    for (i = 0; i < sizeof(LARGE_SIZES) / sizeof(LARGE_SIZES[0]); ++i)
+        test_size(LARGE_SIZES[i], tra, reused_out);
+    test_growth();
+
+    if (s_num_failures == 0)
+        printf("passed\n");
+    else
+        printf("%u failures\n", s_num_failures);
+    return s_num_failures == 0 ? 0 : 1;
+}
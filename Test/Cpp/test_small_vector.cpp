@@ -0,0 +1,239 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Checks SmallVector across its storage paths: filling the inline space, spilling to the heap and growing further,
+// and copying and moving between every combination of inline and spilled vectors. Each case runs with a trivially
+// copyable item, which is moved with memcpy and realloc, and with an item that counts its live instances, so that
+// every constructed item must be destroyed exactly once.
+
+#include "small_vector.h"
+
+#include <stdio.h>
+
+static const size_t INLINE_COUNT = 4;
+
+static unsigned int s_num_failures = 0;
+static int s_num_live = 0;
+
+// Destruction poisons the value, so a destroyed item that is read again shows up as a wrong value
+class Tracked {
+private:
+    int m_value;
+
+public:
+    Tracked() : m_value(0) {
+        ++s_num_live;
+    }
+
+    Tracked(int value) : m_value(value) {
+        ++s_num_live;
+    }
+
+    Tracked(const Tracked& other) : m_value(other.m_value) {
+        ++s_num_live;
+    }
+
+    Tracked(Tracked&& other) : m_value(other.m_value) {
+        other.m_value = -1;
+        ++s_num_live;
+    }
+
+    Tracked& operator=(const Tracked& other) {
+        m_value = other.m_value;
+        return *this;
+    }
+
+    Tracked& operator=(Tracked&& other) {
+        m_value = other.m_value;
+        other.m_value = -1;
+        return *this;
+    }
+
+    ~Tracked() {
+        m_value = -2;
+        --s_num_live;
+    }
+
+    int get_value() const {
+        return m_value;
+    }
+};
+
+static int get_value(int item) {
+    return item;
+}
+
+static int get_value(const Tracked& item) {
+    return item.get_value();
+}
+
+static void fail(const char* what, const char* type_name, size_t count) {
+    if (s_num_failures < 20)
+        printf("FAILED %s, %s, %zu items\n", what, type_name, count);
+    ++s_num_failures;
+}
+
+// The items hold first, first + 1, and so on
+template <class T>
+static bool has_sequence(const SmallVector<T, INLINE_COUNT>& vector, size_t count, int first) {
+    if (vector.size() != count) return false;
+    for (size_t i = 0; i < count; ++i) {
+        if (get_value(vector[i]) != first + static_cast<int>(i))
+            return false;
+    }
+    return true;
+}
+
+template <class T>
+static void fill(SmallVector<T, INLINE_COUNT>& vector, size_t count, int first) {
+    vector.clear();
+    for (size_t i = 0; i < count; ++i)
+        vector.append(T(first + static_cast<int>(i)));
+}
+
+// Appending stays inline up to INLINE_COUNT items, then spills, keeping the items through every growth
+template <class T>
+static void test_spill(const char* type_name) {
+    SmallVector<T, INLINE_COUNT> vector;
+    size_t count;
+
+    for (count = 1; count <= INLINE_COUNT * 8 + 1; ++count) {
+        if (count % 2 != 0)
+            vector.append(T(static_cast<int>(count) - 1));
+        else
+            vector.emplace_back(static_cast<int>(count) - 1);
+        if (vector.is_inline() != (count <= INLINE_COUNT) || vector.capacity() < count)
+            fail("inline state while appending", type_name, count);
+        if (!has_sequence(vector, count, 0))
+            fail("contents while appending", type_name, count);
+    }
+
+    // Clearing keeps the heap space, and resetting returns to the inline space
+    vector.clear();
+    if (vector.is_inline() || !vector.empty())
+        fail("clear", type_name, vector.size());
+    vector.reset();
+    if (!vector.is_inline() || vector.capacity() != INLINE_COUNT)
+        fail("reset", type_name, vector.size());
+
+    // Reserving and resizing past the inline space spill as well
+    fill(vector, 3, 10);
+    vector.reserve(INLINE_COUNT + 1);
+    if (vector.is_inline() || !has_sequence(vector, 3, 10))
+        fail("reserve", type_name, 3);
+    vector.reset();
+    fill(vector, 3, 10);
+    vector.resize(INLINE_COUNT * 3);
+    if (vector.is_inline() || vector.size() != INLINE_COUNT * 3 || get_value(vector[2]) != 12)
+        fail("resize up", type_name, INLINE_COUNT * 3);
+    vector.resize(2);
+    if (!has_sequence(vector, 2, 10))
+        fail("resize down", type_name, 2);
+
+    // Popping and removing
+    fill(vector, INLINE_COUNT * 2, 0);
+    if (get_value(vector.pop()) != static_cast<int>(INLINE_COUNT) * 2 - 1 || vector.size() != INLINE_COUNT * 2 - 1)
+        fail("pop", type_name, vector.size());
+    vector.remove_at(0);
+    if (get_value(vector[0]) != static_cast<int>(INLINE_COUNT) * 2 - 2 || vector.size() != INLINE_COUNT * 2 - 2)
+        fail("remove_at", type_name, vector.size());
+    vector.remove_at(vector.size() - 1);
+    if (get_value(vector.last()) != static_cast<int>(INLINE_COUNT) * 2 - 4)
+        fail("remove_at the last item", type_name, vector.size());
+}
+
+// Copies are deep and leave the source as it was, whichever storage either side uses
+template <class T>
+static void test_copy(const char* type_name) {
+    static const size_t COUNTS[] = { 0, 2, INLINE_COUNT, INLINE_COUNT + 1, INLINE_COUNT * 4 };
+    size_t i, j;
+
+    for (i = 0; i < sizeof(COUNTS) / sizeof(COUNTS[0]); ++i) {
+        SmallVector<T, INLINE_COUNT> source;
+        fill(source, COUNTS[i], 100);
+
+        SmallVector<T, INLINE_COUNT> constructed(source);
+        if (!has_sequence(constructed, COUNTS[i], 100) || !has_sequence(source, COUNTS[i], 100) ||
+            (COUNTS[i] != 0 && constructed.pat(0) == source.pat(0)))
+            fail("copy construction", type_name, COUNTS[i]);
+
+        for (j = 0; j < sizeof(COUNTS) / sizeof(COUNTS[0]); ++j) {
+            SmallVector<T, INLINE_COUNT> assigned;
+            fill(assigned, COUNTS[j], 200);
+            assigned = source;
+            if (!has_sequence(assigned, COUNTS[i], 100) || !has_sequence(source, COUNTS[i], 100))
+                fail("copy assignment", type_name, COUNTS[i]);
+        }
+
+        SmallVector<T, INLINE_COUNT>& alias = source;
+        source = alias;
+        if (!has_sequence(source, COUNTS[i], 100))
+            fail("copy assignment to itself", type_name, COUNTS[i]);
+    }
+}
+
+// Moving hands spilled heap space over as is and relocates inline items; the source ends up empty and inline
+template <class T>
+static void test_move(const char* type_name) {
+    static const size_t COUNTS[] = { 0, 2, INLINE_COUNT, INLINE_COUNT + 1, INLINE_COUNT * 4 };
+    size_t i, j;
+    T* data;
+
+    for (i = 0; i < sizeof(COUNTS) / sizeof(COUNTS[0]); ++i) {
+        SmallVector<T, INLINE_COUNT> source;
+        fill(source, COUNTS[i], 100);
+        data = source.pat(0);
+
+        SmallVector<T, INLINE_COUNT> constructed(std::move(source));
+        if (!has_sequence(constructed, COUNTS[i], 100) || !source.empty() || !source.is_inline())
+            fail("move construction", type_name, COUNTS[i]);
+        if (constructed.is_inline() != (COUNTS[i] <= INLINE_COUNT) || (!constructed.is_inline() && constructed.pat(0) != data))
+            fail("move construction storage", type_name, COUNTS[i]);
+
+        // The source stays usable
+        fill(source, 3, 7);
+        if (!has_sequence(source, 3, 7))
+            fail("reuse after move construction", type_name, COUNTS[i]);
+
+        for (j = 0; j < sizeof(COUNTS) / sizeof(COUNTS[0]); ++j) {
+            SmallVector<T, INLINE_COUNT> moved;
+            SmallVector<T, INLINE_COUNT> assigned;
+            fill(moved, COUNTS[i], 300);
+            fill(assigned, COUNTS[j], 400);
+            data = moved.pat(0);
+            assigned = std::move(moved);
+            if (!has_sequence(assigned, COUNTS[i], 300) || !moved.empty() || !moved.is_inline())
+                fail("move assignment", type_name, COUNTS[i]);
+            if (!assigned.is_inline() && assigned.pat(0) != data)
+                fail("move assignment storage", type_name, COUNTS[i]);
+        }
+    }
+}
+
+template <class T>
+static void test_all(const char* type_name) {
+    test_spill<T>(type_name);
+    test_copy<T>(type_name);
+    test_move<T>(type_name);
+}
+
+int main() {
+    test_all<int>("int");
+    test_all<Tracked>("Tracked");
+
+    if (s_num_live != 0) {
+        printf("FAILED %d Tracked items were not destroyed exactly once\n", s_num_live);
+        ++s_num_failures;
+    }
+
+    if (s_num_failures == 0)
+        printf("passed\n");
+    else
+        printf("%u failures\n", s_num_failures);
+    return s_num_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Checks that resizing a ThreadHive settles on the requested number of live bees, in both modes. Shrinking wakes
+// every sleeping bee at once, and all surplus bees race to retire, so the hive is shrunk many times over; after each
+// resize, tasks must still run.
+
+#include "thread_hive.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+
+static const unsigned int NUM_ROUNDS = 100;
+static const unsigned int NUM_TASKS = 1000;
+static const unsigned int SETTLE_TIME = 2000; // in milliseconds; the longest to wait for bees to exit
+
+static const char* const MODE_NAMES[] = { "shared queue", "work stealing" };
+
+static unsigned int s_num_failures = 0;
+static std::atomic<unsigned int> s_num_done(0);
+
+static void count_task(void* user_data, ThreadHive* hive) {
+    s_num_done.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Waits for the surplus bees to exit, then for any further bee to wrongly follow them
+static unsigned int settle(ThreadHive& hive, unsigned int num_bees) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (hive.get_num_live_bees() > num_bees &&
+        std::chrono::steady_clock::now() - start < std::chrono::milliseconds(SETTLE_TIME))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return hive.get_num_live_bees();
+}
+
+static bool run_tasks(ThreadHive& hive) {
+    unsigned int i;
+    s_num_done.store(0);
+    for (i = 0; i < NUM_TASKS; ++i)
+        hive.enqueue(count_task, nullptr);
+    hive.wait_until_finished();
+    return s_num_done.load() == NUM_TASKS;
+}
+
+static void expect_live(ThreadHive& hive, unsigned int num_bees, ThreadHive::Mode mode, unsigned int round) {
+    unsigned int num_live = settle(hive, num_bees);
+    if (num_live != num_bees) {
+        printf("FAILED %s, round %u: %u live bees instead of %u\n", MODE_NAMES[mode], round, num_live, num_bees);
+        ++s_num_failures;
+    }
+    if (!run_tasks(hive)) {
+        printf("FAILED %s, round %u: tasks lost after resizing to %u bees\n", MODE_NAMES[mode], round, num_bees);
+        ++s_num_failures;
+    }
+}
+
+static void test_resize(ThreadHive::Mode mode) {
+    unsigned int round;
+
+    for (round = 0; round < NUM_ROUNDS && s_num_failures < 10; ++round) {
+        ThreadHive hive(16, mode, 0);
+        hive.set_num_bees(8);
+        expect_live(hive, 8, mode, round);
+        hive.set_num_bees(1);
+        expect_live(hive, 1, mode, round);
+        hive.set_num_bees(16);
+        expect_live(hive, 16, mode, round);
+    }
+}
+
+int main() {
+    test_resize(ThreadHive::MODE_SHARED_QUEUE);
+    test_resize(ThreadHive::MODE_WORK_STEALING);
+
+    if (s_num_failures == 0)
+        printf("passed\n");
+    else
+        printf("%u failures\n", s_num_failures);
+    return s_num_failures == 0 ? 0 : 1;
+}
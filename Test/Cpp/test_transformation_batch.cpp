@@ -0,0 +1,130 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Checks that the batch transforms of Geom::Transformation give bit for bit the results of the single-vector
+// functions at every SIMD level, for counts that leave every possible remainder after the vector loops, without
+// writing past the end of the output, and in place.
+
+#include "geom_transformation.h"
+#include "cpu_features.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace Geom;
+
+static const unsigned int NUM_TRIALS = 200;
+static const size_t MAX_COUNT = 36;
+
+static const char* const LEVEL_NAMES[] = { "none", "SSE2", "AVX", "AVX2", "AVX-512" };
+
+static unsigned int s_num_failures = 0;
+
+static double random_coord() {
+    return static_cast<double>(rand()) / static_cast<double>(RAND_MAX) * 200.0 - 100.0;
+}
+
+static Vector3d random_vector() {
+    return Vector3d(random_coord(), random_coord(), random_coord());
+}
+
+static void expect_same(const Vector3d& result, const Vector3d& expected, const char* function, int level, size_t count) {
+    if (memcmp(&result, &expected, sizeof(Vector3d)) != 0) {
+        if (s_num_failures < 10)
+            printf("FAILED %s at %s, count %zu: (%.17g, %.17g, %.17g) instead of (%.17g, %.17g, %.17g)\n",
+                function, LEVEL_NAMES[level], count, result.m_x, result.m_y, result.m_z, expected.m_x, expected.m_y, expected.m_z);
+        ++s_num_failures;
+    }
+}
+
+static void expect_untouched(const Vector3d& guard, const char* function, int level, size_t count) {
+    if (guard.m_x != 7.0 || guard.m_y != 7.0 || guard.m_z != 7.0) {
+        printf("FAILED %s at %s, count %zu: wrote past the end of the output\n", function, LEVEL_NAMES[level], count);
+        ++s_num_failures;
+    }
+}
+
+static void test_batch(const Transformation& t, size_t count) {
+    std::vector<Vector3d> input(count);
+    std::vector<Vector3d> output(count + 1); // with a guard item after the last one
+    std::vector<Vector3d> in_place;
+    size_t i;
+    int level;
+
+    for (i = 0; i < count; ++i)
+        input[i] = random_vector();
+
+    for (level = CpuFeatures::SIMD_NONE; level <= CpuFeatures::SIMD_AVX512; ++level) {
+        CpuFeatures::set_simd_limit(static_cast<CpuFeatures::SimdLevel>(level));
+
+        output[count] = Vector3d(7.0);
+        t.transform_points(input.data(), output.data(), count);
+        for (i = 0; i < count; ++i)
+            expect_same(output[i], t.transform_vector(input[i]), "transform_points", level, count);
+        expect_untouched(output[count], "transform_points", level, count);
+
+        t.rotate_vectors(input.data(), output.data(), count);
+        for (i = 0; i < count; ++i)
+            expect_same(output[i], t.rotate_vector(input[i]), "rotate_vectors", level, count);
+        expect_untouched(output[count], "rotate_vectors", level, count);
+
+        t.transform_normals(input.data(), output.data(), count);
+        for (i = 0; i < count; ++i)
+            expect_same(output[i], t.transform_normal(input[i]), "transform_normals", level, count);
+        expect_untouched(output[count], "transform_normals", level, count);
+
+        in_place = input;
+        t.transform_points(in_place.data(), in_place.data(), count);
+        for (i = 0; i < count; ++i)
+            expect_same(in_place[i], t.transform_vector(input[i]), "transform_points in place", level, count);
+    }
+
+    CpuFeatures::set_simd_limit(CpuFeatures::SIMD_AVX512);
+}
+
+// A normal transformed by transform_normal stays perpendicular to the transformed surface
+static void test_normal_perpendicular(const Transformation& t) {
+    Vector3d a(random_vector());
+    Vector3d b(random_vector());
+    Vector3d normal(t.transform_normal(a.cross(b)));
+    double dot = normal.normalize().dot(t.rotate_vector(a).normalize());
+    if (fabs(dot) > 1.0e-9) {
+        printf("FAILED transform_normal: %.3g off perpendicular\n", dot);
+        ++s_num_failures;
+    }
+}
+
+int main() {
+    unsigned int trial;
+    double w;
+
+    srand(1);
+    printf("SIMD level of this machine: %s\n", LEVEL_NAMES[CpuFeatures::get_simd_level()]);
+
+    for (trial = 0; trial < NUM_TRIALS; ++trial) {
+        // Every third one is projective, and every other one has a scaled origin
+        w = trial % 3 != 0 ? 0.0 : random_coord() * 0.01;
+        Transformation t(
+            Vector4d(random_coord(), random_coord(), random_coord(), w),
+            Vector4d(random_coord(), random_coord(), random_coord(), 0.0),
+            Vector4d(random_coord(), random_coord(), random_coord(), 0.0),
+            Vector4d(random_coord(), random_coord(), random_coord(), trial % 2 != 0 ? 1.0 : random_coord()));
+        test_batch(t, trial % (MAX_COUNT + 1));
+
+        // The inverse transpose only keeps normals perpendicular under the linear part
+        Transformation linear(Vector3d(t.m_xaxis), Vector3d(t.m_yaxis), Vector3d(t.m_zaxis));
+        test_normal_perpendicular(linear);
+    }
+
+    if (s_num_failures == 0)
+        printf("passed\n");
+    else
+        printf("%u failures\n", s_num_failures);
+    return s_num_failures == 0 ? 0 : 1;
+}
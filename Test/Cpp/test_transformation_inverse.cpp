@@ -0,0 +1,126 @@
+/*
+ * ---------------------------------------------------------------------------------------------------------------------
+ *
+ * Copyright (C) 2018, Anton Synytsia
+ *
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+
+// Checks that Geom::Transformation classifies rigid, uniform, affine, and projective transformations, and that the
+// inverse and normal transformation chosen for each kind agree with the general 4x4 inverse, on random
+// transformations of each kind, mirrored or not, and with or without a scaled origin.
+
+#include "geom_transformation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Geom;
+
+static const unsigned int NUM_TRIALS = 100000; // per kind
+static const double MAX_RELATIVE_DIFF = 1.0e-12;
+
+static const char* const KIND_NAMES[] = { "rigid", "uniform", "affine", "projective" };
+
+static unsigned int s_num_failures = 0;
+
+static double random_unit() {
+    return static_cast<double>(rand()) / static_cast<double>(RAND_MAX) * 2.0 - 1.0;
+}
+
+// The largest difference between two matrices, relative to the largest entry of the second one, or absolute where
+// the entries are below one
+static double get_max_diff(const Transformation& a, const Transformation& b) {
+    double diff, max_diff = 0.0, max_entry = 1.0;
+    int i, j;
+    for (i = 0; i < 4; ++i) {
+        for (j = 0; j < 4; ++j) {
+            diff = fabs(a[i][j] - b[i][j]);
+            if (diff > max_diff)
+                max_diff = diff;
+            if (fabs(b[i][j]) > max_entry)
+                max_entry = fabs(b[i][j]);
+        }
+    }
+    return max_diff / max_entry;
+}
+
+static Transformation make_random(Transformation::KIND kind) {
+    Vector3d axis(random_unit(), random_unit(), random_unit());
+    axis.normalize_self();
+    Transformation rotation(Transformation::rotate(axis, random_unit() * 3.0));
+    double scale = kind == Transformation::KIND_RIGID ? 1.0 : 0.001 + fabs(random_unit()) * 50.0;
+    double zscale = rand() % 2 != 0 ? scale : -scale;
+    Transformation t(
+        Vector3d(rotation.m_xaxis) * scale,
+        Vector3d(rotation.m_yaxis) * scale,
+        Vector3d(rotation.m_zaxis) * zscale,
+        Vector3d(random_unit() * 1000.0, random_unit() * 1000.0, random_unit() * 1000.0));
+    if (kind == Transformation::KIND_AFFINE) {
+        t.m_xaxis.m_y += random_unit();
+        t.m_zaxis.m_x *= 3.0;
+    }
+    else if (kind == Transformation::KIND_PROJECTIVE)
+        t.m_xaxis.m_w = random_unit() * 0.01;
+    if (rand() % 4 == 0)
+        t.m_origin.m_w = 0.5 + fabs(random_unit());
+    return t;
+}
+
+static bool is_kind_expected(Transformation::KIND actual, Transformation::KIND made) {
+    // A uniform scale may come out as one by chance
+    if (made == Transformation::KIND_UNIFORM)
+        return actual == Transformation::KIND_UNIFORM || actual == Transformation::KIND_RIGID;
+    return actual == made;
+}
+
+static void test_kind(Transformation::KIND kind) {
+    unsigned int i, num_misclassified = 0;
+    double diff, worst_inverse = 0.0, worst_normal = 0.0;
+
+    for (i = 0; i < NUM_TRIALS; ++i) {
+        Transformation t(make_random(kind));
+        if (!is_kind_expected(t.get_kind(), kind))
+            ++num_misclassified;
+
+        diff = get_max_diff(t.inverse(), t.inverse_general());
+        if (diff > worst_inverse)
+            worst_inverse = diff;
+
+        diff = get_max_diff(t.get_normal_transformation(), t.get_normal_transformation(Transformation::KIND_AFFINE));
+        if (diff > worst_normal)
+            worst_normal = diff;
+    }
+
+    printf("%-10s misclassified %u, max relative diff: inverse %.3g, normal transformation %.3g\n",
+        KIND_NAMES[kind], num_misclassified, worst_inverse, worst_normal);
+    if (num_misclassified != 0 || worst_inverse > MAX_RELATIVE_DIFF || worst_normal > MAX_RELATIVE_DIFF) {
+        printf("FAILED %s\n", KIND_NAMES[kind]);
+        ++s_num_failures;
+    }
+}
+
+// A singular transformation gives the same result through either path
+static void test_singular() {
+    Transformation t;
+    t.zero_out();
+    if (get_max_diff(t.inverse(), t.inverse_general()) != 0.0) {
+        printf("FAILED singular: inverse differs from the general inverse\n");
+        ++s_num_failures;
+    }
+}
+
+int main() {
+    int kind;
+
+    srand(1);
+    for (kind = Transformation::KIND_RIGID; kind <= Transformation::KIND_PROJECTIVE; ++kind)
+        test_kind(static_cast<Transformation::KIND>(kind));
+    test_singular();
+
+    if (s_num_failures == 0)
+        printf("passed\n");
+    else
+        printf("%u failures\n", s_num_failures);
+    return s_num_failures == 0 ? 0 : 1;
+}